@@ -64,7 +64,7 @@
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)15360)
+#define configTOTAL_HEAP_SIZE                    ((size_t)24576)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_TRACE_FACILITY                 1
 #define configUSE_16_BIT_TICKS                   0
@@ -156,6 +156,14 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+//the run time of the tasks, printed by profileReport(), is counted with the DWT cycle counter by profile.c
+#define configGENERATE_RUN_TIME_STATS            1
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  void profileInitRunTime(void);
+  uint32_t profileRunTime(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() profileInitRunTime()
+#define portGET_RUN_TIME_COUNTER_VALUE()         profileRunTime()
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -10,8 +10,16 @@
 
 #include "render/render.h"
 #include "render/screen.h"
+#include "platform/platform.h"
 #include "FreeRTOS.h"
-#include "semphr.h"
+#include "task.h"
+
+//milliseconds the exit screen is shown before the next map is loaded
+#define EXIT_SCREEN_MS 3000
+//world units covered by a step of the player
+#define PLAYER_SPEED (MAP_BLOCK_SIZE / 8.0f)
+//world units the player keeps from the walls
+#define PLAYER_MARGIN (MAP_BLOCK_SIZE / 5)
 
 typedef struct {
 	vec2 pos;
@@ -19,15 +27,23 @@ typedef struct {
 	float dx;
 	float dy;
 	float angle;
-	SemaphoreHandle_t *player_pos_mut;
 } Player;
 
+//state of the game: it is advanced by a single task, the others work on copies of it
+typedef struct {
+	Player player;
+	Map map;
+	int exitCountdown; //milliseconds left before the next map once the exit has been reached, 0 while playing
+} GameState;
+
 void showStartScreen(Screen *s, bool show);
 void showPauseScreen(Screen *s, bool show);
-void playerMovementTouch(Player *p, Map *m, Screen *s, int scale);
+int playerTouchCommands(Screen *s, int scale, const PlatformTouch *touch, char *commands);
 void playerMovementKeyboard(Player *p, Map *m, char command);
-void drawMapPlayer(Player *p);
-void gameLogic(Player *p, Map *m, Screen *s);
+void drawMapPlayer(Player *p, Map *m, Screen *s);
+void gameReset(GameState *g);
+void gameLogic(GameState *g, int elapsedMs);
+void showExitScreen(Screen *s, int exitCountdown);
 
 extern TaskHandle_t flashing_text_task_handle;
 
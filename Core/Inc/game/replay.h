@@ -0,0 +1,65 @@
+/*
+ * replay.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_GAME_REPLAY_H_
+#define INC_GAME_REPLAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Recordings of the movement commands of the player, replayed to run the same walk again.
+ *
+ * An event is a command of playerMovementKeyboard() and the number of the simulation step it was applied in,
+ * counted from gameReset(). The touch controls are turned into the same commands, so a recording replayed
+ * from gameReset() with the same step length moves the player exactly as the recorded run did, on the board
+ * and on the host alike.
+ *
+ * The text form is a line per step with commands, or per range of steps with the same commands, and the
+ * length of the recording at the end; it is written and read by the console and by the host tools:
+ *
+ *   # comment
+ *   12 w         the step 12 moves the player forward
+ *   20-31 wd     every step from 20 to 31 moves it forward, then rotates it clockwise
+ *   end 400      the recording lasts 400 steps
+ */
+
+//events of a recording, 4 bytes each: 100 seconds of a held key at 40 steps per second
+#define REPLAY_MAX_EVENTS 4096
+//commands applied in a single step, the rest are not recorded
+#define REPLAY_STEP_COMMANDS 8
+//the commands a recording can hold
+#define REPLAY_COMMANDS "wasd"
+//longest line of the text form, terminator included: it fits a line of the console
+#define REPLAY_LINE_SIZE 40
+
+typedef struct {
+	uint32_t events[REPLAY_MAX_EVENTS]; //step << 8 | command, in order of step
+	uint32_t count;
+	uint32_t steps; //length of the recording, valid once complete
+	bool complete; //the length has been set, by replayStop() or by the end line of the text
+	bool overflow; //some commands didn't fit and have not been recorded
+} Recording;
+
+typedef enum {
+	REPLAY_LINE_OK, //an event line, a comment or a blank line
+	REPLAY_LINE_END, //the end line: the recording is complete
+	REPLAY_LINE_ERROR
+} ReplayLine;
+
+//a recording of a walk from the start of the first map to its exit, then through the exit screen, in flash
+extern const char replayDemo[];
+
+void replayClear(Recording *r);
+bool replayAdd(Recording *r, uint32_t step, char command);
+void replayStop(Recording *r, uint32_t steps);
+int replayCommands(const Recording *r, uint32_t *cursor, uint32_t step, char *commands);
+ReplayLine replayParseLine(Recording *r, const char *line);
+bool replayParse(Recording *r, const char *text);
+void replayWrite(const Recording *r, void (*print)(const char *line));
+
+#endif /* INC_GAME_REPLAY_H_ */
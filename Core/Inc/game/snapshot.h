@@ -0,0 +1,31 @@
+/*
+ * snapshot.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_GAME_SNAPSHOT_H_
+#define INC_GAME_SNAPSHOT_H_
+
+#include <stdint.h>
+
+/*
+ * Lock-free hand over of a value from a task to the others.
+ *
+ * A single task publishes a new value with snapshotWrite(), any number of tasks copy the latest one with
+ * snapshotRead(); none of them ever blocks on a mutex. The value is guarded by the sequence lock of
+ * platform/seqlock.h, so the writer must have at least the priority of the readers.
+ */
+
+typedef struct {
+	volatile uint32_t seq; //number of writes started plus number of writes completed
+	void *value; //storage of the value, size bytes
+	uint32_t size;
+} Snapshot;
+
+void snapshotInit(Snapshot *s, void *storage, uint32_t size, const void *initial);
+void snapshotWrite(Snapshot *s, const void *value);
+void snapshotRead(Snapshot *s, void *value);
+
+#endif /* INC_GAME_SNAPSHOT_H_ */
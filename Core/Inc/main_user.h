@@ -17,8 +17,8 @@
 /* Public define -------------------------------------------------------------*/
 
 /* Public variables ----------------------------------------------------------*/
-extern TaskHandle_t uart_rx_task_handler;
 extern TaskHandle_t button_task_handler;
+extern TaskHandle_t input_task_handler;
 /* Public function prototypes ------------------------------------------------*/
 void freeRTOS_user_init(void);
 void secondElapsed();
@@ -0,0 +1,77 @@
+/*
+ * platform.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_PLATFORM_PLATFORM_H_
+#define INC_PLATFORM_PLATFORM_H_
+
+#include "render/pixel.h"
+#include <stdint.h>
+
+/*
+ * Board services used by the renderer and by the game logic.
+ *
+ * render.c and game.c draw, read the touch panel and hand their pixels to the display only through these
+ * functions, so the same sources build for the board and for the host. There are two backends:
+ * - platform_bsp.c, on the STM32F769I-DISCO: the BSP LCD driver draws into the back buffer of screen.c,
+ *   fills and text go through the DMA2D job queue of blit.c;
+ * - Host/platform_host.c, on Linux: a software renderer draws into the back buffer of Host/screen_host.c,
+ *   which keeps its frame buffers in the heap and can dump them as PPM images.
+ *
+ * Drawing always targets the back buffer got with ct_screen_wait_backbuffer(). Colors are ARGB8888, text
+ * is drawn with the 17x24 pixel Font24 of the BSP on both backends, from the glyph cache of render/text.h;
+ * platformDrawStringPerPixel() is the DrawChar() of the BSP, kept to compare the two.
+ *
+ * platformCycles() is the free running counter used to time the code: the DWT cycle counter of the M7 on the
+ * board, a nanosecond clock on the host. It wraps around, so only differences of two readings make sense.
+ */
+
+//the colors of the BSP used by the game, with the same values of the LCD_COLOR_* ones
+#define COLOR_BLUE ((uint32_t)0xFF0000FF)
+#define COLOR_GREEN ((uint32_t)0xFF00FF00)
+#define COLOR_DARKBLUE ((uint32_t)0xFF000080)
+#define COLOR_DARKRED ((uint32_t)0xFF800000)
+#define COLOR_DARKYELLOW ((uint32_t)0xFF808000)
+#define COLOR_WHITE ((uint32_t)0xFFFFFFFF)
+#define COLOR_DARKGRAY ((uint32_t)0xFF404040)
+#define COLOR_BLACK ((uint32_t)0xFF000000)
+#define COLOR_BROWN ((uint32_t)0xFFA52A2A)
+#define COLOR_ORANGE ((uint32_t)0xFFFFA500)
+//as back color, the text is drawn over whatever is under it
+#define COLOR_TRANSPARENT ((uint32_t)0x00000000)
+
+//horizontal alignment of a string, as the Text_AlignModeTypdef of the BSP
+typedef enum {
+	PLATFORM_ALIGN_CENTER, //centered on the screen, then moved right by x
+	PLATFORM_ALIGN_RIGHT, //ending x pixels before the right edge of the screen
+	PLATFORM_ALIGN_LEFT //starting at x
+} PlatformAlign;
+
+//state of the touch panel
+typedef struct {
+	uint8_t count; //number of touches detected, 0 to 2
+	uint16_t x[2];
+	uint16_t y[2];
+	uint32_t stamp; //platformCycles() when the state was sampled, or when the panel signalled it
+} PlatformTouch;
+
+void platformSetTextColor(uint32_t color);
+void platformSetBackColor(uint32_t color);
+void platformClear(uint32_t color);
+void platformFillRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+void platformDrawRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+void platformDrawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+void platformDrawPixel(uint16_t x, uint16_t y, uint32_t color);
+void platformDrawString(uint16_t x, uint16_t y, const char *text, PlatformAlign align);
+void platformDrawStringPerPixel(uint16_t x, uint16_t y, const char *text, PlatformAlign align);
+void platformGetTouch(PlatformTouch *touch);
+pixel_t* platformDrawBuffer(void);
+void platformFlushPixels(void);
+void platformWaitDrawing(void);
+uint32_t platformCycles(void);
+uint32_t platformCyclesPerUs(void);
+
+#endif /* INC_PLATFORM_PLATFORM_H_ */
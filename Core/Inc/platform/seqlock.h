@@ -0,0 +1,82 @@
+/*
+ * seqlock.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_PLATFORM_SEQLOCK_H_
+#define INC_PLATFORM_SEQLOCK_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Sequence lock: data written by a single task is read by others without ever blocking the writer.
+ *
+ * The writer wraps every update in seqlockWriteBegin() and seqlockWriteEnd(), which keep the sequence number
+ * odd while the data changes. A reader copies the data between seqlockReadBegin() and seqlockReadRetry() and
+ * copies it again while the latter returns true:
+ *
+ *   do
+ *   {
+ *       seq = seqlockReadBegin(&data->seq);
+ *       copy = data->value;
+ *   } while(seqlockReadRetry(&data->seq, seq));
+ *
+ * It is used by the snapshots of game/snapshot.h and by the zones of profile.c. Writers, readers and the
+ * interrupts all run on the single core of the M7, so the order of the accesses chosen by the compiler is the
+ * order seen by the other side: compilerBarrier() is all the ordering needed, here and on the rings of uart.c.
+ */
+
+//keeps the compiler from moving memory accesses across it
+#define compilerBarrier() __asm volatile("" ::: "memory")
+
+/**
+  * @brief  Starts an update of the data guarded by a sequence number
+  */
+static inline void seqlockWriteBegin(volatile uint32_t *seq)
+{
+	(*seq)++;
+	compilerBarrier();
+}
+
+/**
+  * @brief  Completes an update started by seqlockWriteBegin()
+  */
+static inline void seqlockWriteEnd(volatile uint32_t *seq)
+{
+	compilerBarrier();
+	(*seq)++;
+}
+
+/**
+  * @return the sequence number to be passed to seqlockReadRetry() after the copy of the data
+  */
+static inline uint32_t seqlockReadBegin(const volatile uint32_t *seq)
+{
+	uint32_t start = *seq;
+	compilerBarrier();
+	return start;
+}
+
+/**
+  * @param  seq : The sequence number
+  * @param  start : The value returned by seqlockReadBegin()
+  * @return true if the data has been copied while the writer was updating it and must be copied again
+  */
+static inline bool seqlockReadRetry(const volatile uint32_t *seq, uint32_t start)
+{
+	compilerBarrier();
+	if(!(start & 1) && start == *seq)
+		return false;
+	//the reader has preempted the writer in the middle of an update: the writer must run before a copy can succeed,
+	//which only works if it has at least the priority of the reader
+	if(start & 1)
+		taskYIELD();
+	return true;
+}
+
+#endif /* INC_PLATFORM_SEQLOCK_H_ */
@@ -0,0 +1,42 @@
+/*
+ * frametime.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_PROFILE_FRAMETIME_H_
+#define INC_PROFILE_FRAMETIME_H_
+
+#include <stdint.h>
+
+/*
+ * Frame times of the last FRAMETIME_SAMPLES frames.
+ *
+ * frameTimeMark() is called once per frame, when the frame is queued for display: the time elapsed since
+ * the previous call, in microseconds from platformCycles(), is stored in a ring buffer. The statistics are
+ * computed on the whole ring, so a single slow frame shows up in the 1% low and in the maximum for a few
+ * seconds rather than being averaged away. Everything must be called by the same task.
+ */
+
+//frames kept in the ring: about 4 seconds at 60 fps
+#define FRAMETIME_SAMPLES 256
+//the frame time graph: a 1 pixel bar for every frame of the ring, a pixel of height for every FRAMETIME_GRAPH_US
+#define FRAMETIME_GRAPH_WIDTH FRAMETIME_SAMPLES
+#define FRAMETIME_GRAPH_HEIGHT 64
+#define FRAMETIME_GRAPH_US 500
+
+typedef struct {
+	uint32_t frames; //frames in the ring
+	uint32_t avgFps; //frames per second over the whole ring
+	uint32_t lowFps; //1% low: frames per second of the slowest 1% of the frames
+	uint32_t maxUs; //longest frame time
+} FrameTimeStats;
+
+void frameTimeMark(void);
+void frameTimeReset(void);
+uint32_t frameTimeLast(void);
+void frameTimeGetStats(FrameTimeStats *stats);
+void frameTimeDrawGraph(uint16_t x, uint16_t y);
+
+#endif /* INC_PROFILE_FRAMETIME_H_ */
@@ -0,0 +1,84 @@
+/*
+ * profile.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_PROFILE_PROFILE_H_
+#define INC_PROFILE_PROFILE_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdint.h>
+
+/*
+ * Profiler of the main loop, readable from the serial console.
+ *
+ * The code between PROFILE_SCOPE(zone) { and } is timed with platformCycles(), the DWT cycle counter, and
+ * accumulated in the statistics of the zone: count, total and maximum time and a histogram of the times.
+ * A zone must be written by a single task, the statistics are read by profileReport() from any other
+ * task without stopping the writer: each zone has a sequence number which is odd while the writer updates
+ * it, the reader copies the zone again if it changed in the meantime.
+ *
+ * profileReport() prints the statistics collected since the previous report, the share of CPU time used by
+ * every task since the previous report and the minimum free stack of every task. The run time of the tasks
+ * is counted by the kernel with profileRunTime() (configGENERATE_RUN_TIME_STATS in FreeRTOSConfig.h).
+ * profileSampleTasks() takes the same task statistics for other consumers, e.g. the telemetry.
+ */
+
+//zones of the render task, the input task and the simulation task
+typedef enum {
+	PROFILE_FRAME, //a whole iteration of the main loop
+	PROFILE_INPUT, //platformGetTouch() in the input task
+	PROFILE_CAST, //castRays()
+	PROFILE_WAIT, //ct_screen_wait_backbuffer(): waiting for a free buffer
+	PROFILE_WALLS, //drawRays()
+	PROFILE_HUD, //composition of the overlays, rays and player on the minimap
+	PROFILE_LOGIC, //a step of the simulation task
+	PROFILE_TOUCH, //latency from the touch panel interrupt to the simulation step moving the player
+	PROFILE_MENU, //start and pause screens
+	PROFILE_FLIP, //waiting for the DMA2D and queuing the frame
+	PROFILE_ZONES
+} ProfileZone;
+
+//buckets of the histograms: bucket 0 counts the times below 1024 cycles, every other bucket doubles the bound
+//of the previous one, the last one counts everything above
+#define PROFILE_BUCKETS 16
+#define PROFILE_BUCKET_SHIFT 10
+//the run time counter of the kernel ticks every 2^PROFILE_RUN_TIME_SHIFT cycles: it wraps after 85 minutes
+#define PROFILE_RUN_TIME_SHIFT 8
+//maximum number of tasks sampled by profileSampleTasks() and listed by profileReport()
+#define PROFILE_MAX_TASKS 12
+
+typedef struct {
+	const char *name;
+	UBaseType_t number; //the number given by the kernel, unique for every task
+	uint32_t runTime; //run time since the previous sample, in ticks of the run time counter
+	uint32_t stackFree; //minimum free stack ever, in words
+} ProfileTask;
+
+//the tasks at the last sample and the run time counters of the previous one
+typedef struct {
+	UBaseType_t count;
+	uint32_t totalRunTime; //sum of the run time of the tasks since the previous sample
+	ProfileTask task[PROFILE_MAX_TASKS];
+	TaskStatus_t status[PROFILE_MAX_TASKS];
+	UBaseType_t previousNumbers[PROFILE_MAX_TASKS];
+	uint32_t previousRunTimes[PROFILE_MAX_TASKS];
+	UBaseType_t previousCount;
+} ProfileTasks;
+
+//times the following statement or block as zone, the block must not be left with break, continue or return
+#define PROFILE_SCOPE(zone) \
+	for(uint32_t profileStart = profileBegin(), profileOnce = 1; profileOnce; profileOnce = 0, profileEnd(zone, profileStart))
+
+uint32_t profileBegin(void);
+void profileEnd(ProfileZone zone, uint32_t start);
+uint32_t profileLast(ProfileZone zone);
+void profileReport(void (*print)(const char *line));
+void profileSampleTasks(ProfileTasks *tasks);
+void profileInitRunTime(void);
+uint32_t profileRunTime(void);
+
+#endif /* INC_PROFILE_PROFILE_H_ */
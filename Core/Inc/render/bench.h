@@ -0,0 +1,105 @@
+/*
+ * bench.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_BENCH_H_
+#define INC_RENDER_BENCH_H_
+
+#include "render/render.h"
+#include <stddef.h>
+
+/*
+ * Deterministic benchmark of the renderer.
+ *
+ * benchRun() replays the same camera path through every map of map.c and times each stage of a frame
+ * separately with platformCycles(), so the numbers of the board and of the host build can be compared run
+ * after run. The camera visits the empty blocks of the map in order, standing in the middle of each one,
+ * while it turns around BENCH_TURNS times along the path: every frame is a valid view with walls at all
+ * distances. Nothing else must draw on the screen while it runs.
+ *
+ * benchMazes() measures how the renderer scales with the size of the map: it replays the camera path through
+ * braided mazes of render/maze.h from BENCH_MAZE_SIZES sides, the same seed every time, once with the cutoff of
+ * the rays of raycastSetMaxBlocks() and once without.
+ *
+ * benchText() compares the ways of drawing text: it draws the same strings, as long as the fps counter, with the
+ * per pixel DrawChar() of the BSP and with the glyph cache of render/text.h, on an opaque and on a transparent
+ * background. A string is timed until its pixels are in the frame buffer, the DMA2D jobs included.
+ */
+
+//frames drawn on every map
+#define BENCH_FRAMES_PER_MAP 120
+//full turns of the camera along the path of a map
+#define BENCH_TURNS 4
+#define BENCH_FRAMES (BENCH_FRAMES_PER_MAP * MAP_COUNT)
+
+//the stages of a frame timed by the benchmark
+typedef enum {
+	BENCH_CAST, //castRays()
+	BENCH_WALLS, //drawRays(): walls, ceiling and floor, which are drawn column by column with them
+	BENCH_MAP, //drawMap()
+	BENCH_MAP_RAYS, //drawMapRays() in the style of getMapRaysStyle()
+	BENCH_TEXT, //platformDrawString() of a line as long as the fps counter
+	BENCH_STAGES
+} BenchStage;
+
+typedef struct {
+	uint32_t min; //all in platformCycles() cycles
+	uint32_t median;
+	uint32_t p99;
+} BenchTiming;
+
+typedef struct {
+	Resolution res; //resolution the frames have been drawn at
+	MapRaysStyle mapRays; //style of the rays on the map
+	uint32_t frames;
+	uint32_t cyclesPerUs; //platformCyclesPerUs() of the run
+	BenchTiming stage[BENCH_STAGES];
+	BenchTiming frame; //sum of the stages of a frame
+} BenchReport;
+
+//number of maze sizes of benchMazes(), 16 to 256 blocks of side, and seed of the mazes
+#define BENCH_MAZE_SIZES 5
+#define BENCH_MAZE_SEED 1
+
+typedef struct {
+	int size; //blocks of a side of the maze
+	BenchTiming cast; //castRays() with the cutoff
+	BenchTiming castUncut; //castRays() without the cutoff
+	BenchTiming frame; //the whole frame with the cutoff
+} BenchMazeRow;
+
+typedef struct {
+	Resolution res;
+	int maxBlocks; //cutoff of the rays, see raycastSetMaxBlocks()
+	uint32_t frames; //frames drawn on every maze, with and without the cutoff
+	uint32_t cyclesPerUs;
+	BenchMazeRow row[BENCH_MAZE_SIZES];
+} BenchMazeReport;
+
+//strings drawn by every method of benchText()
+#define BENCH_TEXT_STRINGS 240
+
+typedef enum {
+	BENCH_TEXT_PER_PIXEL, //platformDrawStringPerPixel()
+	BENCH_TEXT_GLYPHS, //platformDrawString() on the back color
+	BENCH_TEXT_TRANSPARENT, //platformDrawString() on COLOR_TRANSPARENT
+	BENCH_TEXT_METHODS
+} BenchTextMethod;
+
+typedef struct {
+	uint32_t strings; //strings drawn by every method
+	uint32_t cyclesPerUs;
+	BenchTiming method[BENCH_TEXT_METHODS];
+} BenchTextReport;
+
+void benchRun(Screen *s, BenchReport *report);
+int benchFormat(const BenchReport *report, char *text, size_t size);
+bool benchMazes(Screen *s, BenchMazeReport *report);
+int benchMazesFormat(const BenchMazeReport *report, char *text, size_t size);
+void benchText(Screen *s, BenchTextReport *report);
+int benchTextFormat(const BenchTextReport *report, char *text, size_t size);
+
+#endif /* INC_RENDER_BENCH_H_ */
@@ -0,0 +1,70 @@
+/*
+ * blit.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_BLIT_H_
+#define INC_RENDER_BLIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DMA2D job queue.
+ *
+ * Fills, copies, alpha replacements and blends of A8 masks are pushed in a ring and started one after the other by the DMA2D transfer complete
+ * interrupt, so the task that submits them goes on with its work while the DMA2D draws. Every submitted
+ * job gets a sequence number: ct_blit_fence() returns the one of the last job and ct_blit_wait() blocks
+ * until the job with that number has been completed. Only one task at a time can wait on a fence.
+ *
+ * The CPU must not touch the pixels written by a job before its fence has been reached.
+ *
+ * Pixels, widths and offsets are in the pixel format of the frame buffers (render/pixel.h) and colors are
+ * given as ARGB8888. The DMA2D can't write L8, so in that format a job is executed on pairs of pixels as
+ * RGB565 when the rectangle allows it, and by the CPU otherwise; blends are always executed by the CPU in L8.
+ *
+ * Compiling with BLIT_MOCK replaces the DMA2D with a software implementation: jobs are executed one at a
+ * time by ct_blit_mock_step(), which also plays the part of the interrupt, so the order in which jobs are
+ * completed can be tested deterministically on the host.
+ */
+
+//number of jobs that can be queued, a submit waits for a free slot when the ring is full
+#define BLIT_QUEUE_SIZE 32
+
+typedef enum {
+	BLIT_FILL, //register to memory: fills a rectangle with a color
+	BLIT_COPY, //memory to memory: copies a rectangle without pixel format conversion
+	BLIT_SET_ALPHA, //memory to memory with pixel format conversion, in place: replaces the alpha of a rectangle, ARGB8888 only
+	BLIT_BLEND_A8 //memory to memory with blending: paints a color through an A8 mask over a rectangle
+} BlitOp;
+
+typedef struct {
+	BlitOp op;
+	uintptr_t src; //address of the first source pixel, BLIT_COPY and BLIT_BLEND_A8 only
+	uint32_t srcOffset; //pixels skipped at the end of every source line, BLIT_COPY and BLIT_BLEND_A8 only
+	uintptr_t dst; //address of the first destination pixel
+	uint32_t dstOffset; //pixels skipped at the end of every destination line
+	uint32_t width;
+	uint32_t height;
+	uint32_t format; //DMA2D color mode of src and dst
+	uint32_t color; //color in the format of dst, BLIT_FILL only, the alpha in the top byte, BLIT_SET_ALPHA only, or ARGB8888, BLIT_BLEND_A8 only
+} BlitJob;
+
+void ct_blit_init(void);
+uint32_t ct_blit_fill(void *dst, uint32_t width, uint32_t height, uint32_t dstOffset, uint32_t color);
+uint32_t ct_blit_copy(const void *src, uint32_t srcOffset, void *dst, uint32_t dstOffset, uint32_t width, uint32_t height);
+uint32_t ct_blit_set_alpha(void *dst, uint32_t width, uint32_t height, uint32_t dstOffset, uint8_t alpha);
+uint32_t ct_blit_blend_a8(const uint8_t *mask, uint32_t maskOffset, void *dst, uint32_t dstOffset, uint32_t width, uint32_t height, uint32_t color);
+uint32_t ct_blit_fence(void);
+uint32_t ct_blit_errors(void);
+bool ct_blit_done(uint32_t fence);
+void ct_blit_wait(uint32_t fence);
+void ct_blit_irq_handler(void);
+
+#ifdef BLIT_MOCK
+bool ct_blit_mock_step(void);
+#endif
+
+#endif /* INC_RENDER_BLIT_H_ */
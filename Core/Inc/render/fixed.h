@@ -0,0 +1,37 @@
+/*
+ * fixed.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_FIXED_H_
+#define INC_RENDER_FIXED_H_
+
+#include <stdint.h>
+
+//Q16.16 fixed point numbers: the upper 16 bits hold the integer part, the lower 16 bits the fractional part
+typedef int32_t fixed;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE (1 << FIXED_SHIFT)
+#define FIXED_HALF (1 << (FIXED_SHIFT - 1))
+
+#define FIXED_FROM_INT(i) ((fixed)((i) * FIXED_ONE))
+#define FIXED_FROM_FLOAT(f) ((fixed)((f) * FIXED_ONE))
+#define FIXED_TO_INT(x) ((x) >> FIXED_SHIFT)
+#define FIXED_TO_FLOAT(x) ((float)(x) / FIXED_ONE)
+
+/**
+  * @brief  Multiplies two Q16.16 numbers
+  * @note   The intermediate product is kept on 64 bits, on the Cortex-M7 this is a single SMULL
+  * @param  a : The first factor
+  * @param  b : The second factor
+  * @return a*b in Q16.16
+  */
+static inline fixed fixedMul(fixed a, fixed b)
+{
+	return (fixed)(((int64_t)a * b) >> FIXED_SHIFT);
+}
+
+#endif /* INC_RENDER_FIXED_H_ */
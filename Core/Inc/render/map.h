@@ -8,15 +8,118 @@
 #ifndef INC_RENDER_MAP_H_
 #define INC_RENDER_MAP_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+/*
+ * A map is a grid of blocks, a byte each holding the index of its material in the materials table.
+ *
+ * The blocks are stored with a border of BLOCK_WALL blocks all around the map, so the blocks from -1 to
+ * mapBlockX and from -1 to mapBlockY can always be read: a ray or the player starting inside the map meets a
+ * solid block before leaving it and no bounds check is needed. The rows are padded to a power of two, so the
+ * address of a block is a shift and an add, and so is the block of a position: a block is MAP_BLOCK_SIZE
+ * world units wide.
+ *
+ * The maps of map.c are written as rows of materials without the border; mapImport() copies such a grid
+ * into the padded storage and is the way in for any map kept in the old format. The maps built at run time
+ * start from mapInit(), a map of walls, and carve it.
+ */
+
+//number of maps defined in map.c, changeMap() goes back to the first one after the last
+#define MAP_COUNT 3
+//index of the maps built at run time, e.g. by mazeGenerate(), and number of indexes of a map
+#define MAP_GENERATED MAP_COUNT
+#define MAP_SLOTS (MAP_COUNT + 1)
+//size of a block in world units: the block of a position is the position shifted right by MAP_BLOCK_SHIFT
+#define MAP_BLOCK_SHIFT 6
+#define MAP_BLOCK_SIZE (1 << MAP_BLOCK_SHIFT)
+
+//flags of a material
+#define MATERIAL_OPAQUE 0x01 //it stops the rays, it is drawn as a wall
+#define MATERIAL_SOLID 0x02 //it stops the player
+#define MATERIAL_EXIT 0x04 //the player reaching it completes the map
+
+//the values of the blocks: their index in the materials table
+typedef enum {
+	BLOCK_FLOOR,
+	BLOCK_WALL,
+	BLOCK_EXIT, //the final wall, the player walks into it to reach the exit
+	MATERIAL_COUNT
+} BlockId;
 
 typedef struct {
-	int mapBlockX; //number of blocks in a row of the map
-	int mapBlockY; //the number of row in a map
-	int blockSize; //the width and height of a block in pixel
-	int *map; //the actual map
+	uint32_t mapColor; //ARGB8888 color of the block on the minimap
+	uint32_t lightColor; //ARGB8888 color of the flat walls hit by a vertical ray
+	uint32_t darkColor; //ARGB8888 color of the flat walls hit by a horizontal ray
+	uint8_t texture; //TextureId of render/texture.h of the walls
+	uint8_t flags;
+} Material;
+
+typedef struct {
+	int mapBlockX; //number of blocks in a row of the map, the border excluded
+	int mapBlockY; //the number of row in a map, the border excluded
+	uint8_t *blocks; //the block (0, 0): the rows are 1 << pitchShift bytes apart, the border is around it
+	uint32_t pitchShift;
+	int index; //the number of the map in map.c, MAP_GENERATED for the maps built at run time
+	uint32_t revision; //changes every time a block of the map is changed, with setMapBlock()
 } Map;
 
+extern const Material materials[MATERIAL_COUNT];
+
+/**
+  * @param  m : The map
+  * @param  x : The column of the block, from -1 to mapBlockX
+  * @param  y : The row of the block, from -1 to mapBlockY
+  * @return the address of a block, the next block of the row is at +1 and the one below at +(1 << pitchShift)
+  */
+static inline uint8_t* mapBlockPtr(const Map *m, int x, int y)
+{
+	//a multiplication by a power of two rather than a shift, which is undefined for the row -1; it compiles to a shift
+	return m->blocks + y * (1 << m->pitchShift) + x;
+}
+
+/**
+  * @return the material of a block, the column and the row go from -1 to mapBlockX and mapBlockY
+  */
+static inline uint8_t mapBlock(const Map *m, int x, int y)
+{
+	return *mapBlockPtr(m, x, y);
+}
+
+/**
+  * @return the material of the block holding a position in world units, which must be inside the map or its border
+  */
+static inline uint8_t mapBlockAt(const Map *m, float x, float y)
+{
+	//rounded down, so a position just left of or above the map is in the border
+	return mapBlock(m, (int)floorf(x) >> MAP_BLOCK_SHIFT, (int)floorf(y) >> MAP_BLOCK_SHIFT);
+}
+
+/**
+  * @return the flags of the material of the block holding a position in world units
+  */
+static inline uint8_t mapFlagsAt(const Map *m, float x, float y)
+{
+	return materials[mapBlockAt(m, x, y)].flags;
+}
+
+/**
+  * @return true if a block is in the map or in its border, so it can be read
+  */
+static inline bool mapContains(const Map *m, int x, int y)
+{
+	return x >= -1 && x <= m->mapBlockX && y >= -1 && y <= m->mapBlockY;
+}
 
 void changeMap(Map *m);
+void loadMap(Map *m, int index);
+void getMap(Map *m, int index);
+void importMaps(void);
+void setMapBlock(Map *m, int x, int y, uint8_t block);
+void mapChanged(Map *m);
+uint32_t mapStorageSize(int width, int height);
+void mapInit(Map *m, uint8_t *storage, int width, int height);
+void mapImport(Map *m, uint8_t *storage, const uint8_t *blocks, int width, int height);
 
 #endif /*INC_RENDER_MAP_H_*/
@@ -0,0 +1,42 @@
+/*
+ * maze.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_MAZE_H_
+#define INC_RENDER_MAZE_H_
+
+#include "render/map.h"
+#include <stdint.h>
+
+/*
+ * Mazes built at run time from a seed.
+ *
+ * The cells of a maze are the blocks with odd coordinates, the blocks between two cells are the walls that can
+ * be carved. The recursive backtracker walks from the cell (1, 1) to a random cell not visited yet and carves
+ * the wall between them, when it is stuck it goes back one cell; it needs no stack, every cell being carved
+ * holds the direction it has been entered from until the backtracker leaves it for good. The result is a
+ * perfect maze, a single path between any two cells. The braided maze then opens a wall of every dead end,
+ * towards another dead end if there is one, so the maze has loops and long corridors instead of dead ends.
+ *
+ * The same seed and size always give the same maze, on the board and on the host. The player starts in the
+ * cell (1, 1), facing right, the exit is the right wall of the last cell of the bottom row.
+ */
+
+//size of the mazes in blocks, a side of an even number of blocks has a wall of two blocks at its end
+#define MAZE_MIN_SIZE 5
+#define MAZE_MAX_SIZE 256
+//world coordinate, x and y, of the start of a maze: the middle of the block (1, 1)
+#define MAZE_START (MAP_BLOCK_SIZE + MAP_BLOCK_SIZE / 2)
+
+typedef enum {
+	MAZE_PERFECT, //recursive backtracker
+	MAZE_BRAIDED, //recursive backtracker without dead ends
+	MAZE_STYLES
+} MazeStyle;
+
+void mazeGenerate(Map *m, uint8_t *storage, int width, int height, uint32_t seed, MazeStyle style);
+
+#endif /* INC_RENDER_MAZE_H_ */
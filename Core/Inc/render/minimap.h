@@ -0,0 +1,47 @@
+/*
+ * minimap.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_MINIMAP_H_
+#define INC_RENDER_MINIMAP_H_
+
+#include "render/render.h"
+#include "render/pixel.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Images of the maps cached in the SDRAM.
+ *
+ * The first time a map is drawn its image is written by the CPU into a buffer of its own, a fill for the
+ * outline color and a fill for the inside of every block, then flushed; from then on drawing the map is a
+ * single DMA2D copy of the image. The image is drawn again only when the blocks of the map change: a Map
+ * with another block array or another revision (see setMapBlock()) than the ones of the image.
+ *
+ * There is a buffer for every map index, allocated once and as large as the image of the largest map the
+ * screen can show, so every map loaded with the same index, e.g. all the mazes of maze.h, reuses it.
+ *
+ * The image is the same drawMap() used to draw block by block with the BSP: a block is a xInc x yInc
+ * rectangle of its color with a one pixel outline, the outlines of two blocks next to each other overlap.
+ * The blocks of the large maps, 2 pixels or less, are drawn without outline.
+ */
+
+//color of the outline of the blocks
+#define MINIMAP_OUTLINE_COLOR COLOR_BLUE
+
+typedef struct {
+	pixel_t *image; //the map, rows of stride pixel
+	uint32_t stride; //a multiple of 8 bytes, as for the rows of the screen
+	uint32_t size; //pixel allocated for the image
+	Rect rect; //where the image goes on the screen, see getMapRect()
+	const uint8_t *blocks; //the blocks and their revision the image has been drawn with, NULL before the first time
+	uint32_t revision;
+	uint32_t fence; //of the last copy of the image, it must be done before the image is drawn again
+} MinimapCache;
+
+uint32_t minimapDraw(Map *m, Screen *s, pixel_t *dst);
+
+#endif /* INC_RENDER_MINIMAP_H_ */
@@ -0,0 +1,69 @@
+/*
+ * overlay.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_OVERLAY_H_
+#define INC_RENDER_OVERLAY_H_
+
+#include "render/screen.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Cached overlays with dirty tracking.
+ *
+ * An overlay is a set of opaque rectangles of the screen drawn on top of the 3D scene (the controls, the
+ * minimap grid, the FPS label). Its draw function is called only when the overlay is dirty, and it draws with
+ * the BSP into a full screen HUD cache in the SDRAM instead of the back buffer. Every frame the rectangles
+ * are then copied from the cache to the back buffer with one DMA2D job each, so a constant HUD costs a copy
+ * rather than a few dozen fills and the glyph blends of its text.
+ *
+ * The draw function must paint every pixel of the rectangles of its overlay, the cache is never cleared.
+ *
+ * In OVERLAY_LAYER mode the HUD cache is scanned out by the second LTDC layer on top of the 3D view, the LTDC
+ * blends the two layers so nothing is copied at all: the cache is filled with OVERLAY_KEY_COLOR, which the
+ * color keying of the layer turns transparent, and an overlay touches it only when it changes or is shown or
+ * hidden. An overlay can be made translucent with ct_overlay_set_alpha(), e.g. so that whatever is drawn under
+ * the minimap on the 3D view shows through it, with ARGB8888 frame buffers only. As the cache is on display
+ * while it is updated, a change can be seen half drawn for one refresh.
+ */
+
+//maximum number of overlays and of rectangles of an overlay
+#define OVERLAY_MAX 8
+#define OVERLAY_MAX_RECTS 4
+
+//color of the transparent pixels of the HUD layer, nothing in the HUD is drawn with it
+#define OVERLAY_KEY_COLOR ((uint32_t)0xFFFF00FF) //LCD_COLOR_MAGENTA
+
+typedef enum {
+	OVERLAY_COPY, //the overlays are copied on every frame by the DMA2D
+	OVERLAY_LAYER //the HUD cache is the second LTDC layer, composited by the LTDC at scan out
+} OverlayMode;
+
+typedef void (*OverlayDraw)(void);
+
+typedef struct {
+	OverlayDraw draw; //draws the overlay with the BSP at its screen coordinates
+	Rect rects[OVERLAY_MAX_RECTS]; //areas of the cache copied to the back buffer
+	uint32_t rectCount;
+	uint8_t alpha; //alpha of the overlay in OVERLAY_LAYER mode, 255 is opaque
+	bool dirty; //the cache doesn't hold the current content of the overlay
+	bool visible;
+	bool shown; //in OVERLAY_LAYER mode the overlay is in the cache, so it is on display
+} Overlay;
+
+void ct_overlay_init(Screen *s);
+int ct_overlay_add(OverlayDraw draw, const Rect *rects, uint32_t rectCount);
+void ct_overlay_set_rects(int id, const Rect *rects, uint32_t rectCount);
+void ct_overlay_invalidate(int id);
+void ct_overlay_set_visible(int id, bool visible);
+void ct_overlay_set_alpha(int id, uint8_t alpha);
+void ct_overlay_set_mode(OverlayMode mode);
+OverlayMode ct_overlay_get_mode(void);
+void ct_overlay_show_layer(bool show);
+void ct_overlay_composite(Screen *s);
+
+#endif /* INC_RENDER_OVERLAY_H_ */
@@ -0,0 +1,97 @@
+/*
+ * pixel.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_PIXEL_H_
+#define INC_RENDER_PIXEL_H_
+
+#include <stdint.h>
+
+/*
+ * Pixel format of the frame buffers, chosen at compile time with SCREEN_PIXEL_FORMAT.
+ *
+ * Colors are always given as ARGB8888 (the LCD_COLOR_* of the BSP) and converted with pixelFromArgb() where
+ * they are written. In PIXEL_FORMAT_L8 a pixel is an index in the CLUT of the LTDC layer, the CLUT is filled
+ * with the RGB332 palette so that an index is the RGB332 color itself and any color can be converted without
+ * a lookup; the handful of colors of the game are approximated to the nearest of the 256.
+ */
+
+//values of SCREEN_PIXEL_FORMAT
+#define PIXEL_FORMAT_ARGB8888 0
+#define PIXEL_FORMAT_RGB565 1
+#define PIXEL_FORMAT_L8 2
+
+#ifndef SCREEN_PIXEL_FORMAT
+#define SCREEN_PIXEL_FORMAT PIXEL_FORMAT_ARGB8888
+#endif
+
+//DMA2D color modes, the values of the CM fields of the OPFCCR and FGPFCCR registers
+#define PIXEL_DMA2D_ARGB8888 0x0
+#define PIXEL_DMA2D_RGB565 0x2
+
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_ARGB8888
+typedef uint32_t pixel_t;
+#define PIXEL_LTDC_FORMAT 0x0 //LTDC_PIXEL_FORMAT_ARGB8888
+#define PIXEL_DMA2D_FORMAT PIXEL_DMA2D_ARGB8888
+#elif SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_RGB565
+typedef uint16_t pixel_t;
+#define PIXEL_LTDC_FORMAT 0x2 //LTDC_PIXEL_FORMAT_RGB565
+#define PIXEL_DMA2D_FORMAT PIXEL_DMA2D_RGB565
+#elif SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_L8
+typedef uint8_t pixel_t;
+#define PIXEL_LTDC_FORMAT 0x5 //LTDC_PIXEL_FORMAT_L8
+//the DMA2D can't write L8: pairs of pixels are filled and copied as RGB565
+#define PIXEL_DMA2D_FORMAT PIXEL_DMA2D_RGB565
+#else
+#error "SCREEN_PIXEL_FORMAT must be PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_RGB565 or PIXEL_FORMAT_L8"
+#endif
+
+//bytes of a pixel
+#define PIXEL_BYTES sizeof(pixel_t)
+
+/**
+  * @brief  Converts an ARGB8888 color to the pixel format of the frame buffers
+  * @param  argb : The color
+  * @return the pixel
+  */
+static inline pixel_t pixelFromArgb(uint32_t argb)
+{
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_ARGB8888
+	return argb;
+#elif SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_RGB565
+	return ((argb >> 8) & 0xF800) | ((argb >> 5) & 0x07E0) | ((argb >> 3) & 0x001F);
+#else
+	return ((argb >> 16) & 0xE0) | ((argb >> 11) & 0x1C) | ((argb >> 6) & 0x03);
+#endif
+}
+
+/**
+  * @brief  Converts a pixel of the frame buffers to an opaque ARGB8888 color
+  * @note   Every component is widened by repeating its bits, as the LTDC does, so black, white and the
+  * 		saturated colors are exact.
+  * @param  pixel : The pixel
+  * @return the color
+  */
+static inline uint32_t pixelToArgb(pixel_t pixel)
+{
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_ARGB8888
+	return pixel | 0xFF000000;
+#elif SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_RGB565
+	uint32_t r = pixel >> 11, g = (pixel >> 5) & 0x3F, b = pixel & 0x1F;
+	r = (r << 3) | (r >> 2);
+	g = (g << 2) | (g >> 4);
+	b = (b << 3) | (b >> 2);
+	return 0xFF000000 | (r << 16) | (g << 8) | b;
+#else
+	uint32_t r = pixel >> 5, g = (pixel >> 2) & 0x7, b = pixel & 0x3;
+	r = (r << 5) | (r << 2) | (r >> 1);
+	g = (g << 5) | (g << 2) | (g >> 1);
+	b = b * 0x55;
+	return 0xFF000000 | (r << 16) | (g << 8) | b;
+#endif
+}
+
+#endif /* INC_RENDER_PIXEL_H_ */
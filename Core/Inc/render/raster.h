@@ -0,0 +1,47 @@
+/*
+ * raster.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_RASTER_H_
+#define INC_RENDER_RASTER_H_
+
+#include "render/pixel.h"
+#include "render/screen.h"
+#include "render/fixed.h"
+#include <stdint.h>
+
+/*
+ * Lines and triangle fans written by the CPU straight into a frame buffer.
+ *
+ * Everything is clipped to a rectangle of the buffer before the first pixel is written, and the pixels are
+ * reached by adding a constant step to the address of the previous one rather than by computing the address
+ * of every pixel from its coordinates, as BSP_LCD_DrawPixel() does. A line is the Bresenham line between its
+ * two ends, both included, whatever part of it survives the clipping. A fan is a set of triangles sharing a
+ * vertex, filled with the pixels whose center is inside them: two triangles with a common edge never write
+ * the same pixel and leave no hole between them.
+ *
+ * The caller must make sure that no DMA2D job writes the same area meanwhile and flush the pixels with
+ * platformFlushPixels() before the DMA2D or the LTDC read them.
+ */
+
+//frame buffer drawn into and the area the drawing is clipped to
+typedef struct {
+	pixel_t *buffer;
+	uint32_t stride; //distance in pixel between two rows of the buffer
+	Rect clip; //no pixel outside it is written
+} RasterTarget;
+
+//vertex of a fan, in Q16.16 pixel coordinates: the center of the pixel (x, y) is (x + 1/2, y + 1/2)
+typedef struct {
+	fixed x;
+	fixed y;
+} RasterPoint;
+
+pixel_t* rasterFillSpan(pixel_t *dst, int stride, int width, int rows, pixel_t color);
+void rasterLine(const RasterTarget *t, int x0, int y0, int x1, int y1, pixel_t color);
+void rasterFan(const RasterTarget *t, RasterPoint center, const RasterPoint *points, int count, pixel_t color);
+
+#endif /* INC_RENDER_RASTER_H_ */
@@ -0,0 +1,71 @@
+/*
+ * raycast.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_RAYCAST_H_
+#define INC_RENDER_RAYCAST_H_
+
+#include "render/render.h"
+#include "render/fixed.h"
+#include <stdint.h>
+
+/*
+ * Fixed point grid DDA ray caster.
+ *
+ * Every ray walks the map grid once, crossing vertical and horizontal grid lines in the order in which
+ * it meets them, so there is a single loop instead of the two separate h/v loops of castRaysFloat().
+ * The ray direction comes from a sin table filled once by raycastInit() and linearly interpolated, the
+ * distance between two grid lines along the ray (the DDA step) costs one integer division per axis,
+ * so casting a ray costs no libm call at all.
+ *
+ * Angles are binary angles: the whole turn is mapped on the 32 bits of an angle_t so that wrapping
+ * around 2*PI comes for free.
+ *
+ * A ray stops at the first opaque block or once it has gone raycastSetMaxBlocks() blocks, so the cost of a
+ * frame doesn't grow with the size of the map. Without the cutoff a ray goes up to RAYCAST_RANGE_BLOCKS, the
+ * distances being kept in 32 bit Q16.16: farther than the diagonal of the largest maze of maze.h. The positions
+ * are Q16.16 world units too, so a map can be up to 511 blocks wide.
+ *
+ * Tolerance against castRaysFloat(), checked by the host test raycast_regress (Host/raycast_regress.c), measured on
+ * 200000 random player poses per map of map.c (62 rays each, blocks of 64 pixels, the default cutoff):
+ * - distance and pos match within 0.5 pixels on all but 0.0017% of the rays;
+ * - nearly all the rays outside the above graze a wall: the float angles of castRaysFloat() differ from the
+ *   binary ones by up to 2e-5 radians, which moves the hit along a wall seen at an angle a by distance *
+ *   2e-5 / sin(a): below ~0.1 degrees the distances differ by a few percent, by 18% at 0.01 degrees;
+ * - the others, about 2.5 per million, pass within 1.5 pixels from a block corner, where the DDA stops on a
+ *   corner shared by two diagonal blocks while castRaysFloat() can slip through the gap;
+ * - vertical differs on about 6 rays per million, all within 0.5 pixels from a block corner;
+ * - as in castRaysFloat(), pos is moved inside the hit block when the grid line is crossed going left or up,
+ *   and along the wall it is kept inside the block, so it can always be used to look up the hit block.
+ */
+
+typedef uint32_t angle_t;
+
+//resolution of the sin table: 2^13 entries per turn
+#define RAYCAST_TABLE_BITS 13
+
+//binary angle corresponding to a degree: 2^32 / 360
+#define ANGLE_DEGREE ((angle_t)11930465)
+
+//distance returned when a ray hits nothing within the cutoff, the same used by castRaysFloat() for the rays leaving the map;
+//the pos of such a ray is the point where the cutoff stopped it
+#define RAYCAST_NO_HIT 100000000
+//default cutoff of the rays in blocks: farther than any wall of the maps of map.c, so it only matters on larger maps
+#define RAYCAST_MAX_BLOCKS 24
+//farthest a ray can go, with or without the cutoff: 2^31 in Q16.16, 512 blocks
+#define RAYCAST_RANGE_BLOCKS ((1 << (31 - FIXED_SHIFT)) >> MAP_BLOCK_SHIFT)
+
+void raycastInit(void);
+angle_t raycastAngle(float radians);
+float raycastRadians(angle_t a);
+fixed raycastSin(angle_t a);
+fixed raycastCos(angle_t a);
+void raycastCast(fixed x, fixed y, angle_t a, Map *m, Ray *r);
+void raycastCastDir(fixed x, fixed y, fixed dirX, fixed dirY, Map *m, Ray *r);
+void raycastSetMaxBlocks(int blocks);
+int raycastGetMaxBlocks(void);
+
+#endif /* INC_RENDER_RAYCAST_H_ */
@@ -13,6 +13,8 @@
 #include "semphr.h"
 #include "render/screen.h"
 #include "render/map.h"
+#include "render/fixed.h"
+#include "platform/platform.h"
 #include <stdbool.h>
 #include <math.h>
 
@@ -23,8 +25,23 @@
 #define P3 3*M_PI/2
 //math.h functions use radians rather than degrees therefore here what a degree corresponds to in radians
 #define DEGREE_RADIAN 0.0174533
-//the field of view of the player in degrees, which literally translates to the number of ray that will be casted
+//the field of view of the player in degrees, in RESOLUTION_LEGACY it literally translates to the number of ray that will be casted
 #define FOV 62
+//width in pixel of a column in RESOLUTION_LEGACY
+#define LEGACY_COLUMN_WIDTH 13
+//the maximum number of rays casted in a frame: one for every pixel column of the display
+#define MAX_RAYS 800
+//number of on screen controls drawn by drawControls()
+#define CONTROLS 4
+//the controls are laid out on the grid of blocks of the maps of map.c, whatever the size of the map played
+#define CONTROLS_GRID_X 20
+#define CONTROLS_GRID_Y 12
+//colors of the ceiling and of the floor of the 3D scene
+#define CEILING_COLOR COLOR_DARKYELLOW
+#define FLOOR_COLOR COLOR_DARKGRAY
+//colors of the rays drawn on the map by drawMapRays(): the lines and the area seen by the player
+#define MAP_RAYS_COLOR COLOR_BLACK
+#define MAP_FAN_COLOR ((uint32_t)0xFFFFFF80)
 
 
 
@@ -37,18 +54,58 @@ typedef struct {
 typedef struct {
 	int index;
 	float distance;
+	float perpDistance; //distance from the camera plane, used to size the column without the fish eye distortion
 	vec2 pos;
 	float angle;
 	bool vertical;
+	fixed texX; //position of the hit along the wall from 0 to FIXED_ONE, left to right as seen from the player
 } Ray;
 
+//statistics of the rays of the last castRays(), distances are perpendicular distances in pixel
+typedef struct {
+	int rays;
+	int vertical; //rays that hit the vertical side of a block
+	int misses; //rays that hit nothing within the cutoff of raycastSetMaxBlocks()
+	float minDistance; //of the rays that hit a wall
+	float maxDistance;
+	float avgDistance;
+} RayStats;
+
+//horizontal resolution of the 3D scene, it trades image quality for frame time
+typedef enum {
+	RESOLUTION_LEGACY, //FOV rays one degree apart drawn as LEGACY_COLUMN_WIDTH pixel wide columns
+	RESOLUTION_QUARTER, //a ray every 4 pixel columns of the display
+	RESOLUTION_HALF, //a ray every 2 pixel columns of the display
+	RESOLUTION_FULL, //a ray for every pixel column of the display
+	RESOLUTION_COUNT
+} Resolution;
+
+//how drawMapRays() draws the rays on the map
+typedef enum {
+	MAP_RAYS_PLATFORM, //a platformDrawLine() for every ray drawn, as the BSP draws lines
+	MAP_RAYS_LINES, //the same lines from raster.h, clipped to the map
+	MAP_RAYS_FAN, //the area seen by the player as a single filled fan from raster.h, clipped to the map
+	MAP_RAYS_STYLES
+} MapRaysStyle;
+
 
 
+void setResolution(Resolution res, Screen *s);
+Resolution getResolution(void);
+void setTextures(bool enable);
+bool getTextures(void);
+void setMapRaysStyle(MapRaysStyle style);
+MapRaysStyle getMapRaysStyle(void);
 void castRays(float focalX, float focalY, float focalAngle, Map *m);
-void drawControls(Screen *s, Map *m, int scale);
-void drawMapRays(float focalX, float focalY);
-void drawRays(Map *m, Screen *s, float focalAngle);
-void drawBackground(Screen *s);
+void castRaysFloat(float focalX, float focalY, float focalAngle, Map *m);
+void getRayStats(RayStats *stats);
+const Ray* getRays(int *count);
+void drawControls(Screen *s, int scale);
+void getControlRects(Screen *s, int scale, Rect *rects);
+Rect getMapRect(Map *m, Screen *s);
+vec2 getMapScale(Map *m, Screen *s);
+void drawMapRays(float focalX, float focalY, Map *m, Screen *s);
+void drawRays(Map *m, Screen *s);
 void drawMap(Map *m, Screen *s);
 
 #endif /* INC_RENDER_RENDER_H_ */
@@ -11,18 +11,77 @@
 
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "task.h"
+#include "render/pixel.h"
+#include <stdbool.h>
+
+//longest time waited for the LTDC reload, it only guards against a lost interrupt: a refresh lasts ~17 ms
+#define FLIP_TIMEOUT_MS 50
+
+//number of frame buffers carved out of the SDRAM, ct_screen_set_buffering() chooses how many of them are used
+#define SCREEN_MAX_BUFFERS 3
+//number of frame buffers used at start up: 2 for double buffering, 3 for triple buffering
+#ifndef SCREEN_DEFAULT_BUFFERS
+#define SCREEN_DEFAULT_BUFFERS 2
+#endif
+//index used when no buffer is in a given role
+#define SCREEN_NO_BUFFER 0xFF
+
+//rectangle of the screen in pixel
+typedef struct {
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+} Rect;
+
+//life cycle of a frame buffer: FREE -> DRAWING -> (READY) -> PENDING -> DISPLAYED -> FREE
+typedef enum {
+	BUFFER_FREE, //can be handed to the renderer
+	BUFFER_DRAWING, //the renderer is drawing into it
+	BUFFER_READY, //the frame is complete and waits for the pending one to be displayed
+	BUFFER_PENDING, //programmed in the LTDC shadow registers, displayed from the next vertical blanking
+	BUFFER_DISPLAYED //scanned out by the LTDC
+} BufferState;
+
+typedef struct {
+	uint32_t presented; //frames displayed since the last reset
+	uint32_t latency_last; //cycles between the submission of the last frame and its display
+	uint32_t latency_max;
+	uint64_t latency_sum;
+	uint64_t stall_sum; //cycles spent by the renderer waiting for a free buffer
+	TickType_t start; //tick of the last reset
+} ScreenStats;
 
 typedef struct {
-	uint32_t addr[2];
+	uintptr_t addr[SCREEN_MAX_BUFFERS]; //frame buffers, uintptr_t so that the host backend can keep them in the heap
 	uint32_t width;
 	uint32_t height;
-	uint32_t front;
 	SemaphoreHandle_t *lcd_mut;
+	uint32_t buffers; //number of frame buffers in use, 2 or 3
+	volatile uint32_t requested_buffers; //applied by ct_screen_wait_backbuffer() once no frame is in flight
+	volatile BufferState state[SCREEN_MAX_BUFFERS];
+	uint32_t back; //buffer the renderer is drawing into, SCREEN_NO_BUFFER between a flip and the next wait
+	volatile uint32_t front; //buffer on display
+	volatile uint32_t pending; //buffer that will be displayed at the next vertical blanking
+	uint32_t ready[SCREEN_MAX_BUFFERS]; //FIFO of the complete frames waiting to become pending
+	volatile uint32_t ready_head;
+	volatile uint32_t ready_count;
+	uint32_t submit[SCREEN_MAX_BUFFERS]; //DWT cycle counter when each buffer was submitted
+	TaskHandle_t flip_waiter; //task blocked in ct_screen_wait_backbuffer(), notified by the LTDC interrupt
+	ScreenStats stats;
 } Screen;
 
 Screen* ct_screen_init();
 void ct_screen_flip_buffers(Screen *screen);
-uint32_t* ct_screen_backbuffer_ptr(Screen *screen);
+void ct_screen_wait_backbuffer(Screen *screen);
+void ct_screen_set_buffering(Screen *screen, uint32_t buffers);
+uint32_t ct_screen_present_latency_us(Screen *screen);
+void ct_screen_get_stats(Screen *screen, ScreenStats *stats);
+void ct_screen_reset_stats(Screen *screen);
+pixel_t* ct_screen_backbuffer_ptr(Screen *screen);
+void ct_screen_load_clut(uint32_t layer);
+void ct_screen_irq_handler(void);
 
 extern Screen *screen;
 
@@ -0,0 +1,63 @@
+/*
+ * text.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_TEXT_H_
+#define INC_RENDER_TEXT_H_
+
+#include "render/pixel.h"
+#include "platform/platform.h"
+#include "fonts.h"
+#include <stdint.h>
+
+/*
+ * Text drawn from a glyph cache by the DMA2D.
+ *
+ * The first time a font is used its 1 bit glyphs are expanded into an A8 atlas in the SDRAM, a byte of
+ * alpha per pixel, and the area actually inked by every glyph is noted. A string is then a fill of its cells
+ * with the back color and a BLIT_BLEND_A8 job of blit.c for the inked area of each glyph, instead of a CPU
+ * write per pixel of the cells as the DrawChar() of the BSP does. A back color with zero alpha, e.g.
+ * COLOR_TRANSPARENT, is not drawn: the glyphs are blended over whatever is under them.
+ *
+ * The strings are placed as BSP_LCD_DisplayStringAt() places them, characters that would end past the right
+ * edge of the buffer are dropped and so are the lines past its bottom.
+ */
+
+//the characters of the fonts of the BSP, ' ' to '~'
+#define TEXT_FIRST_CHAR ' '
+#define TEXT_GLYPHS 95
+//fonts with a glyph cache: the five of the BSP
+#define TEXT_MAX_FONTS 5
+
+//frame buffer drawn into and drawing state of a string
+typedef struct {
+	pixel_t *buffer;
+	uint32_t width; //size of the buffer in pixel
+	uint32_t height;
+	const sFONT *font;
+	uint32_t color; //ARGB8888 color of the glyphs
+	uint32_t backColor; //ARGB8888 color of the cells, not drawn if its alpha is 0
+} TextTarget;
+
+//area of a glyph with ink, relative to the top left corner of its cell
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	uint8_t width; //0 for a blank glyph
+	uint8_t height;
+} TextBox;
+
+typedef struct {
+	const sFONT *font;
+	uint8_t *atlas; //the A8 glyphs one after the other, Width x Height bytes each
+	TextBox ink[TEXT_GLYPHS];
+} TextAtlas;
+
+const TextAtlas* textAtlas(const sFONT *font);
+int textColumn(uint32_t width, const sFONT *font, const char *text, uint16_t x, PlatformAlign align);
+uint32_t textDrawString(const TextTarget *t, uint16_t x, uint16_t y, const char *text, PlatformAlign align);
+
+#endif /* INC_RENDER_TEXT_H_ */
@@ -0,0 +1,42 @@
+/*
+ * texture.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_TEXTURE_H_
+#define INC_RENDER_TEXTURE_H_
+
+#include "render/fixed.h"
+#include "render/pixel.h"
+#include <stdbool.h>
+
+/*
+ * Wall textures.
+ *
+ * The textures are generated by textureInit() into an atlas in the SDRAM, already converted to the pixel
+ * format of the frame buffers. Every texture has a lit copy, used for the walls hit on a vertical grid
+ * line, and a dark copy for the ones hit on a horizontal grid line, the same shading of the flat colors,
+ * so the sampler doesn't shade anything. Textures are stored column by column: the column of texels
+ * scaled on a column of the screen is contiguous in memory.
+ *
+ * textureSpan() scales a texture column on the frame buffer stepping through it in Q16.16, so a pixel
+ * costs an add, a shift and a load. Host/bench_texture.c measures it against the flat fill.
+ */
+
+//textures are TEXTURE_SIZE x TEXTURE_SIZE texels, a power of two so coordinates wrap with a mask
+#define TEXTURE_BITS 6
+#define TEXTURE_SIZE (1 << TEXTURE_BITS)
+
+typedef enum {
+	TEXTURE_WALL, //bricks of the ordinary walls
+	TEXTURE_EXIT, //door of the final wall
+	TEXTURE_COUNT
+} TextureId;
+
+void textureInit(void);
+const pixel_t* textureColumn(TextureId id, bool dark, fixed texX);
+pixel_t* textureSpan(pixel_t *dst, int stride, int width, int rows, const pixel_t *column, fixed texY, fixed step);
+
+#endif /* INC_RENDER_TEXTURE_H_ */
@@ -0,0 +1,26 @@
+/*
+ * vram.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_RENDER_VRAM_H_
+#define INC_RENDER_VRAM_H_
+
+#include <stdint.h>
+
+/*
+ * Bump allocator of the external SDRAM.
+ *
+ * Frame buffers, caches and every other big buffer are carved out of the SDRAM at start up and never
+ * freed, so a pointer bumped from the start of the device is all the bookkeeping needed.
+ */
+
+//alignment of every allocation: a SDRAM burst and a D-cache line are 32 bytes
+#define VRAM_ALIGN 32
+
+void* vramAlloc(uint32_t size);
+uint32_t vramFree(void);
+
+#endif /* INC_RENDER_VRAM_H_ */
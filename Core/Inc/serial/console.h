@@ -0,0 +1,47 @@
+/*
+ * console.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_SERIAL_CONSOLE_H_
+#define INC_SERIAL_CONSOLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Line editor and command parser of the serial console.
+ *
+ * consoleFeed() collects the received characters in a line, as typed in a terminal or pasted by a script:
+ * the line ends with \r, \n or \r\n and backspace deletes the last character. A complete line is split in
+ * words separated by spaces, the first word is looked up in a table of ConsoleCommand and the command is
+ * called with all the words, like main().
+ */
+
+//longest line accepted, terminator included: the characters past it are dropped and the line is rejected
+#define CONSOLE_LINE_SIZE 48
+//most words in a line, command included
+#define CONSOLE_MAX_ARGS 4
+
+typedef struct {
+	char line[CONSOLE_LINE_SIZE];
+	uint32_t length;
+	bool overflow; //the line is longer than CONSOLE_LINE_SIZE-1 characters
+	bool lastCR; //the last character was \r: a \n following it doesn't end another line
+	bool ended; //the last character ended a line
+} Console;
+
+typedef struct {
+	const char *name;
+	const char *help; //one line description listed by the help
+	void (*run)(int argc, char **argv);
+} ConsoleCommand;
+
+void consoleInit(Console *c);
+bool consoleFeed(Console *c, char ch);
+int consoleSplit(char *line, char **argv, int max);
+const ConsoleCommand* consoleFind(const ConsoleCommand *commands, int count, const char *name);
+
+#endif /* INC_SERIAL_CONSOLE_H_ */
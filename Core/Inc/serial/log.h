@@ -0,0 +1,29 @@
+/*
+ * log.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_SERIAL_LOG_H_
+#define INC_SERIAL_LOG_H_
+
+#include <stdbool.h>
+
+/*
+ * Text output on the serial console.
+ *
+ * The messages are queued in the transmit ring of serial/uart.c and sent by the DMA in the background:
+ * logPrintf() and logWrite() return as soon as the message is copied and can be called from any task, the
+ * render task included, without waiting for the UART. A message that doesn't fit in the ring is dropped and
+ * counted in UartStats. logPrint() is for the replies of the console, which are better late than lost.
+ */
+
+//longest message formatted by logPrintf(), terminator included: the rest is cut. It is formatted on the stack
+#define LOG_LINE_SIZE 128
+
+bool logPrintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+bool logWrite(const char *text);
+void logPrint(const char *text);
+
+#endif /* INC_SERIAL_LOG_H_ */
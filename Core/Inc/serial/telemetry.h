@@ -0,0 +1,98 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_SERIAL_TELEMETRY_H_
+#define INC_SERIAL_TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Binary telemetry stream, shared by the board, which encodes it, and the host tools, which decode it.
+ *
+ * A packet is a type byte, a version byte and the fields of the type in little endian, followed by the
+ * CRC-16/CCITT-FALSE of all of them. It is COBS encoded, so it contains no zero byte, and sent between two
+ * zero bytes: a decoder finds the start of the next packet after any garbage, e.g. the text of the console
+ * which shares the serial port, and a packet broken by a dropped byte fails the CRC and is skipped.
+ *
+ * TELEMETRY_FRAME is sent for every frame drawn while playing: the frame time, the times of the stages of the
+ * frame, the position of the player and the statistics of the rays. TELEMETRY_TASKS is sent every second with
+ * the share of CPU time and the free stack of every task.
+ */
+
+#define TELEMETRY_VERSION 1
+//characters of the task names, longer names are cut
+#define TELEMETRY_TASK_NAME 12
+#define TELEMETRY_MAX_TASKS 12
+//longest payload, CRC included: a TELEMETRY_TASKS packet with TELEMETRY_MAX_TASKS tasks
+#define TELEMETRY_MAX_PAYLOAD (7 + TELEMETRY_MAX_TASKS * (5 + TELEMETRY_TASK_NAME) + 2)
+//longest encoded packet: the COBS overhead of a byte every 254 and the two delimiters
+#define TELEMETRY_MAX_ENCODED (TELEMETRY_MAX_PAYLOAD + TELEMETRY_MAX_PAYLOAD / 254 + 3)
+
+typedef enum {
+	TELEMETRY_FRAME = 1,
+	TELEMETRY_TASKS = 2
+} TelemetryType;
+
+//times are in microseconds and distances in pixel of the map, the 16 bit fields saturate
+typedef struct {
+	uint32_t frame; //number of the frame since boot
+	uint32_t timeMs; //tick count at the end of the frame
+	uint32_t frameUs; //time since the previous frame
+	uint16_t castUs; //stages of the frame, see profile.h
+	uint16_t wallsUs;
+	uint16_t hudUs;
+	uint16_t flipUs;
+	float x; //position and direction of the player drawn in the frame
+	float y;
+	float angle;
+	uint8_t map; //index of the map in map.c
+	uint16_t rays; //statistics of the rays, see RayStats in render.h
+	uint16_t vertical;
+	uint16_t misses;
+	uint16_t minDistance;
+	uint16_t avgDistance;
+	uint16_t maxDistance;
+} TelemetryFrame;
+
+typedef struct {
+	uint8_t number; //the number given by the kernel
+	char name[TELEMETRY_TASK_NAME + 1];
+	uint16_t cpuPermille; //share of CPU time since the previous TELEMETRY_TASKS packet
+	uint16_t stackFree; //minimum free stack ever, in words
+} TelemetryTask;
+
+typedef struct {
+	uint32_t timeMs;
+	uint8_t count;
+	TelemetryTask task[TELEMETRY_MAX_TASKS];
+} TelemetryTasks;
+
+typedef struct {
+	TelemetryType type;
+	union {
+		TelemetryFrame frame;
+		TelemetryTasks tasks;
+	};
+} TelemetryPacket;
+
+typedef struct {
+	uint8_t buffer[TELEMETRY_MAX_ENCODED];
+	size_t length;
+	bool overflow; //the bytes since the last delimiter don't fit in buffer
+	uint32_t packets; //valid packets decoded
+	uint32_t crcErrors; //packets dropped because of the CRC
+	uint32_t malformed; //packets dropped because of the COBS encoding, the length, the type or the version
+} TelemetryDecoder;
+
+size_t telemetryEncodeFrame(const TelemetryFrame *frame, uint8_t *out);
+size_t telemetryEncodeTasks(const TelemetryTasks *tasks, uint8_t *out);
+void telemetryDecoderInit(TelemetryDecoder *d);
+bool telemetryDecode(TelemetryDecoder *d, uint8_t byte, TelemetryPacket *packet);
+
+#endif /* INC_SERIAL_TELEMETRY_H_ */
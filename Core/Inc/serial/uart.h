@@ -0,0 +1,66 @@
+/*
+ * uart.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef INC_SERIAL_UART_H_
+#define INC_SERIAL_UART_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32f7xx_hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DMA driven receiver and transmitter of the serial console.
+ *
+ * The DMA writes the received bytes in a small circular buffer and never stops. The HAL reports how far it
+ * got when the buffer is half full, when it wraps around and when the line goes idle after a burst, so a
+ * whole line typed or pasted in the terminal costs a single interrupt. The interrupt moves the new bytes in
+ * a ring drained by one task with ct_uart_read(): the interrupt only advances the head of the ring and the
+ * task only advances the tail, so neither of them ever waits for the other. Bytes that don't fit in the ring
+ * are counted and dropped.
+ *
+ * ct_uart_write() copies a message in the transmit ring and returns straight away, the DMA sends the ring
+ * in the background. Any task, or interrupt, can write at any time without taking a lock: a writer reserves
+ * its space by moving the head of the ring with a compare and swap, copies the message, and the last writer
+ * to finish makes all the reserved bytes visible to the DMA. A message that doesn't fit in the free space is
+ * dropped whole and counted, so the writer never waits for the UART.
+ *
+ * HAL_UARTEx_RxEventCallback(), HAL_UART_TxCpltCallback() and HAL_UART_ErrorCallback() must forward the
+ * events of the console UART to ct_uart_rx_event(), ct_uart_tx_done() and ct_uart_error(), and the
+ * handlers of DMA2 stream 2 and 7 must call ct_uart_rx_irq_handler() and ct_uart_tx_irq_handler().
+ */
+
+//size of the circular DMA buffer: a whole number of cache lines, it is invalidated before it is read
+#define UART_RX_DMA_SIZE 64
+//size of the ring read by ct_uart_read(), a power of two
+#define UART_RX_RING_SIZE 512
+//size of the transmit ring, a power of two up to 32768: about 350 ms of data at 115200 baud
+#define UART_TX_RING_SIZE 4096
+
+typedef struct {
+	uint32_t rxDropped; //bytes received while the receive ring was full
+	uint32_t rxErrors; //receptions restarted after an overrun, a framing error or a DMA error
+	uint32_t txBytes; //bytes queued for transmission
+	uint32_t txDropped; //messages dropped because the transmit ring was full
+	uint32_t txDroppedBytes;
+	uint32_t txErrors; //transfers of the transmitter aborted by a DMA error
+	uint32_t txPeak; //most bytes waiting in the transmit ring
+} UartStats;
+
+void ct_uart_init(UART_HandleTypeDef *huart);
+uint32_t ct_uart_read(uint8_t *dst, uint32_t size, TickType_t timeout);
+bool ct_uart_write(const void *data, uint32_t size);
+uint32_t ct_uart_tx_free(void);
+void ct_uart_get_stats(UartStats *stats);
+void ct_uart_rx_event(uint16_t pos);
+void ct_uart_tx_done(void);
+void ct_uart_error(void);
+void ct_uart_rx_irq_handler(void);
+void ct_uart_tx_irq_handler(void);
+
+#endif /* INC_SERIAL_UART_H_ */
@@ -93,6 +93,8 @@ EndDependencies */
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f769i_discovery_lcd.h"
 #include "../Fonts/fonts.h"
+#include "render/blit.h"
+#include "render/pixel.h"
 //#include "../../../Utilities/Fonts/font24.c"
 //#include "../../../Utilities/Fonts/font20.c"
 //#include "../../../Utilities/Fonts/font16.c"
@@ -760,7 +762,7 @@ void BSP_LCD_LayerDefaultInit(uint16_t LayerIndex, uint32_t FB_Address)
   Layercfg.WindowX1 = BSP_LCD_GetXSize();
   Layercfg.WindowY0 = 0;
   Layercfg.WindowY1 = BSP_LCD_GetYSize(); 
-  Layercfg.PixelFormat = LTDC_PIXEL_FORMAT_ARGB8888;
+  Layercfg.PixelFormat = PIXEL_LTDC_FORMAT;
   Layercfg.FBStartAdress = FB_Address;
   Layercfg.Alpha = 255;
   Layercfg.Alpha0 = 0;
@@ -940,6 +942,9 @@ uint32_t BSP_LCD_ReadPixel(uint16_t Xpos, uint16_t Ypos)
 {
   uint32_t ret = 0;
 
+  /* Queued fills must land before the pixel is read */
+  ct_blit_wait(ct_blit_fence());
+
   if(hltdc_discovery.LayerCfg[ActiveLayer].PixelFormat == LTDC_PIXEL_FORMAT_ARGB8888)
   {
     /* Read data value from SDRAM memory */
@@ -960,7 +965,7 @@ uint32_t BSP_LCD_ReadPixel(uint16_t Xpos, uint16_t Ypos)
   else
   {
     /* Read data value from SDRAM memory */
-    ret = *(__IO uint8_t*) (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress + (2*(Ypos*BSP_LCD_GetXSize() + Xpos)));
+    ret = *(__IO uint8_t*) (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress + (Ypos*BSP_LCD_GetXSize() + Xpos));
   }
 
   return ret;
@@ -1094,7 +1099,7 @@ void BSP_LCD_DrawHLine(uint16_t Xpos, uint16_t Ypos, uint16_t Length)
   uint32_t  Xaddress = 0;
 
   /* Get the line address */
-  Xaddress = (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress) + 4*(BSP_LCD_GetXSize()*Ypos + Xpos);
+  Xaddress = (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress) + PIXEL_BYTES*(BSP_LCD_GetXSize()*Ypos + Xpos);
 
   /* Write line */
   LL_FillBuffer(ActiveLayer, (uint32_t *)Xaddress, Length, 1, 0, DrawProp[ActiveLayer].TextColor);
@@ -1111,7 +1116,7 @@ void BSP_LCD_DrawVLine(uint16_t Xpos, uint16_t Ypos, uint16_t Length)
   uint32_t  Xaddress = 0;
 
   /* Get the line address */
-  Xaddress = (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress) + 4*(BSP_LCD_GetXSize()*Ypos + Xpos);
+  Xaddress = (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress) + PIXEL_BYTES*(BSP_LCD_GetXSize()*Ypos + Xpos);
 
   /* Write line */
   LL_FillBuffer(ActiveLayer, (uint32_t *)Xaddress, 1, Length, (BSP_LCD_GetXSize() - 1), DrawProp[ActiveLayer].TextColor);
@@ -1339,7 +1344,7 @@ void BSP_LCD_DrawBitmap(uint32_t Xpos, uint32_t Ypos, uint8_t *pbmp)
   bit_pixel = pbmp[28] + (pbmp[29] << 8);
 
   /* Set the address */
-  Address = hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress + (((BSP_LCD_GetXSize()*Ypos) + Xpos)*(4));
+  Address = hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress + (((BSP_LCD_GetXSize()*Ypos) + Xpos)*(PIXEL_BYTES));
 
   /* Get the layer pixel format */
   if ((bit_pixel/8) == 4)
@@ -1365,7 +1370,7 @@ void BSP_LCD_DrawBitmap(uint32_t Xpos, uint32_t Ypos, uint8_t *pbmp)
     LL_ConvertLineToARGB8888((uint32_t *)pbmp, (uint32_t *)Address, width, InputColorMode);
 
     /* Increment the source and destination buffers */
-    Address+=  (BSP_LCD_GetXSize()*4);
+    Address+=  (BSP_LCD_GetXSize()*PIXEL_BYTES);
     pbmp -= width*(bit_pixel/8);
   }
 }
@@ -1385,7 +1390,7 @@ void BSP_LCD_FillRect(uint16_t Xpos, uint16_t Ypos, uint16_t Width, uint16_t Hei
   BSP_LCD_SetTextColor(DrawProp[ActiveLayer].TextColor);
 
   /* Get the rectangle start address */
-  Xaddress = (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress) + 4*(BSP_LCD_GetXSize()*Ypos + Xpos);
+  Xaddress = (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress) + PIXEL_BYTES*(BSP_LCD_GetXSize()*Ypos + Xpos);
 
   /* Fill the rectangle */
   LL_FillBuffer(ActiveLayer, (uint32_t *)Xaddress, Width, Height, (BSP_LCD_GetXSize() - Width), DrawProp[ActiveLayer].TextColor);
@@ -1731,8 +1736,11 @@ __weak void BSP_LCD_MspInit(void)
   */
 void BSP_LCD_DrawPixel(uint16_t Xpos, uint16_t Ypos, uint32_t RGB_Code)
 {
-  /* Write data value to all SDRAM memory */
-  *(__IO uint32_t*) (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress + (4*(Ypos*BSP_LCD_GetXSize() + Xpos))) = RGB_Code;
+  /* Queued fills must land before the pixel is written */
+  ct_blit_wait(ct_blit_fence());
+
+  /* Write data value to all SDRAM memory, in the pixel format of the frame buffers */
+  *(__IO pixel_t*) (hltdc_discovery.LayerCfg[ActiveLayer].FBStartAdress + (PIXEL_BYTES*(Ypos*BSP_LCD_GetXSize() + Xpos))) = pixelFromArgb(RGB_Code);
 }
 
 
@@ -1879,29 +1887,15 @@ static void FillTriangle(uint16_t x1, uint16_t x2, uint16_t x3, uint16_t y1, uin
   */
 static void LL_FillBuffer(uint32_t LayerIndex, void *pDst, uint32_t xSize, uint32_t ySize, uint32_t OffLine, uint32_t ColorIndex)
 {
-  /* Register to memory mode with ARGB8888 as color Mode */
-  hdma2d_discovery.Init.Mode         = DMA2D_R2M;
-  hdma2d_discovery.Init.ColorMode    = DMA2D_OUTPUT_ARGB8888;
-  hdma2d_discovery.Init.OutputOffset = OffLine;
-
-  hdma2d_discovery.Instance = DMA2D;
-
-  /* DMA2D Initialization */
-  if(HAL_DMA2D_Init(&hdma2d_discovery) == HAL_OK)
-  {
-    if(HAL_DMA2D_ConfigLayer(&hdma2d_discovery, LayerIndex) == HAL_OK)
-    {
-      if (HAL_DMA2D_Start(&hdma2d_discovery, ColorIndex, (uint32_t)pDst, xSize, ySize) == HAL_OK)
-      {
-        /* Polling For DMA transfer */
-        HAL_DMA2D_PollForTransfer(&hdma2d_discovery, 10);
-      }
-    }
-  }
+  /* Queue the fill: the DMA2D is programmed by the job queue, no need to wait for it here,
+     the functions drawing with the CPU wait for the queue before touching the frame buffer */
+  (void)LayerIndex;
+  ct_blit_fill(pDst, xSize, ySize, OffLine, ColorIndex);
 }
 
 /**
-  * @brief  Converts a line to an ARGB8888 pixel format.
+  * @brief  Converts a line to the pixel format of the frame buffers.
+  * @note   The DMA2D can't write L8: in that format the line is left untouched.
   * @param  pSrc: Pointer to source buffer
   * @param  pDst: Output color
   * @param  xSize: Buffer width
@@ -1909,9 +1903,17 @@ static void LL_FillBuffer(uint32_t LayerIndex, void *pDst, uint32_t xSize, uint3
   */
 static void LL_ConvertLineToARGB8888(void *pSrc, void *pDst, uint32_t xSize, uint32_t ColorMode)
 {
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_L8
+  (void)pSrc; (void)pDst; (void)xSize; (void)ColorMode;
+  return;
+#endif
+
+  /* The conversion uses the DMA2D through the HAL: the job queue must be idle */
+  ct_blit_wait(ct_blit_fence());
+
   /* Configure the DMA2D Mode, Color Mode and output offset */
   hdma2d_discovery.Init.Mode         = DMA2D_M2M_PFC;
-  hdma2d_discovery.Init.ColorMode    = DMA2D_OUTPUT_ARGB8888;
+  hdma2d_discovery.Init.ColorMode    = PIXEL_DMA2D_FORMAT;
   hdma2d_discovery.Init.OutputOffset = 0;
 
   /* Foreground Configuration */
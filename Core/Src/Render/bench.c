@@ -0,0 +1,346 @@
+/*
+ * bench.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/bench.h"
+#include "render/maze.h"
+#include "render/raycast.h"
+#include "render/vram.h"
+#include "platform/platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+//timings of every frame of the last run: one row for each stage and one for the whole frame
+static uint32_t samples[BENCH_STAGES + 1][BENCH_FRAMES];
+
+static const char *stageNames[BENCH_STAGES] = { "castRays", "drawRays", "drawMap", "drawMapRays", "text" };
+static const char *textMethodNames[BENCH_TEXT_METHODS] = { "per pixel", "glyphs", "transparent" };
+static const int mazeSizes[BENCH_MAZE_SIZES] = { 16, 32, 64, 128, 256 };
+
+/**
+  * @brief  Computes the position of the camera in a frame of the path through a map
+  * @param  m : The map the camera walks through
+  * @param  frame : The index of the frame in the path, from 0 to BENCH_FRAMES_PER_MAP-1
+  * @param  pos : Where the position is written: the middle of an empty block
+  * @param  angle : Where the direction of the camera is written, in radians from 0 to 2PI
+  */
+static void cameraAt(Map *m, int frame, vec2 *pos, float *angle)
+{
+	int blocks = m->mapBlockX * m->mapBlockY;
+	int empty = 0;
+
+	for(int i = 0; i < blocks; i++)
+		empty += mapBlock(m, i % m->mapBlockX, i / m->mapBlockX) == BLOCK_FLOOR;
+
+	//the empty blocks are visited in the order they appear in the map, each one for the same number of frames
+	int target = frame * empty / BENCH_FRAMES_PER_MAP;
+	for(int i = 0; i < blocks; i++)
+		if(mapBlock(m, i % m->mapBlockX, i / m->mapBlockX) == BLOCK_FLOOR && target-- == 0)
+		{
+			pos->x = (i % m->mapBlockX + 0.5f) * MAP_BLOCK_SIZE;
+			pos->y = (i / m->mapBlockX + 0.5f) * MAP_BLOCK_SIZE;
+			break;
+		}
+
+	*angle = fmodf(2 * M_PI * BENCH_TURNS * frame / BENCH_FRAMES_PER_MAP, 2 * M_PI);
+}
+
+/**
+  * @brief  qsort() comparison of two timings
+  */
+static int compareTimings(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+/**
+  * @brief  Computes the statistics of the timings of a stage, the timings are sorted in place
+  * @param  timings : The timings of every frame
+  * @param  count : The number of timings
+  * @param  result : Where the statistics are written
+  */
+static void summarize(uint32_t *timings, uint32_t count, BenchTiming *result)
+{
+	qsort(timings, count, sizeof(uint32_t), compareTimings);
+	result->min = timings[0];
+	result->median = timings[count / 2];
+	//nearest rank: the smallest timing not exceeded by 99% of the frames
+	result->p99 = timings[(count * 99 + 99) / 100 - 1];
+}
+
+/**
+  * @brief  Draws BENCH_FRAMES_PER_MAP frames along the camera path of a map and times each stage of every frame
+  * @note   The frames are drawn in the back buffer and displayed as usual, with the resolution currently set.
+  * @param  m : The map
+  * @param  s : The Screen used to display the game
+  * @param  frame : The index in samples of the timings of the first frame
+  */
+static void drawFrames(Map *m, Screen *s, uint32_t frame)
+{
+	char text[32];
+	vec2 pos;
+	float angle;
+
+	//the first cast of a map also applies a pending change of resolution: it is left out
+	cameraAt(m, 0, &pos, &angle);
+	castRays(pos.x, pos.y, angle, m);
+
+	for(int f = 0; f < BENCH_FRAMES_PER_MAP; f++, frame++)
+	{
+		uint32_t t[BENCH_STAGES + 1];
+
+		cameraAt(m, f, &pos, &angle);
+		snprintf(text, sizeof(text), "%3d FPS %5lu us", f, (unsigned long)frame);
+		ct_screen_wait_backbuffer(s);
+
+		t[BENCH_CAST] = platformCycles();
+		castRays(pos.x, pos.y, angle, m);
+		t[BENCH_WALLS] = platformCycles();
+		drawRays(m, s);
+		t[BENCH_MAP] = platformCycles();
+		drawMap(m, s);
+		platformWaitDrawing();
+		t[BENCH_MAP_RAYS] = platformCycles();
+		drawMapRays(pos.x, pos.y, m, s);
+		t[BENCH_TEXT] = platformCycles();
+		platformSetTextColor(COLOR_BLACK);
+		platformSetBackColor(COLOR_ORANGE);
+		platformDrawString(0, 0, text, PLATFORM_ALIGN_RIGHT);
+		t[BENCH_STAGES] = platformCycles();
+
+		for(int stage = 0; stage < BENCH_STAGES; stage++)
+			samples[stage][frame] = t[stage + 1] - t[stage];
+		samples[BENCH_STAGES][frame] = t[BENCH_STAGES] - t[BENCH_CAST];
+
+		platformFlushPixels();
+		ct_screen_flip_buffers(s);
+	}
+}
+
+/**
+  * @brief  Draws BENCH_FRAMES_PER_MAP frames on every map and times each stage of every frame
+  * @note   The frames are drawn in the back buffer and displayed as usual, with the resolution currently set.
+  * 		The maps are got with getMap(), so the map of the game and the next one of changeMap() are left alone.
+  * @param  s : The Screen used to display the game
+  * @param  report : Where the statistics of the run are written
+  */
+void benchRun(Screen *s, BenchReport *report)
+{
+	Map m;
+
+	for(int i = 0; i < MAP_COUNT; i++)
+	{
+		getMap(&m, i);
+		drawFrames(&m, s, i * BENCH_FRAMES_PER_MAP);
+	}
+
+	report->res = getResolution();
+	report->mapRays = getMapRaysStyle();
+	report->frames = BENCH_FRAMES;
+	report->cyclesPerUs = platformCyclesPerUs();
+	for(int stage = 0; stage < BENCH_STAGES; stage++)
+		summarize(samples[stage], BENCH_FRAMES, &report->stage[stage]);
+	summarize(samples[BENCH_STAGES], BENCH_FRAMES, &report->frame);
+}
+
+/**
+  * @brief  Writes a timing in microseconds with one decimal digit
+  * @return the number of characters snprintf() would have written
+  */
+static int formatUs(char *text, size_t size, uint32_t cycles, uint32_t cyclesPerUs)
+{
+	uint64_t tenths = (uint64_t)cycles * 10 / cyclesPerUs;
+	return snprintf(text, size, " %7lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+}
+
+/**
+  * @brief  Writes a report as a table with a row for each stage, lines end with \r\n for the serial console
+  * @param  report : The report of benchRun()
+  * @param  text : Where the table is written, it is always terminated
+  * @param  size : The size of text
+  * @return the number of characters written, without the terminator
+  */
+int benchFormat(const BenchReport *report, char *text, size_t size)
+{
+	size_t length = 0;
+	const BenchTiming *timing;
+
+	length += snprintf(text, size, "resolution %d, map rays %d, %lu frames, us:\r\n%-12s %9s %9s %9s\r\n",
+			(int)report->res, (int)report->mapRays, (unsigned long)report->frames, "stage", "min", "median", "p99");
+
+	for(int stage = 0; stage <= BENCH_STAGES && length < size; stage++)
+	{
+		timing = stage < BENCH_STAGES ? &report->stage[stage] : &report->frame;
+		length += snprintf(text + length, size - length, "%-12s", stage < BENCH_STAGES ? stageNames[stage] : "frame");
+		if(length < size)
+			length += formatUs(text + length, size - length, timing->min, report->cyclesPerUs);
+		if(length < size)
+			length += formatUs(text + length, size - length, timing->median, report->cyclesPerUs);
+		if(length < size)
+			length += formatUs(text + length, size - length, timing->p99, report->cyclesPerUs);
+		if(length < size)
+			length += snprintf(text + length, size - length, "\r\n");
+	}
+
+	return length < size ? (int)length : (int)size - 1;
+}
+
+/**
+  * @brief  Draws BENCH_FRAMES_PER_MAP frames on mazes of growing size, with and without the cutoff of the rays
+  * @note   The mazes are built in a buffer of their own, allocated the first time, so the map of the game is
+  * 		left alone. The frames are drawn and displayed as in benchRun(). The timings reuse its samples.
+  * @param  s : The Screen used to display the game
+  * @param  report : Where the statistics of the run are written
+  * @return false if there is no SDRAM left for the mazes
+  */
+bool benchMazes(Screen *s, BenchMazeReport *report)
+{
+	static uint8_t *storage;
+	int maxBlocks = raycastGetMaxBlocks();
+	Map maze;
+
+	if(storage == NULL)
+		storage = vramAlloc(mapStorageSize(MAZE_MAX_SIZE, MAZE_MAX_SIZE));
+	if(storage == NULL)
+		return false;
+
+	for(int i = 0; i < BENCH_MAZE_SIZES; i++)
+	{
+		BenchMazeRow *row = &report->row[i];
+
+		row->size = mazeSizes[i];
+		mazeGenerate(&maze, storage, row->size, row->size, BENCH_MAZE_SEED, MAZE_BRAIDED);
+
+		drawFrames(&maze, s, 0);
+		summarize(samples[BENCH_CAST], BENCH_FRAMES_PER_MAP, &row->cast);
+		summarize(samples[BENCH_STAGES], BENCH_FRAMES_PER_MAP, &row->frame);
+
+		raycastSetMaxBlocks(0);
+		drawFrames(&maze, s, 0);
+		summarize(samples[BENCH_CAST], BENCH_FRAMES_PER_MAP, &row->castUncut);
+		raycastSetMaxBlocks(maxBlocks);
+	}
+
+	report->res = getResolution();
+	report->maxBlocks = maxBlocks;
+	report->frames = BENCH_FRAMES_PER_MAP;
+	report->cyclesPerUs = platformCyclesPerUs();
+	return true;
+}
+
+/**
+  * @brief  Writes a maze report as a table with a row for each size, lines end with \r\n for the serial console
+  * @param  report : The report of benchMazes()
+  * @param  text : Where the table is written, it is always terminated
+  * @param  size : The size of text
+  * @return the number of characters written, without the terminator
+  */
+int benchMazesFormat(const BenchMazeReport *report, char *text, size_t size)
+{
+	size_t length = 0;
+
+	length += snprintf(text, size, "resolution %d, mazes, cutoff %d blocks, %lu frames, median us:\r\n%-12s %9s %9s %9s %9s\r\n",
+			(int)report->res, report->maxBlocks, (unsigned long)report->frames, "maze", "castRays", "uncut", "frame", "frame p99");
+
+	for(int i = 0; i < BENCH_MAZE_SIZES && length < size; i++)
+	{
+		const BenchMazeRow *row = &report->row[i];
+		length += snprintf(text + length, size - length, "%3dx%-8d", row->size, row->size);
+		if(length < size)
+			length += formatUs(text + length, size - length, row->cast.median, report->cyclesPerUs);
+		if(length < size)
+			length += formatUs(text + length, size - length, row->castUncut.median, report->cyclesPerUs);
+		if(length < size)
+			length += formatUs(text + length, size - length, row->frame.median, report->cyclesPerUs);
+		if(length < size)
+			length += formatUs(text + length, size - length, row->frame.p99, report->cyclesPerUs);
+		if(length < size)
+			length += snprintf(text + length, size - length, "\r\n");
+	}
+
+	return length < size ? (int)length : (int)size - 1;
+}
+
+/**
+  * @brief  Draws BENCH_TEXT_STRINGS strings with every method and times each string until it is drawn
+  * @note   The strings fill the back buffer from the top, a screen for every method, which is then displayed.
+  * 		The timings reuse the samples of benchRun().
+  * @param  s : The Screen used to display the game
+  * @param  report : Where the statistics of the run are written
+  */
+void benchText(Screen *s, BenchTextReport *report)
+{
+	const uint32_t lineHeight = 24; //Font24, the font of platform.h
+	char text[32];
+
+	for(int method = 0; method < BENCH_TEXT_METHODS; method++)
+	{
+		uint32_t y = 0;
+
+		ct_screen_wait_backbuffer(s);
+		platformClear(COLOR_DARKBLUE);
+		platformWaitDrawing();
+		platformSetTextColor(COLOR_BLACK);
+		platformSetBackColor(method == BENCH_TEXT_TRANSPARENT ? COLOR_TRANSPARENT : COLOR_ORANGE);
+
+		for(int i = 0; i < BENCH_TEXT_STRINGS; i++)
+		{
+			//a line like the fps counter, different every time
+			snprintf(text, sizeof(text), "%3d FPS 1%% %3d max %2d.%d ms", i % 100, i % 60, i % 40, i % 10);
+			uint32_t start = platformCycles();
+			if(method == BENCH_TEXT_PER_PIXEL)
+				platformDrawStringPerPixel(0, y, text, PLATFORM_ALIGN_RIGHT);
+			else
+				platformDrawString(0, y, text, PLATFORM_ALIGN_RIGHT);
+			platformWaitDrawing();
+			samples[method][i] = platformCycles() - start;
+
+			y += lineHeight;
+			y = y + lineHeight > s->height ? 0 : y;
+		}
+
+		platformFlushPixels();
+		ct_screen_flip_buffers(s);
+	}
+
+	report->strings = BENCH_TEXT_STRINGS;
+	report->cyclesPerUs = platformCyclesPerUs();
+	for(int method = 0; method < BENCH_TEXT_METHODS; method++)
+		summarize(samples[method], BENCH_TEXT_STRINGS, &report->method[method]);
+}
+
+/**
+  * @brief  Writes a text report as a table with a row for each method, lines end with \r\n for the serial console
+  * @param  report : The report of benchText()
+  * @param  text : Where the table is written, it is always terminated
+  * @param  size : The size of text
+  * @return the number of characters written, without the terminator
+  */
+int benchTextFormat(const BenchTextReport *report, char *text, size_t size)
+{
+	size_t length = 0;
+
+	length += snprintf(text, size, "%lu strings, us per string:\r\n%-12s %9s %9s %9s\r\n",
+			(unsigned long)report->strings, "method", "min", "median", "p99");
+
+	for(int method = 0; method < BENCH_TEXT_METHODS && length < size; method++)
+	{
+		const BenchTiming *timing = &report->method[method];
+		length += snprintf(text + length, size - length, "%-12s", textMethodNames[method]);
+		if(length < size)
+			length += formatUs(text + length, size - length, timing->min, report->cyclesPerUs);
+		if(length < size)
+			length += formatUs(text + length, size - length, timing->median, report->cyclesPerUs);
+		if(length < size)
+			length += formatUs(text + length, size - length, timing->p99, report->cyclesPerUs);
+		if(length < size)
+			length += snprintf(text + length, size - length, "\r\n");
+	}
+
+	return length < size ? (int)length : (int)size - 1;
+}
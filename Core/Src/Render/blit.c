@@ -0,0 +1,486 @@
+/*
+ * blit.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/blit.h"
+#include "render/pixel.h"
+#include <string.h>
+
+#ifndef BLIT_MOCK
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "stm32f7xx_hal.h"
+
+#define BLIT_LOCK() taskENTER_CRITICAL()
+#define BLIT_UNLOCK() taskEXIT_CRITICAL()
+#else
+#define BLIT_LOCK()
+#define BLIT_UNLOCK()
+#endif
+
+//ring of the queued jobs, the job with sequence number n is stored in queue[n % BLIT_QUEUE_SIZE]
+static BlitJob queue[BLIT_QUEUE_SIZE];
+//sequence number of the last submitted job and of the last completed job, the first job is number 1
+static volatile uint32_t submitted;
+static volatile uint32_t completed;
+//true while the DMA2D is executing a job
+static volatile bool busy;
+//number of jobs ended with a transfer or configuration error
+static volatile uint32_t errors;
+
+#ifndef BLIT_MOCK
+//fence the waiting task is blocked on and semaphore given by the interrupt once it is reached
+static volatile uint32_t waitFence;
+static volatile bool waiting;
+static SemaphoreHandle_t fenceReached;
+#endif
+
+/**
+  * @brief  Programs the DMA2D registers for a job and starts it
+  * @note   Every register used by a job is written, so nothing has to be reset between two jobs
+  * 		even when the BSP used the DMA2D through the HAL in the meantime.
+  * @param  job : The job to start
+  */
+static void startJob(BlitJob *job)
+{
+#ifndef BLIT_MOCK
+	DMA2D->OPFCCR = job->format;
+	DMA2D->OMAR = (uint32_t)job->dst;
+	DMA2D->OOR = job->dstOffset;
+	DMA2D->NLR = (job->width << DMA2D_NLR_PL_Pos) | job->height;
+
+	if(job->op == BLIT_FILL)
+	{
+		DMA2D->OCOLR = job->color;
+		DMA2D->CR = DMA2D_R2M | DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE;
+	}
+	else if(job->op == BLIT_COPY)
+	{
+		DMA2D->FGMAR = (uint32_t)job->src;
+		DMA2D->FGOR = job->srcOffset;
+		DMA2D->FGPFCCR = job->format;
+		DMA2D->CR = DMA2D_M2M | DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE;
+	}
+	else if(job->op == BLIT_BLEND_A8)
+	{
+		//the foreground is the mask with the color of FGCOLR, its alpha scaled by the one of the color,
+		//the background is the destination itself
+		DMA2D->FGMAR = (uint32_t)job->src;
+		DMA2D->FGOR = job->srcOffset;
+		DMA2D->FGCOLR = job->color & 0x00FFFFFF;
+		DMA2D->FGPFCCR = DMA2D_INPUT_A8 | (DMA2D_COMBINE_ALPHA << DMA2D_FGPFCCR_AM_Pos) | (job->color & DMA2D_FGPFCCR_ALPHA);
+		DMA2D->BGMAR = (uint32_t)job->dst;
+		DMA2D->BGOR = job->dstOffset;
+		DMA2D->BGPFCCR = job->format;
+		DMA2D->CR = DMA2D_M2M_BLEND | DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE;
+	}
+	else
+	{
+		//the DMA2D reads every pixel before writing it, so source and destination can be the same
+		DMA2D->FGMAR = (uint32_t)job->dst;
+		DMA2D->FGOR = job->dstOffset;
+		DMA2D->FGPFCCR = DMA2D_INPUT_ARGB8888 | (DMA2D_REPLACE_ALPHA << DMA2D_FGPFCCR_AM_Pos) | (job->color & DMA2D_FGPFCCR_ALPHA);
+		DMA2D->CR = DMA2D_M2M_PFC | DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE;
+	}
+
+	DMA2D->CR |= DMA2D_CR_START;
+#else
+	(void)job;
+#endif
+}
+
+/**
+  * @brief  Adds a job to the queue, it starts it straight away if the DMA2D is idle
+  * @note   If the queue is full the caller waits for the oldest job to be completed.
+  * @param  job : The job to add, it is copied in the queue
+  * @return the sequence number of the job, it can be used as a fence
+  */
+static uint32_t submit(const BlitJob *job)
+{
+	uint32_t seq;
+
+	if(submitted - completed >= BLIT_QUEUE_SIZE)
+		ct_blit_wait(submitted - BLIT_QUEUE_SIZE + 1);
+
+	BLIT_LOCK();
+	seq = submitted + 1;
+	queue[seq % BLIT_QUEUE_SIZE] = *job;
+	submitted = seq;
+	if(!busy)
+	{
+		busy = true;
+		startJob(&queue[seq % BLIT_QUEUE_SIZE]);
+	}
+	BLIT_UNLOCK();
+
+	return seq;
+}
+
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_L8 || defined(BLIT_MOCK)
+/**
+  * @brief  Blends a color over an opaque or translucent ARGB8888 color, as the DMA2D does
+  * @param  dst : The color under
+  * @param  color : The color over, its alpha is ignored
+  * @param  alpha : The alpha of the color over, 1 to 255
+  * @return the blended color
+  */
+static inline uint32_t blendArgb(uint32_t dst, uint32_t color, uint32_t alpha)
+{
+	//0-255 to 0-256, so that the products are divided by a shift and 255 keeps the color as it is
+	uint32_t a = alpha + (alpha >> 7), na = 256 - a;
+	uint32_t rb = (((color & 0xFF00FF) * a + (dst & 0xFF00FF) * na) >> 8) & 0xFF00FF;
+	uint32_t g = (((color & 0x00FF00) * a + (dst & 0x00FF00) * na) >> 8) & 0x00FF00;
+	uint32_t da = dst >> 24;
+
+	return (alpha + da - alpha * da / 255) << 24 | rb | g;
+}
+
+/**
+  * @brief  Blends a color through an A8 mask over a rectangle of pixels with the CPU
+  * @note   A span blitter: the transparent pixels of the mask are skipped and the opaque ones written
+  * 		straight away, only the edges are blended. It executes the blends that the DMA2D can't do and
+  * 		the ones of the mock.
+  * @param  mask : The first alpha of the mask
+  * @param  maskOffset : The alphas between the end of a line of the mask and the start of the next one
+  * @param  dst : The first pixel of the rectangle
+  * @param  dstOffset : The pixels between the end of a line of the rectangle and the start of the next one
+  * @param  width : The width of the rectangle in pixel
+  * @param  height : The height of the rectangle in pixel
+  * @param  color : The ARGB8888 color, its alpha scales the one of the mask
+  */
+static void cpuBlend(const uint8_t *mask, uint32_t maskOffset, pixel_t *dst, uint32_t dstOffset, uint32_t width, uint32_t height, uint32_t color)
+{
+	uint32_t colorAlpha = color >> 24;
+	pixel_t pixel = pixelFromArgb(color);
+
+	for(uint32_t y = 0; y < height; y++, mask += width + maskOffset, dst += width + dstOffset)
+		for(uint32_t x = 0; x < width; x++)
+		{
+			uint32_t alpha = mask[x] * colorAlpha / 255;
+			if(alpha == 255)
+				dst[x] = pixel;
+			else if(alpha != 0)
+				dst[x] = pixelFromArgb(blendArgb(SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_ARGB8888 ? dst[x] : pixelToArgb(dst[x]), color, alpha));
+		}
+}
+#endif
+
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_L8
+/**
+  * @param  addr : The address of the first pixel of a rectangle
+  * @param  width : The width of the rectangle in pixel
+  * @param  offset : The pixels between the end of a line of the rectangle and the start of the next one
+  * @return true if the L8 rectangle can be handled by the DMA2D as a rectangle of RGB565 pixel pairs
+  */
+static bool pairable(uintptr_t addr, uint32_t width, uint32_t offset)
+{
+	return ((addr | width | offset) & 1) == 0;
+}
+
+/**
+  * @brief  Fills a rectangle with the CPU, once the jobs queued before it are completed
+  * @param  dst : The first pixel of the rectangle
+  * @param  width : The width of the rectangle in pixel
+  * @param  height : The height of the rectangle in pixel
+  * @param  dstOffset : The pixels between the end of a line of the rectangle and the start of the next one
+  * @param  pixel : The L8 pixel
+  */
+static void cpuFill(uint8_t *dst, uint32_t width, uint32_t height, uint32_t dstOffset, uint8_t pixel)
+{
+	ct_blit_wait(ct_blit_fence());
+	for(uint32_t y = 0; y < height; y++, dst += width + dstOffset)
+		memset(dst, pixel, width);
+#ifndef BLIT_MOCK
+	//the next jobs may read these pixels
+	SCB_CleanDCache();
+#endif
+}
+
+/**
+  * @brief  Copies a rectangle with the CPU, once the jobs queued before it are completed
+  * @param  src : The first pixel of the source rectangle
+  * @param  srcOffset : The pixels between the end of a line of the source and the start of the next one
+  * @param  dst : The first pixel of the destination rectangle
+  * @param  dstOffset : The pixels between the end of a line of the destination and the start of the next one
+  * @param  width : The width of the rectangle in pixel
+  * @param  height : The height of the rectangle in pixel
+  */
+static void cpuCopy(const uint8_t *src, uint32_t srcOffset, uint8_t *dst, uint32_t dstOffset, uint32_t width, uint32_t height)
+{
+	ct_blit_wait(ct_blit_fence());
+	for(uint32_t y = 0; y < height; y++, src += width + srcOffset, dst += width + dstOffset)
+		memcpy(dst, src, width);
+#ifndef BLIT_MOCK
+	SCB_CleanDCache();
+#endif
+}
+#endif
+
+/**
+  * @brief  Prepares the interrupt of the queue, it must be called after BSP_LCD_Init()
+  * @note   Jobs can be submitted before, they are completed by spinning on the fence. The BSP enables the DMA2D interrupt with priority 3, above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY:
+  * 		it is lowered here because the interrupt gives a semaphore.
+  */
+void ct_blit_init(void)
+{
+#ifndef BLIT_MOCK
+	fenceReached = xSemaphoreCreateBinary();
+	HAL_NVIC_SetPriority(DMA2D_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+#endif
+}
+
+/**
+  * @brief  Queues the fill of a rectangle with a color
+  * @param  dst : The first pixel of the rectangle
+  * @param  width : The width of the rectangle in pixel
+  * @param  height : The height of the rectangle in pixel
+  * @param  dstOffset : The pixels between the end of a line of the rectangle and the start of the next one
+  * @param  color : The ARGB8888 color, converted to the pixel format of the frame buffers
+  * @return the fence of the job
+  */
+uint32_t ct_blit_fill(void *dst, uint32_t width, uint32_t height, uint32_t dstOffset, uint32_t color)
+{
+	pixel_t pixel = pixelFromArgb(color);
+	BlitJob job = { .op = BLIT_FILL, .format = PIXEL_DMA2D_FORMAT, .dst = (uintptr_t)dst, .dstOffset = dstOffset,
+					.width = width, .height = height, .color = pixel };
+
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_L8
+	if(!pairable(job.dst, width, dstOffset))
+	{
+		cpuFill(dst, width, height, dstOffset, pixel);
+		return ct_blit_fence();
+	}
+	job.width /= 2;
+	job.dstOffset /= 2;
+	job.color = pixel | (pixel << 8);
+#endif
+	return submit(&job);
+}
+
+/**
+  * @brief  Queues the copy of a rectangle of pixels
+  * @param  src : The first pixel of the source rectangle
+  * @param  srcOffset : The pixels between the end of a line of the source and the start of the next one
+  * @param  dst : The first pixel of the destination rectangle
+  * @param  dstOffset : The pixels between the end of a line of the destination and the start of the next one
+  * @param  width : The width of the rectangle in pixel
+  * @param  height : The height of the rectangle in pixel
+  * @return the fence of the job
+  */
+uint32_t ct_blit_copy(const void *src, uint32_t srcOffset, void *dst, uint32_t dstOffset, uint32_t width, uint32_t height)
+{
+	BlitJob job = { .op = BLIT_COPY, .format = PIXEL_DMA2D_FORMAT, .src = (uintptr_t)src, .srcOffset = srcOffset,
+					.dst = (uintptr_t)dst, .dstOffset = dstOffset, .width = width, .height = height };
+
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_L8
+	if(!pairable(job.src, width, srcOffset) || !pairable(job.dst, width, dstOffset))
+	{
+		cpuCopy(src, srcOffset, dst, dstOffset, width, height);
+		return ct_blit_fence();
+	}
+	job.width /= 2;
+	job.srcOffset /= 2;
+	job.dstOffset /= 2;
+#endif
+	return submit(&job);
+}
+
+/**
+  * @brief  Queues the replacement of the alpha channel of every pixel of a rectangle
+  * @note   Only ARGB8888 pixels have an alpha channel, in the other formats nothing is queued.
+  * @param  dst : The first pixel of the rectangle
+  * @param  width : The width of the rectangle in pixel
+  * @param  height : The height of the rectangle in pixel
+  * @param  dstOffset : The pixels between the end of a line of the rectangle and the start of the next one
+  * @param  alpha : The new alpha
+  * @return the fence of the job
+  */
+uint32_t ct_blit_set_alpha(void *dst, uint32_t width, uint32_t height, uint32_t dstOffset, uint8_t alpha)
+{
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_ARGB8888
+	BlitJob job = { .op = BLIT_SET_ALPHA, .format = PIXEL_DMA2D_ARGB8888, .dst = (uintptr_t)dst, .dstOffset = dstOffset,
+					.width = width, .height = height, .color = (uint32_t)alpha << 24 };
+	return submit(&job);
+#else
+	(void)dst; (void)width; (void)height; (void)dstOffset; (void)alpha;
+	return ct_blit_fence();
+#endif
+}
+
+/**
+  * @brief  Queues the blend of a color through an A8 mask over a rectangle, e.g. to draw the glyphs of a text
+  * @note   The mask is read by the DMA2D: the CPU must have cleaned it from the D-cache. In L8 the blend is
+  * 		done by the CPU once the jobs queued before it are completed.
+  * @param  mask : The first alpha of the mask
+  * @param  maskOffset : The alphas between the end of a line of the mask and the start of the next one
+  * @param  dst : The first pixel of the rectangle
+  * @param  dstOffset : The pixels between the end of a line of the rectangle and the start of the next one
+  * @param  width : The width of the rectangle in pixel
+  * @param  height : The height of the rectangle in pixel
+  * @param  color : The ARGB8888 color, its alpha scales the one of the mask
+  * @return the fence of the job
+  */
+uint32_t ct_blit_blend_a8(const uint8_t *mask, uint32_t maskOffset, void *dst, uint32_t dstOffset, uint32_t width, uint32_t height, uint32_t color)
+{
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_L8
+	ct_blit_wait(ct_blit_fence());
+	cpuBlend(mask, maskOffset, dst, dstOffset, width, height, color);
+#ifndef BLIT_MOCK
+	SCB_CleanDCache();
+#endif
+	return ct_blit_fence();
+#else
+	BlitJob job = { .op = BLIT_BLEND_A8, .format = PIXEL_DMA2D_FORMAT, .src = (uintptr_t)mask, .srcOffset = maskOffset,
+					.dst = (uintptr_t)dst, .dstOffset = dstOffset, .width = width, .height = height, .color = color };
+	return submit(&job);
+#endif
+}
+
+/**
+  * @return the fence of the last submitted job: once it is reached every job submitted so far is completed
+  */
+uint32_t ct_blit_fence(void)
+{
+	return submitted;
+}
+
+/**
+  * @return the number of jobs ended with a transfer or configuration error since the start
+  */
+uint32_t ct_blit_errors(void)
+{
+	return errors;
+}
+
+/**
+  * @param  fence : A fence returned by one of the ct_blit functions
+  * @return true if the job of the fence and all the jobs before it have been completed
+  */
+bool ct_blit_done(uint32_t fence)
+{
+	//the difference handles the wrap around of the sequence numbers
+	return (int32_t)(completed - fence) >= 0;
+}
+
+/**
+  * @brief  Waits until a fence is reached
+  * @note   The calling task is blocked until the interrupt reports the fence, so other tasks can run in the
+  * 		meantime. Before the scheduler is started it polls the DMA2D instead.
+  * @param  fence : A fence returned by one of the ct_blit functions
+  */
+void ct_blit_wait(uint32_t fence)
+{
+#ifndef BLIT_MOCK
+	if(ct_blit_done(fence))
+		return;
+
+	//before the scheduler is started FreeRTOS keeps the interrupt masked: the flags are polled and handled here
+	if(xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+	{
+		while(!ct_blit_done(fence))
+		{
+			if(DMA2D->ISR & (DMA2D_ISR_TCIF | DMA2D_ISR_TEIF | DMA2D_ISR_CEIF))
+			{
+				HAL_NVIC_DisableIRQ(DMA2D_IRQn);
+				ct_blit_irq_handler();
+				HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+			}
+		}
+		return;
+	}
+
+	BLIT_LOCK();
+	waitFence = fence;
+	waiting = !ct_blit_done(fence);
+	BLIT_UNLOCK();
+
+	//the timeout only guards against a lost interrupt, a frame worth of jobs takes a few milliseconds
+	while(!ct_blit_done(fence))
+		xSemaphoreTake(fenceReached, pdMS_TO_TICKS(10));
+	waiting = false;
+#else
+	while(!ct_blit_done(fence) && ct_blit_mock_step());
+#endif
+}
+
+/**
+  * @brief  Completes the running job and starts the next one, it must be called by DMA2D_IRQHandler()
+  */
+void ct_blit_irq_handler(void)
+{
+#ifndef BLIT_MOCK
+	BaseType_t woken = pdFALSE;
+	uint32_t isr = DMA2D->ISR;
+
+	if(isr & (DMA2D_ISR_TEIF | DMA2D_ISR_CEIF))
+		errors++;
+	else if(!(isr & DMA2D_ISR_TCIF))
+		return;
+	DMA2D->IFCR = DMA2D_IFCR_CTCIF | DMA2D_IFCR_CTEIF | DMA2D_IFCR_CCEIF;
+#endif
+
+	completed++;
+	if(completed != submitted)
+		startJob(&queue[(completed + 1) % BLIT_QUEUE_SIZE]);
+	else
+		busy = false;
+
+#ifndef BLIT_MOCK
+	if(waiting && fenceReached != NULL && ct_blit_done(waitFence))
+	{
+		waiting = false;
+		xSemaphoreGiveFromISR(fenceReached, &woken);
+	}
+	portYIELD_FROM_ISR(woken);
+#endif
+}
+
+#ifdef BLIT_MOCK
+/**
+  * @brief  Executes the running job in software and completes it as the interrupt would do
+  * @return false if there was no job to execute
+  */
+bool ct_blit_mock_step(void)
+{
+	if(!busy)
+		return false;
+
+	BlitJob *job = &queue[(completed + 1) % BLIT_QUEUE_SIZE];
+	uint32_t bytes = job->format == PIXEL_DMA2D_ARGB8888 ? 4 : 2;
+	uint8_t *dst = (uint8_t*)job->dst;
+	const uint8_t *src = (const uint8_t*)job->src;
+	for(uint32_t y = 0; y < job->height; y++)
+	{
+		if(job->op == BLIT_FILL)
+			for(uint32_t x = 0; x < job->width; x++)
+			{
+				if(bytes == 4)
+					((uint32_t*)dst)[x] = job->color;
+				else
+					((uint16_t*)dst)[x] = job->color;
+			}
+		else if(job->op == BLIT_COPY)
+		{
+			memcpy(dst, src, job->width * bytes);
+			src += (job->width + job->srcOffset) * bytes;
+		}
+		else if(job->op == BLIT_BLEND_A8)
+		{
+			cpuBlend(src, 0, (pixel_t*)dst, 0, job->width, 1, job->color);
+			src += job->width + job->srcOffset;
+		}
+		else
+			for(uint32_t x = 0; x < job->width; x++)
+				((uint32_t*)dst)[x] = (((uint32_t*)dst)[x] & 0x00FFFFFF) | job->color;
+		dst += (job->width + job->dstOffset) * bytes;
+	}
+
+	ct_blit_irq_handler();
+	return true;
+}
+#endif
@@ -1,6 +1,21 @@
 #include "render/map.h"
+#include "render/texture.h"
+#include "platform/platform.h"
+#include <string.h>
 
-static int rawMap0[] = {
+//size of the maps of map.c, the border excluded
+#define RAW_MAP_X 20
+#define RAW_MAP_Y 12
+//bytes of the padded storage of a map of map.c: RAW_MAP_Y rows and the border, of 32 bytes (RAW_MAP_X + 2 rounded up)
+#define RAW_MAP_STORAGE ((RAW_MAP_Y + 2) * 32)
+
+const Material materials[MATERIAL_COUNT] = {
+	[BLOCK_FLOOR] = { COLOR_WHITE, COLOR_WHITE, COLOR_WHITE, TEXTURE_WALL, 0 },
+	[BLOCK_WALL] = { COLOR_GREEN, COLOR_BROWN, COLOR_DARKRED, TEXTURE_WALL, MATERIAL_OPAQUE | MATERIAL_SOLID },
+	[BLOCK_EXIT] = { COLOR_BLUE, COLOR_BLUE, COLOR_DARKBLUE, TEXTURE_EXIT, MATERIAL_OPAQUE | MATERIAL_EXIT },
+};
+
+static const uint8_t rawMap0[] = {
 	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
 	1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,
 	1,0,0,0,0,0,1,1,1,1,1,1,1,1,1,0,0,0,0,1,
@@ -15,7 +30,7 @@ static int rawMap0[] = {
 	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
 };
 
-static int rawMap1[] = {
+static const uint8_t rawMap1[] = {
 	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
 	1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,
 	1,0,0,1,1,1,1,1,0,1,0,1,0,0,0,0,0,1,1,1,
@@ -31,7 +46,7 @@ static int rawMap1[] = {
 };
 
 
-static int rawMap2[] = {
+static const uint8_t rawMap2[] = {
 	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,2,1,1,1,1,
 	1,0,0,0,1,1,1,1,1,1,1,1,1,0,1,0,1,0,1,1,
 	1,0,1,0,1,0,0,0,1,0,1,0,1,0,1,0,0,0,0,1,
@@ -46,8 +61,23 @@ static int rawMap2[] = {
 	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
 };
 
-static int* maps[] = { rawMap0, rawMap1, rawMap2 };
+static const uint8_t* rawMaps[MAP_COUNT] = { rawMap0, rawMap1, rawMap2 };
+//the maps in the padded format, imported from rawMaps by importMaps()
+static uint8_t storage[MAP_COUNT][RAW_MAP_STORAGE];
+static Map imported[MAP_COUNT];
 static int mapIndex = 0;
+//revision of the blocks of every map, raised by setMapBlock()
+static uint32_t revisions[MAP_SLOTS];
+
+/**
+  * @brief  Imports the maps of map.c in the padded format, it must be called before the tasks using them are
+  * 		started: then the maps are only read, loadMap() and getMap() can be called by any task
+  */
+void importMaps(void)
+{
+	for(int index = 0; index < MAP_COUNT; index++)
+		mapImport(&imported[index], storage[index], rawMaps[index], RAW_MAP_X, RAW_MAP_Y);
+}
 
 /**
   * @brief  It changes the current map set in the Map structure passed as a parameter with one the available in the map.c file
@@ -55,6 +85,111 @@ static int mapIndex = 0;
   */
 void changeMap(Map *m)
 {
-	m->map = maps[mapIndex++];
-	mapIndex = mapIndex == 3 ? 0 : mapIndex;
+	loadMap(m, mapIndex);
+}
+
+/**
+  * @brief  Sets a given map in the Map structure, the next changeMap() loads the one after it
+  * @param  m : The Map structure that we want to change
+  * @param  index : The number of the map, from 0 to MAP_COUNT-1
+  */
+void loadMap(Map *m, int index)
+{
+	getMap(m, index);
+	mapIndex = (index + 1) % MAP_COUNT;
+}
+
+/**
+  * @brief  Sets a given map in the Map structure like loadMap(), but leaves alone the map of the next changeMap()
+  * @note   It writes nothing but m, so a task other than the one of the game logic can use it, e.g. the benchmark.
+  * @param  m : The Map structure that we want to change
+  * @param  index : The number of the map, from 0 to MAP_COUNT-1
+  */
+void getMap(Map *m, int index)
+{
+	*m = imported[index];
+	m->index = index;
+	m->revision = revisions[index];
+}
+
+/**
+  * @brief  Changes a block of a map, the caches of its image, see minimap.h, are drawn again
+  * @note   The blocks are shared by all the copies of a Map structure, e.g. the snapshots of the game state,
+  * 		but only the one passed here gets the new revision: the others get it from the next copy.
+  * @param  m : The Map structure of the map
+  * @param  x : The column of the block
+  * @param  y : The row of the block
+  * @param  block : The new material of the block, a BlockId
+  */
+void setMapBlock(Map *m, int x, int y, uint8_t block)
+{
+	*mapBlockPtr(m, x, y) = block;
+	mapChanged(m);
+}
+
+/**
+  * @brief  Gives a new revision to a map whose blocks have been written without setMapBlock()
+  * @param  m : The Map structure of the map
+  */
+void mapChanged(Map *m)
+{
+	m->revision = ++revisions[m->index];
+}
+
+/**
+  * @return the shift of the padded rows of a map: the rows hold the map and the border at its sides
+  */
+static uint32_t pitchShift(int width)
+{
+	uint32_t shift = 0;
+	while((1 << shift) < width + 2)
+		shift++;
+	return shift;
+}
+
+/**
+  * @param  width : The number of blocks in a row of the map, the border excluded
+  * @param  height : The number of rows of the map, the border excluded
+  * @return the bytes of storage mapImport() needs for a map
+  */
+uint32_t mapStorageSize(int width, int height)
+{
+	return (uint32_t)(height + 2) << pitchShift(width);
+}
+
+/**
+  * @brief  Sets up a map in the padded format with every block, border and padding included, a BLOCK_WALL
+  * @param  m : The Map structure, its size and blocks are set
+  * @param  storage : Where the blocks are stored, mapStorageSize() bytes
+  * @param  width : The number of blocks in a row of the map, the border excluded
+  * @param  height : The number of rows of the map, the border excluded
+  */
+void mapInit(Map *m, uint8_t *storage, int width, int height)
+{
+	m->mapBlockX = width;
+	m->mapBlockY = height;
+	m->pitchShift = pitchShift(width);
+	m->blocks = storage + (1 << m->pitchShift) + 1;
+	memset(storage, BLOCK_WALL, mapStorageSize(width, height));
+}
+
+/**
+  * @brief  Sets up a map in the padded format from rows of blocks without a border, the format of map.c
+  * @note   The blocks are copied, the border and the padding of the rows are BLOCK_WALL, and so is any block
+  * 		whose value is not a material.
+  * @param  m : The Map structure, its size and blocks are set
+  * @param  storage : Where the blocks are stored, mapStorageSize() bytes
+  * @param  blocks : The rows of the map, width x height bytes
+  * @param  width : The number of blocks in a row of the map
+  * @param  height : The number of rows of the map
+  */
+void mapImport(Map *m, uint8_t *storage, const uint8_t *blocks, int width, int height)
+{
+	mapInit(m, storage, width, height);
+	for(int y = 0; y < height; y++)
+		for(int x = 0; x < width; x++)
+		{
+			uint8_t block = blocks[y * width + x];
+			*mapBlockPtr(m, x, y) = block < MATERIAL_COUNT ? block : BLOCK_WALL;
+		}
 }
@@ -0,0 +1,144 @@
+/*
+ * maze.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/maze.h"
+
+//value of a cell being carved: MAZE_BACK plus the direction of the cell it has been entered from
+#define MAZE_BACK MATERIAL_COUNT
+//value of the first cell while it is being carved, the backtracker stops there
+#define MAZE_ROOT (MAZE_BACK + 4)
+
+//the four directions: right, down, left, up; the opposite of d is (d + 2) & 3
+static const int8_t dirX[4] = { 1, 0, -1, 0 };
+static const int8_t dirY[4] = { 0, 1, 0, -1 };
+
+/**
+  * @brief  Advances a xorshift32 generator
+  * @param  state : The state of the generator, never 0
+  * @return the next number of the sequence
+  */
+static uint32_t nextRandom(uint32_t *state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+/**
+  * @return true if a block is a cell of the maze: odd coordinates and not on the outer rows or columns
+  */
+static bool isCell(const Map *m, int x, int y)
+{
+	return x >= 1 && y >= 1 && x < m->mapBlockX - 1 && y < m->mapBlockY - 1 && (x & y & 1);
+}
+
+/**
+  * @return the number of passages out of a carved cell
+  */
+static int passages(const Map *m, int x, int y)
+{
+	int count = 0;
+	for(int d = 0; d < 4; d++)
+		count += mapBlock(m, x + dirX[d], y + dirY[d]) == BLOCK_FLOOR;
+	return count;
+}
+
+/**
+  * @brief  Carves a perfect maze into a map of walls with the recursive backtracker
+  * @param  m : The map, all walls
+  * @param  random : The state of the random generator
+  */
+static void carve(Map *m, uint32_t *random)
+{
+	int x = 1, y = 1;
+
+	*mapBlockPtr(m, x, y) = MAZE_ROOT;
+	while(1)
+	{
+		int options[4], count = 0;
+		for(int d = 0; d < 4; d++)
+			if(isCell(m, x + 2*dirX[d], y + 2*dirY[d]) && mapBlock(m, x + 2*dirX[d], y + 2*dirY[d]) == BLOCK_WALL)
+				options[count++] = d;
+
+		if(count > 0)
+		{
+			int d = options[nextRandom(random) % count];
+			*mapBlockPtr(m, x + dirX[d], y + dirY[d]) = BLOCK_FLOOR;
+			x += 2*dirX[d];
+			y += 2*dirY[d];
+			*mapBlockPtr(m, x, y) = MAZE_BACK + ((d + 2) & 3);
+			continue;
+		}
+
+		//every neighbour has been visited: the cell is done, the walk goes back to the cell before it
+		uint8_t back = mapBlock(m, x, y);
+		*mapBlockPtr(m, x, y) = BLOCK_FLOOR;
+		if(back == MAZE_ROOT)
+			break;
+		x += 2*dirX[back - MAZE_BACK];
+		y += 2*dirY[back - MAZE_BACK];
+	}
+}
+
+/**
+  * @brief  Removes the dead ends of a perfect maze, opening a wall of each one
+  * @note   A wall towards another dead end is preferred, it removes two dead ends at once.
+  * @param  m : The map, a carved maze
+  * @param  random : The state of the random generator
+  */
+static void braid(Map *m, uint32_t *random)
+{
+	for(int y = 1; y < m->mapBlockY - 1; y += 2)
+		for(int x = 1; x < m->mapBlockX - 1; x += 2)
+		{
+			int walls[4], deadEnds[4], count = 0, deadCount = 0;
+			if(passages(m, x, y) != 1)
+				continue;
+
+			for(int d = 0; d < 4; d++)
+				if(mapBlock(m, x + dirX[d], y + dirY[d]) == BLOCK_WALL && isCell(m, x + 2*dirX[d], y + 2*dirY[d]))
+				{
+					walls[count++] = d;
+					if(passages(m, x + 2*dirX[d], y + 2*dirY[d]) == 1)
+						deadEnds[deadCount++] = d;
+				}
+
+			if(count == 0)
+				continue;
+			int d = deadCount > 0 ? deadEnds[nextRandom(random) % deadCount] : walls[nextRandom(random) % count];
+			*mapBlockPtr(m, x + dirX[d], y + dirY[d]) = BLOCK_FLOOR;
+		}
+}
+
+/**
+  * @brief  Builds a maze into a map, the map gets the index MAP_GENERATED and a new revision
+  * @param  m : The Map structure, its size and blocks are set
+  * @param  storage : Where the blocks are stored, mapStorageSize() bytes for the size of the maze
+  * @param  width : The number of blocks in a row, from MAZE_MIN_SIZE to MAZE_MAX_SIZE
+  * @param  height : The number of rows, from MAZE_MIN_SIZE to MAZE_MAX_SIZE
+  * @param  seed : The seed of the maze
+  * @param  style : The kind of maze
+  */
+void mazeGenerate(Map *m, uint8_t *storage, int width, int height, uint32_t seed, MazeStyle style)
+{
+	//the golden ratio spreads the small seeds over the whole state, which must not be 0
+	uint32_t random = seed * 0x9E3779B9u;
+	random = random != 0 ? random : 1;
+
+	mapInit(m, storage, width, height);
+	m->index = MAP_GENERATED;
+
+	carve(m, &random);
+	if(style == MAZE_BRAIDED)
+		braid(m, &random);
+	//the right wall of the last cell of the bottom row
+	*mapBlockPtr(m, ((width - 3) | 1) + 1, (height - 3) | 1) = BLOCK_EXIT;
+
+	mapChanged(m);
+}
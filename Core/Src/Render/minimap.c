@@ -0,0 +1,91 @@
+/*
+ * minimap.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/minimap.h"
+#include "render/raster.h"
+#include "render/blit.h"
+#include "render/vram.h"
+
+static MinimapCache caches[MAP_SLOTS];
+
+/**
+  * @brief  Draws the image of a map into its cache, the buffer is allocated the first time
+  * @note   The buffer is as large as the largest image of the screen, getMapRect() of a map with a single block
+  * 		is at most s->width/MAP_SCALE + 1 x s->height/MAP_SCALE + 1 pixels, so the maps loaded at run time
+  * 		into a slot of any size fit in the same buffer: the SDRAM is never freed.
+  * @param  c : The cache
+  * @param  m : The map
+  * @param  s : The Screen used to display the game
+  * @param  rect : The area of the screen covered by the map, see getMapRect()
+  * @return false if there is no SDRAM left for the image
+  */
+static bool drawImage(MinimapCache *c, Map *m, Screen *s, Rect rect)
+{
+	int yInc = s->height/(m->mapBlockY*MAP_SCALE);
+	int xInc = s->width/(m->mapBlockX*MAP_SCALE);
+	//blocks of a pixel or two have no room for an outline
+	int inset = xInc > 2 && yInc > 2 ? 1 : 0;
+	//every row starts 8 byte aligned, as rasterFillSpan() wants
+	uint32_t stride = (rect.width + 7) & ~7u;
+
+	if(c->image == NULL)
+	{
+		uint32_t size = ((s->width/MAP_SCALE + 1 + 7) & ~7u) * (s->height/MAP_SCALE + 1);
+		c->image = vramAlloc(size * PIXEL_BYTES);
+		c->size = c->image != NULL ? size : 0;
+		c->blocks = NULL;
+	}
+	if(stride * rect.height > c->size)
+		return false;
+
+	//the last copy of the old image may still be running
+	ct_blit_wait(c->fence);
+	c->stride = stride;
+	c->rect = rect;
+
+	rasterFillSpan(c->image, stride, rect.width, rect.height, pixelFromArgb(MINIMAP_OUTLINE_COLOR));
+	for(int y = 0; y < m->mapBlockY; y++)
+		for(int x = 0; x < m->mapBlockX; x++)
+		{
+			uint32_t color = materials[mapBlock(m, x, y)].mapColor;
+			if(color != MINIMAP_OUTLINE_COLOR)
+				rasterFillSpan(c->image + (y*yInc + inset) * stride + x*xInc + inset, stride, xInc - inset, yInc - inset,
+						pixelFromArgb(color));
+		}
+
+	//the image is read by the DMA2D
+	platformFlushPixels();
+	c->blocks = m->blocks;
+	c->revision = m->revision;
+	return true;
+}
+
+/**
+  * @brief  Queues the copy of the image of a map to a frame buffer, the image is drawn first if the map changed
+  * @note   Nothing is drawn if the map has no index, if it has more blocks than the pixels of its area of the
+  * 		screen (see getMapRect()) or if there is no room for its image.
+  * @param  m : The map
+  * @param  s : The Screen used to display the game
+  * @param  dst : The frame buffer, as large as the screen
+  * @return the fence of the copy
+  */
+uint32_t minimapDraw(Map *m, Screen *s, pixel_t *dst)
+{
+	Rect rect = getMapRect(m, s);
+
+	if(m->index < 0 || m->index >= MAP_SLOTS || rect.width == 0)
+		return ct_blit_fence();
+
+	MinimapCache *c = &caches[m->index];
+	bool stale = c->blocks != m->blocks || c->revision != m->revision || c->rect.width != rect.width || c->rect.height != rect.height;
+	if(stale && !drawImage(c, m, s, rect))
+		return ct_blit_fence();
+
+	c->fence = ct_blit_copy(c->image, c->stride - rect.width, dst + rect.y * s->width + rect.x, s->width - rect.width,
+			rect.width, rect.height);
+	return c->fence;
+}
@@ -0,0 +1,276 @@
+/*
+ * overlay.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/overlay.h"
+#include "render/blit.h"
+#include "render/vram.h"
+#include "stm32f769i_discovery_lcd.h"
+
+//the BSP draws into the frame buffer of its active layer: the HUD cache is handed to it through this handle
+extern LTDC_HandleTypeDef hltdc_discovery;
+
+static Overlay overlays[OVERLAY_MAX];
+static int overlayCount = 0;
+//full screen buffer holding the last drawn content of every overlay at its screen coordinates
+static pixel_t *hudCache;
+static uint32_t hudWidth;
+//mode in use and mode requested with ct_overlay_set_mode(), applied by the next ct_overlay_composite()
+static OverlayMode mode = OVERLAY_COPY;
+static volatile OverlayMode requestedMode = OVERLAY_COPY;
+//the HUD layer has been configured once
+static bool layerReady = false;
+//the HUD layer is shown by the LTDC, in OVERLAY_LAYER mode
+static bool layerShown = false;
+
+/**
+  * @brief  Enables or disables the HUD layer from the next vertical blanking
+  * @param  enable : true to show the layer
+  */
+static void setLayerEnable(bool enable)
+{
+	if(enable)
+		LTDC_Layer2->CR |= LTDC_LxCR_LEN;
+	else
+		LTDC_Layer2->CR &= ~LTDC_LxCR_LEN;
+	LTDC->SRCR = LTDC_SRCR_VBR;
+}
+
+/**
+  * @brief  Makes the rectangles of an overlay transparent in the HUD layer
+  * @param  o : The overlay
+  */
+static void clearOverlay(Overlay *o)
+{
+	for(uint32_t r = 0; r < o->rectCount; r++)
+	{
+		Rect *rect = &o->rects[r];
+		ct_blit_fill(hudCache + rect->y * hudWidth + rect->x, rect->width, rect->height,
+				hudWidth - rect->width, OVERLAY_KEY_COLOR);
+	}
+	o->shown = false;
+}
+
+/**
+  * @brief  Switches between OVERLAY_COPY and OVERLAY_LAYER mode
+  * @param  m : The new mode
+  */
+static void applyMode(OverlayMode m)
+{
+	mode = m;
+	for(int i = 0; i < overlayCount; i++)
+	{
+		overlays[i].dirty = true;
+		overlays[i].shown = false;
+	}
+
+	if(mode == OVERLAY_LAYER)
+	{
+		ct_blit_fill(hudCache, hudWidth, BSP_LCD_GetYSize(), 0, OVERLAY_KEY_COLOR);
+		if(!layerReady)
+		{
+			//the layer blends with the per pixel alpha of the cache, the key color is transparent:
+			//only ARGB8888 has a per pixel alpha, in the other formats the overlays are opaque
+			ct_blit_wait(ct_blit_fence());
+			BSP_LCD_LayerDefaultInit(1, (uint32_t)hudCache);
+			ct_screen_load_clut(1);
+			BSP_LCD_SetTransparency(1, 255);
+			BSP_LCD_SetColorKeying(1, OVERLAY_KEY_COLOR);
+			layerReady = true;
+		}
+		layerShown = true;
+	}
+	else
+		layerShown = false;
+
+	setLayerEnable(layerShown);
+}
+
+/**
+  * @brief  Allocates the HUD cache, it must be called once after ct_screen_init()
+  * @param  s : The Screen used to display the game
+  */
+void ct_overlay_init(Screen *s)
+{
+	hudWidth = s->width;
+	hudCache = vramAlloc(s->width * s->height * PIXEL_BYTES);
+}
+
+/**
+  * @brief  Registers an overlay, it starts visible, opaque and dirty
+  * @param  draw : The function drawing the overlay
+  * @param  rects : The rectangles covered by the overlay
+  * @param  rectCount : The number of rectangles, at most OVERLAY_MAX_RECTS
+  * @return the id of the overlay, -1 if there is no room for it
+  */
+int ct_overlay_add(OverlayDraw draw, const Rect *rects, uint32_t rectCount)
+{
+	if(overlayCount == OVERLAY_MAX)
+		return -1;
+
+	int id = overlayCount++;
+	overlays[id].draw = draw;
+	overlays[id].visible = true;
+	overlays[id].shown = false;
+	overlays[id].alpha = 255;
+	ct_overlay_set_rects(id, rects, rectCount);
+	return id;
+}
+
+/**
+  * @brief  Changes the rectangles covered by an overlay, e.g. when a label changes length, and marks it dirty
+  * @param  id : The id of the overlay
+  * @param  rects : The rectangles covered by the overlay
+  * @param  rectCount : The number of rectangles, at most OVERLAY_MAX_RECTS
+  */
+void ct_overlay_set_rects(int id, const Rect *rects, uint32_t rectCount)
+{
+	Overlay *o = &overlays[id];
+
+	//in OVERLAY_LAYER mode the old rectangles would stay on display
+	if(mode == OVERLAY_LAYER && o->shown)
+		clearOverlay(o);
+
+	if(rectCount > OVERLAY_MAX_RECTS)
+		rectCount = OVERLAY_MAX_RECTS;
+	for(uint32_t i = 0; i < rectCount; i++)
+		o->rects[i] = rects[i];
+	o->rectCount = rectCount;
+	o->dirty = true;
+}
+
+/**
+  * @brief  Marks an overlay as changed, it is drawn again into the cache by the next ct_overlay_composite()
+  * @param  id : The id of the overlay
+  */
+void ct_overlay_invalidate(int id)
+{
+	overlays[id].dirty = true;
+}
+
+/**
+  * @param  id : The id of the overlay
+  * @param  visible : true to composite the overlay on the frames, false to hide it
+  */
+void ct_overlay_set_visible(int id, bool visible)
+{
+	overlays[id].visible = visible;
+}
+
+/**
+  * @brief  Sets the opacity of an overlay in OVERLAY_LAYER mode, in OVERLAY_COPY mode overlays are always opaque
+  * @param  id : The id of the overlay
+  * @param  alpha : 0 is transparent, 255 is opaque
+  */
+void ct_overlay_set_alpha(int id, uint8_t alpha)
+{
+	overlays[id].alpha = alpha;
+	overlays[id].dirty = true;
+}
+
+/**
+  * @brief  Requests the way overlays are composited, it can be called by any task
+  * @param  m : The mode, applied by the next ct_overlay_composite()
+  */
+void ct_overlay_set_mode(OverlayMode m)
+{
+	requestedMode = m;
+}
+
+/**
+  * @return the last requested mode
+  */
+OverlayMode ct_overlay_get_mode(void)
+{
+	return requestedMode;
+}
+
+/**
+  * @brief  Shows or hides the whole HUD layer in OVERLAY_LAYER mode, e.g. while a full screen page is displayed
+  * @note   It does nothing in OVERLAY_COPY mode: the overlays are simply not composited on such pages.
+  * @param  show : true to show the HUD layer
+  */
+void ct_overlay_show_layer(bool show)
+{
+	if(mode != OVERLAY_LAYER || show == layerShown)
+		return;
+
+	layerShown = show;
+	setLayerEnable(show);
+}
+
+/**
+  * @brief  Brings the overlays on the frame being drawn
+  * @note   In OVERLAY_COPY mode the dirty visible overlays are drawn into the HUD cache, then every visible overlay
+  * 		is copied to the back buffer: the copies are queued on the DMA2D, whatever is drawn afterwards by the
+  * 		BSP lands on top of them. In OVERLAY_LAYER mode only the overlays that changed are drawn into the cache
+  * 		or cleared from it, nothing is copied.
+  * @param  s : The Screen used to display the game
+  */
+void ct_overlay_composite(Screen *s)
+{
+	pixel_t *back = ct_screen_backbuffer_ptr(s);
+	bool drawn = false;
+
+	if(requestedMode != mode)
+		applyMode(requestedMode);
+
+	for(int i = 0; i < overlayCount; i++)
+	{
+		Overlay *o = &overlays[i];
+
+		if(!o->visible)
+		{
+			if(mode == OVERLAY_LAYER && o->shown)
+				clearOverlay(o);
+			continue;
+		}
+
+		if(!o->dirty && (mode == OVERLAY_COPY || o->shown))
+			continue;
+
+		hltdc_discovery.LayerCfg[0].FBStartAdress = (uint32_t)hudCache;
+		o->draw();
+		o->dirty = false;
+		drawn = true;
+
+		if(mode == OVERLAY_LAYER)
+		{
+			if(o->alpha != 255)
+				for(uint32_t r = 0; r < o->rectCount; r++)
+				{
+					Rect *rect = &o->rects[r];
+					ct_blit_set_alpha(hudCache + rect->y * hudWidth + rect->x, rect->width, rect->height,
+							hudWidth - rect->width, o->alpha);
+				}
+			o->shown = true;
+		}
+	}
+
+	if(drawn)
+	{
+		hltdc_discovery.LayerCfg[0].FBStartAdress = (uint32_t)back;
+		//the lines and the outlines of the overlays are drawn by the CPU: they must reach the SDRAM before the DMA2D copies them
+		SCB_CleanDCache();
+	}
+
+	if(mode == OVERLAY_LAYER)
+		return;
+
+	for(int i = 0; i < overlayCount; i++)
+	{
+		if(!overlays[i].visible)
+			continue;
+
+		for(uint32_t r = 0; r < overlays[i].rectCount; r++)
+		{
+			Rect *rect = &overlays[i].rects[r];
+			uint32_t offset = rect->y * s->width + rect->x;
+			ct_blit_copy(hudCache + offset, s->width - rect->width, back + offset, s->width - rect->width,
+					rect->width, rect->height);
+		}
+	}
+}
@@ -0,0 +1,236 @@
+/*
+ * raster.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/raster.h"
+#include <stdlib.h>
+
+//an edge of a triangle walked a row at a time
+typedef struct {
+	int64_t x; //Q16.16 x coordinate of the edge at the center of the current row
+	int64_t slope; //change of x from a row to the next
+} Edge;
+
+/**
+  * @brief  Fills a span of rows of a column of the frame buffer with a single color
+  * @note   Once the destination is 8 byte aligned the pixels are written in groups with a single 64 bit store
+  * 		(2, 4 or 8 of them according to the pixel format), so a narrow column costs one or two stores per row.
+  * @param  dst : The first pixel of the span
+  * @param  stride : The distance in pixel between two rows of the frame buffer
+  * @param  width : The width of the column in pixel
+  * @param  rows : The number of rows of the span
+  * @param  color : The color of the span, in the pixel format of the frame buffer
+  * @return the first pixel of the row below the span
+  */
+pixel_t* rasterFillSpan(pixel_t *dst, int stride, int width, int rows, pixel_t color)
+{
+	const int wordPixels = 8 / PIXEL_BYTES;
+	uint64_t word = color;
+	for(unsigned bytes = PIXEL_BYTES; bytes < 8; bytes *= 2)
+		word |= word << (bytes * 8);
+
+	if(width == 1)
+	{
+		for(int y = 0; y < rows; y++, dst += stride)
+			*dst = color;
+		return dst;
+	}
+
+	//a row of the screen is a multiple of 8 bytes, so every row has the same alignment of the first one
+	int lead = ((8 - ((uintptr_t)dst & 7)) & 7) / PIXEL_BYTES;
+	if(lead > width)
+		lead = width;
+	for(int y = 0; y < rows; y++, dst += stride)
+	{
+		pixel_t *p = dst;
+		int x = width - lead;
+		for(int i = 0; i < lead; i++)
+			*p++ = color;
+		for(; x >= wordPixels; x -= wordPixels, p += wordPixels)
+			*(uint64_t*)p = word;
+		while(x-- > 0)
+			*p++ = color;
+	}
+	return dst;
+}
+
+static int ceilDiv(int a, int b)
+{
+	return a >= 0 ? (a + b - 1) / b : -(-a / b);
+}
+
+static int floorDiv(int a, int b)
+{
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/**
+  * @brief  Draws a line clipped to the target, both ends included
+  * @note   The line is walked along its major axis, the error term of Bresenham decides when to move along the
+  * 		other one. The steps of the line that fall inside the clip rectangle are found beforehand, along the
+  * 		major axis and then from the error term along the minor one, so the clipped line has exactly the
+  * 		pixels of the whole line that are inside the rectangle.
+  * @param  t : The frame buffer and the clip rectangle
+  * @param  x0 : The x coordinate of the first end
+  * @param  y0 : The y coordinate of the first end
+  * @param  x1 : The x coordinate of the second end
+  * @param  y1 : The y coordinate of the second end
+  * @param  color : The color of the line, in the pixel format of the frame buffer
+  */
+void rasterLine(const RasterTarget *t, int x0, int y0, int x1, int y1, pixel_t color)
+{
+	int left = t->clip.x, right = t->clip.x + t->clip.width - 1;
+	int top = t->clip.y, bottom = t->clip.y + t->clip.height - 1;
+	int dx = abs(x1 - x0), dy = abs(y1 - y0);
+	int sx = x1 >= x0 ? 1 : -1, sy = y1 >= y0 ? 1 : -1;
+
+	//the clip rectangle as distances from the first end, counted in the direction of the line
+	int xFirst = sx > 0 ? left - x0 : x0 - right, xLast = sx > 0 ? right - x0 : x0 - left;
+	int yFirst = sy > 0 ? top - y0 : y0 - bottom, yLast = sy > 0 ? bottom - y0 : y0 - top;
+
+	bool steep = dy > dx;
+	int major = steep ? dy : dx, minor = steep ? dx : dy;
+	int majorFirst = steep ? yFirst : xFirst, majorLast = steep ? yLast : xLast;
+	int minorFirst = steep ? xFirst : yFirst, minorLast = steep ? xLast : yLast;
+	int majorStep = steep ? sy * (int)t->stride : sx, minorStep = steep ? sx : sy * (int)t->stride;
+
+	if(major == 0)
+	{
+		if(xFirst <= 0 && xLast >= 0 && yFirst <= 0 && yLast >= 0)
+			t->buffer[y0 * t->stride + x0] = color;
+		return;
+	}
+
+	//after k steps the line has moved (2*minor*k + major) / (2*major) pixels along the minor axis
+	int first = majorFirst > 0 ? majorFirst : 0;
+	int last = majorLast < major ? majorLast : major;
+	if(minor > 0)
+	{
+		int minorIn = ceilDiv(2 * major * minorFirst - major, 2 * minor);
+		int minorOut = floorDiv(2 * major * (minorLast + 1) - major - 1, 2 * minor);
+		first = minorIn > first ? minorIn : first;
+		last = minorOut < last ? minorOut : last;
+	}
+	else if(minorFirst > 0 || minorLast < 0)
+		return;
+	if(first > last)
+		return;
+
+	int error = 2 * minor * first + major;
+	int moved = error / (2 * major);
+	error %= 2 * major;
+
+	pixel_t *p = t->buffer + y0 * (int)t->stride + x0 + first * majorStep + moved * minorStep;
+	for(int k = first; k <= last; k++)
+	{
+		*p = color;
+		p += majorStep;
+		error += 2 * minor;
+		if(error >= 2 * major)
+		{
+			error -= 2 * major;
+			p += minorStep;
+		}
+	}
+}
+
+/**
+  * @return the first row or column whose center is at or after a Q16.16 coordinate
+  */
+static int64_t cellAt(int64_t v)
+{
+	return (v - FIXED_HALF + FIXED_ONE - 1) >> FIXED_SHIFT;
+}
+
+/**
+  * @brief  Starts walking the edge from a to b at the center of a row, a must be above b
+  */
+static void edgeStart(Edge *e, RasterPoint a, RasterPoint b, int row)
+{
+	fixed y = FIXED_FROM_INT(row) + FIXED_HALF;
+
+	e->slope = (int64_t)(b.x - a.x) * FIXED_ONE / (b.y - a.y);
+	e->x = a.x + (((int64_t)(y - a.y) * e->slope) >> FIXED_SHIFT);
+}
+
+/**
+  * @brief  Fills the rows of a triangle between two of its edges, the rows must be inside the clip rectangle
+  * @param  t : The frame buffer and the clip rectangle
+  * @param  a : An edge, at the center of the first row
+  * @param  b : The other edge, at the center of the first row
+  * @param  first : The first row
+  * @param  end : The row after the last one
+  * @param  color : The color, in the pixel format of the frame buffer
+  */
+static void fillRows(const RasterTarget *t, Edge *a, Edge *b, int first, int end, pixel_t color)
+{
+	int64_t left = t->clip.x, right = t->clip.x + t->clip.width;
+	pixel_t *row = t->buffer + first * t->stride;
+
+	for(int y = first; y < end; y++, row += t->stride)
+	{
+		int64_t x0 = cellAt(a->x < b->x ? a->x : b->x), x1 = cellAt(a->x < b->x ? b->x : a->x);
+
+		x0 = x0 < left ? left : x0;
+		x1 = x1 > right ? right : x1;
+		if(x1 > x0)
+			rasterFillSpan(row + x0, t->stride, x1 - x0, 1, color);
+		a->x += a->slope;
+		b->x += b->slope;
+	}
+}
+
+/**
+  * @brief  Fills a triangle clipped to the target: the pixels whose center is inside it
+  * @note   The edges are walked from the top vertex, the upper part of the triangle ends at the row of the
+  * 		middle vertex where the lower part starts. The centers on the top or left edge of the triangle are
+  * 		inside it, the ones on the bottom or right edge are not.
+  */
+static void fillTriangle(const RasterTarget *t, RasterPoint a, RasterPoint b, RasterPoint c, pixel_t color)
+{
+	RasterPoint swap;
+	Edge longEdge, shortEdge;
+	int top = t->clip.y, bottom = t->clip.y + t->clip.height;
+
+	if(b.y < a.y) { swap = a; a = b; b = swap; }
+	if(c.y < b.y) { swap = b; b = c; c = swap; }
+	if(b.y < a.y) { swap = a; a = b; b = swap; }
+
+	int first = cellAt(a.y), middle = cellAt(b.y), end = cellAt(c.y);
+	first = first < top ? top : first;
+	end = end > bottom ? bottom : end;
+	if(first >= end)
+		return;
+	middle = middle < first ? first : middle > end ? end : middle;
+
+	edgeStart(&longEdge, a, c, first);
+	if(first < middle)
+	{
+		edgeStart(&shortEdge, a, b, first);
+		fillRows(t, &longEdge, &shortEdge, first, middle, color);
+	}
+	if(middle < end)
+	{
+		edgeStart(&shortEdge, b, c, middle);
+		fillRows(t, &longEdge, &shortEdge, middle, end, color);
+	}
+}
+
+/**
+  * @brief  Fills a fan of triangles clipped to the target: the triangles of the center with every two consecutive points
+  * @note   The fan of the rays of a frame is the area seen by the player, it is filled with a single pass over
+  * 		the rows of each triangle and no pixel of it is written twice.
+  * @param  t : The frame buffer and the clip rectangle
+  * @param  center : The vertex shared by the triangles
+  * @param  points : The other vertices, in order around the center
+  * @param  count : The number of points, count - 1 triangles are filled
+  * @param  color : The color of the fan, in the pixel format of the frame buffer
+  */
+void rasterFan(const RasterTarget *t, RasterPoint center, const RasterPoint *points, int count, pixel_t color)
+{
+	for(int i = 0; i + 1 < count; i++)
+		fillTriangle(t, center, points[i], points[i + 1], color);
+}
@@ -0,0 +1,286 @@
+/*
+ * raycast.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/raycast.h"
+#include <math.h>
+
+//number of table entries in a quarter of turn, the other three quarters are obtained by symmetry
+#define QUARTER_STEPS (1 << (RAYCAST_TABLE_BITS - 2))
+//largest distance the DDA works with, it stands for infinity when a ray runs parallel to a grid axis:
+//32768 world units, 512 blocks, farther than the diagonal of the largest maze of maze.h
+#define FIXED_INF ((uint32_t)1 << 31)
+//a hit on a grid line crossed going left or up is moved this much inside the hit block: 1/512 of a pixel, the
+//resolution of a float position up to 32768, so the pos of a ray is inside the hit block once converted to float
+#define HIT_EPSILON 128
+
+//sin of the first quarter of turn in Q2.30, the extra precision is kept for the interpolation
+static int32_t sinTable[QUARTER_STEPS + 2];
+//cutoff of the rays in blocks and in Q16.16 world units, FIXED_INF when there is none
+static int maxBlocks = RAYCAST_MAX_BLOCKS;
+static uint32_t maxDistance = (uint32_t)(RAYCAST_MAX_BLOCKS * MAP_BLOCK_SIZE) << FIXED_SHIFT;
+
+/**
+  * @brief  Multiplies two non negative Q16.16 numbers saturating the result to FIXED_INF
+  * @param  a : The first factor
+  * @param  b : The second factor
+  * @return a*b in Q16.16, at most FIXED_INF
+  */
+static inline uint32_t fixedMulSat(uint32_t a, uint32_t b)
+{
+	uint64_t p = ((uint64_t)a * b) >> FIXED_SHIFT;
+	return p > FIXED_INF ? FIXED_INF : (uint32_t)p;
+}
+
+/**
+  * @return v limited to the range from low to high
+  */
+static inline fixed fixedClamp(fixed v, fixed low, fixed high)
+{
+	return v < low ? low : v > high ? high : v;
+}
+
+/**
+  * @brief  Looks up the sin of an angle interpolating between the two nearest entries of sinTable
+  * @note   The quarter of turn stored in sinTable is unfolded on the whole turn by symmetry. The linear
+  * 		interpolation error is below the resolution of Q16.16, so the direction of a ray is as precise
+  * 		as the format allows instead of being snapped to the 2^RAYCAST_TABLE_BITS table angles.
+  * @param  a : The binary angle
+  * @return the sin in Q16.16
+  */
+static fixed sinLookup(angle_t a)
+{
+	uint32_t quarter = a >> 30;
+	uint32_t pos = a & 0x3FFFFFFF; //position inside the quarter of turn
+	if(quarter & 1)
+		pos = 0x40000000 - pos;
+
+	uint32_t i = pos >> (32 - RAYCAST_TABLE_BITS);
+	int32_t frac = (pos >> (16 - RAYCAST_TABLE_BITS)) & 0xFFFF; //weight of the next entry in Q0.16
+	int32_t s = sinTable[i] + (int32_t)(((int64_t)(sinTable[i+1] - sinTable[i]) * frac) >> 16);
+	s = (s + (1 << 13)) >> 14; //Q2.30 to Q16.16
+
+	return quarter & 2 ? -s : s;
+}
+
+/**
+  * @brief  Computes the distance travelled along a ray to cross one unit on an axis
+  * @note   This is 1/|d| where d is the ray direction component on that axis, one hardware division
+  * @param  d : The ray direction component in Q16.16
+  * @return 1/|d| in Q16.16, saturated to FIXED_INF
+  */
+static inline uint32_t stepLength(fixed d)
+{
+	uint32_t ad = d < 0 ? -d : d;
+	if(ad <= 0xFFFFFFFFu / FIXED_INF)
+		return FIXED_INF;
+	return 0xFFFFFFFFu / ad;
+}
+
+/**
+  * @brief  Fills the sin table, it must be called once before casting any ray
+  */
+void raycastInit(void)
+{
+	for(int i = 0; i <= QUARTER_STEPS + 1; i++)
+		sinTable[i] = (int32_t)lround(sin(i * (M_PI / 2) / QUARTER_STEPS) * (1 << 30));
+}
+
+/**
+  * @brief  Converts an angle in radians to a binary angle
+  * @param  radians : The angle in radians, it doesn't need to be in the [0, 2*PI) range
+  * @return the binary angle
+  */
+angle_t raycastAngle(float radians)
+{
+	return (angle_t)(int64_t)(radians * (float)(4294967296.0 / (2 * M_PI)));
+}
+
+/**
+  * @brief  Converts a binary angle to radians
+  * @param  a : The binary angle
+  * @return the angle in radians in the [0, 2*PI) range
+  */
+float raycastRadians(angle_t a)
+{
+	return a * (float)(2 * M_PI / 4294967296.0);
+}
+
+/**
+  * @param  a : The binary angle
+  * @return the sin of the angle in Q16.16
+  */
+fixed raycastSin(angle_t a)
+{
+	return sinLookup(a);
+}
+
+/**
+  * @param  a : The binary angle
+  * @return the cos of the angle in Q16.16
+  */
+fixed raycastCos(angle_t a)
+{
+	return sinLookup(a + 0x40000000);
+}
+
+/**
+  * @brief  Sets how far the rays go: a ray that meets no wall within this distance is a miss, so the cost of a
+  * 		ray stays bounded on the large maps
+  * @note   Without the cutoff a ray still stops at RAYCAST_RANGE_BLOCKS, the largest distance the DDA works with.
+  * @param  blocks : The distance in blocks, measured as the one of the rays; 0, or RAYCAST_RANGE_BLOCKS and more,
+  * 		for no cutoff
+  */
+void raycastSetMaxBlocks(int blocks)
+{
+	maxBlocks = blocks > 0 && blocks < RAYCAST_RANGE_BLOCKS ? blocks : 0;
+	maxDistance = maxBlocks > 0 ? (uint32_t)(maxBlocks * MAP_BLOCK_SIZE) << FIXED_SHIFT : FIXED_INF;
+}
+
+/**
+  * @return the cutoff of the rays in blocks, 0 if there is none
+  */
+int raycastGetMaxBlocks(void)
+{
+	return maxBlocks;
+}
+
+/**
+  * @brief  Casts a single ray in the direction of a binary angle
+  * @param  x : The starting point x coordinate of the ray in Q16.16
+  * @param  y : The starting point y coordinate of the ray in Q16.16
+  * @param  a : The direction of the ray
+  * @param  m : The map currently active in the game
+  * @param  r : The ray to fill, every field but index and perpDistance is written
+  */
+void raycastCast(fixed x, fixed y, angle_t a, Map *m, Ray *r)
+{
+	raycastCastDir(x, y, raycastCos(a), raycastSin(a), m, r);
+	r->angle = raycastRadians(a);
+}
+
+/**
+  * @brief  Casts a single ray walking the grid of the map with a DDA
+  * @note   The distance travelled along the ray is tracked separately for the next vertical and the next
+  * 		horizontal grid line, every step advances the nearest of the two so walls are met in order.
+  * @note   The direction doesn't need to be a unit vector: the distance is measured in units of its length,
+  * 		so a ray generated on the camera plane directly gets the distance from the plane.
+  * @param  x : The starting point x coordinate of the ray in Q16.16
+  * @param  y : The starting point y coordinate of the ray in Q16.16
+  * @param  dirX : The x component of the ray direction in Q16.16
+  * @param  dirY : The y component of the ray direction in Q16.16
+  * @param  m : The map currently active in the game
+  * @param  r : The ray to fill, only distance, pos, vertical and texX are written
+  */
+void raycastCastDir(fixed x, fixed y, fixed dirX, fixed dirY, Map *m, Ray *r)
+{
+	uint32_t invX = stepLength(dirX);
+	uint32_t invY = stepLength(dirY);
+
+	fixed block = FIXED_FROM_INT(MAP_BLOCK_SIZE);
+	int mapX = FIXED_TO_INT(x) >> MAP_BLOCK_SHIFT;
+	int mapY = FIXED_TO_INT(y) >> MAP_BLOCK_SHIFT;
+	int stepX, stepY;
+	uint32_t sideX, sideY; //distance along the ray to the next vertical and horizontal grid line
+	uint32_t deltaX = fixedMulSat(block, invX); //distance along the ray between two vertical grid lines
+	uint32_t deltaY = fixedMulSat(block, invY); //distance along the ray between two horizontal grid lines
+
+	if(dirX < 0) //looking left
+	{
+		stepX = -1;
+		sideX = fixedMulSat(x - mapX*block, invX);
+	}
+	else //looking right
+	{
+		stepX = 1;
+		sideX = fixedMulSat((mapX+1)*block - x, invX);
+	}
+
+	if(dirY < 0) //looking up
+	{
+		stepY = -1;
+		sideY = fixedMulSat(y - mapY*block, invY);
+	}
+	else //looking down
+	{
+		stepY = 1;
+		sideY = fixedMulSat((mapY+1)*block - y, invY);
+	}
+
+	bool hit = false;
+	bool vertical = false;
+	uint32_t t = 0;
+	//the ray walks the blocks by address: the solid border of the map stops it before it leaves the map
+	const uint8_t *cell = mapBlockPtr(m, mapX, mapY);
+	int rowStep = stepY * (1 << m->pitchShift);
+	for(int dof = 0; dof < m->mapBlockX + m->mapBlockY + 4; dof++)
+	{
+		//on a tie the horizontal line wins, as in castRaysFloat
+		if(sideX < sideY)
+		{
+			t = sideX;
+			sideX += deltaX;
+			mapX += stepX;
+			cell += stepX;
+			vertical = true;
+		}
+		else
+		{
+			t = sideY;
+			sideY += deltaY;
+			mapY += stepY;
+			cell += rowStep;
+			vertical = false;
+		}
+
+		//t stays below FIXED_INF, so side + delta never wraps around and t fits in a fixed
+		if(t >= maxDistance)
+			break;
+		if(materials[*cell].flags & MATERIAL_OPAQUE) //hit wall
+		{
+			hit = true;
+			break;
+		}
+	}
+
+	if(!hit)
+	{
+		//a ray stopped by the cutoff ends where the cutoff is, so the minimap shows how far the player sees
+		bool cut = t >= maxDistance && maxBlocks > 0;
+		r->pos.x = FIXED_TO_FLOAT(cut ? x + fixedMul(dirX, (fixed)maxDistance) : x);
+		r->pos.y = FIXED_TO_FLOAT(cut ? y + fixedMul(dirY, (fixed)maxDistance) : y);
+		r->distance = RAYCAST_NO_HIT;
+		r->vertical = false;
+		r->texX = 0;
+		return;
+	}
+
+	//the coordinate along the wall is kept inside the hit block: on a ray through a block corner the rounding
+	//of dir*t can put it in the next block
+	fixed hitX, hitY;
+	if(vertical)
+	{
+		hitX = stepX > 0 ? mapX*block : (mapX+1)*block - HIT_EPSILON;
+		hitY = fixedClamp(y + fixedMul(dirY, (fixed)t), mapY*block, (mapY+1)*block - HIT_EPSILON);
+	}
+	else
+	{
+		hitX = fixedClamp(x + fixedMul(dirX, (fixed)t), mapX*block, (mapX+1)*block - HIT_EPSILON);
+		hitY = stepY > 0 ? mapY*block : (mapY+1)*block - HIT_EPSILON;
+	}
+
+	r->pos.x = FIXED_TO_FLOAT(hitX);
+	r->pos.y = FIXED_TO_FLOAT(hitY);
+	r->distance = FIXED_TO_FLOAT(t);
+	r->vertical = vertical;
+
+	//the fraction of the block along the wall, mirrored on the faces seen looking left or down so that
+	//textures are never drawn flipped
+	fixed along = vertical ? hitY : hitX;
+	r->texX = (along & (block - 1)) >> MAP_BLOCK_SHIFT;
+	if(vertical ? stepX < 0 : stepY > 0)
+		r->texX = FIXED_ONE - 1 - r->texX;
+}
@@ -6,18 +6,40 @@
  */
 
 #include "render/render.h"
-#include "stm32f769i_discovery_lcd.h"
+#include "render/raycast.h"
+#include "render/texture.h"
+#include "render/raster.h"
+#include "render/minimap.h"
+#include "platform/platform.h"
 #include <math.h>
 
 //global ray index number generator
 static int rayIndex = 0;
 
 //global array used to store the casted rays
-static Ray rays[FOV];
+static Ray rays[MAX_RAYS];
+
+//resolution requested with setResolution(), applied by castRays() at the beginning of the next frame
+static volatile Resolution requestedResolution = RESOLUTION_LEGACY;
+static Screen *resolutionScreen;
+//resolution the per column tables below have been computed for
+static Resolution resolution = RESOLUTION_COUNT;
+//number of rays casted in the current frame and width in pixel of the column drawn for each of them
+static int rayCount = FOV;
+static int columnWidth = LEGACY_COLUMN_WIDTH;
+//half width of the camera plane: tan(FOV/2) in Q2.30
+static int32_t planeHalfWidth;
+//angle between every column ray and the central ray, and 1/cos of the same angle
+static angle_t columnAngle[MAX_RAYS];
+static float columnInvCos[MAX_RAYS];
+//walls are drawn with the textures of texture.c rather than with flat colors
+static volatile bool textures = true;
+//how the rays are drawn on the map
+static volatile MapRaysStyle mapRaysStyle = MAP_RAYS_FAN;
 
 static float distance(float ax, float ay, float bx, float by);
-static void drawRayMap(float focalX, float focalY, Ray *r);
-static void drawColumn(float focalAngle, Ray *r, Map *m, Screen *s);
+static void drawColumn(Ray *r, Map *m, Screen *s);
+static void applyResolution(Resolution res);
 
 /**
   * @brief  It calculates the length of a line given the coordinates of it starting and ending point
@@ -35,118 +57,248 @@ static float distance(float ax, float ay, float bx, float by)
 
 /**
   * @brief  Draws the 2D map on the screen with the scale defined in the render.h
+  * @note   The map is a DMA2D copy of its image cached by minimap.h, which is drawn again only when the blocks
+  * 		of the map change: the copy is complete once platformWaitDrawing() returns.
   * @param  s : The Screen used to display the game
   * @param  m : The map currently active in the game
   */
 void drawMap(Map *m, Screen *s)
 {
-	int yInc = s->height/(m->mapBlockY*MAP_SCALE);
-	int xInc = s->width/(m->mapBlockX*MAP_SCALE);
-
-		for(int y = 0; y < m->mapBlockY; y++)
-			for(int x = 0; x < m->mapBlockX; x++)
-				switch(m->map[y*m->mapBlockX+x])
-				{
-				case 1:
-					BSP_LCD_SetTextColor(LCD_COLOR_GREEN);
-					BSP_LCD_FillRect(x*xInc, y*yInc, xInc, yInc);
-					BSP_LCD_SetTextColor(LCD_COLOR_BLUE);
-					BSP_LCD_DrawRect(x*xInc, y*yInc, xInc, yInc);
-				break;
-				case 0:
-					BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
-					BSP_LCD_FillRect(x*xInc, y*yInc, xInc, yInc);
-					BSP_LCD_SetTextColor(LCD_COLOR_BLUE);
-					BSP_LCD_DrawRect(x*xInc, y*yInc, xInc, yInc);
-				break;
-				case 2:
-					BSP_LCD_SetTextColor(LCD_COLOR_BLUE);
-					BSP_LCD_FillRect(x*xInc, y*yInc, xInc, yInc);
-					BSP_LCD_SetTextColor(LCD_COLOR_BLUE);
-					BSP_LCD_DrawRect(x*xInc, y*yInc, xInc, yInc);
-				break;
-				}
-
+	minimapDraw(m, s, platformDrawBuffer());
 }
 
 /**
-  * @brief  Calculates all the rays end points and lengths
-  * @note   More details about the calculations in the pdf report
-  * @param  r : The starting point x coordinate of the ray
-  * @param  s : The Screen used to display the game
-  * @param  focalAngle : The angle of the central ray
+  * @brief  Draws the column of the 3D scene corresponding to a ray
+  * @note   The ceiling, the wall and the floor of the column are written straight into the back buffer in a
+  * 		single top to bottom pass, so no DMA2D transfer is set up for the 3D scene and no pixel is written twice.
+  * @note   With textures the wall is the texture column at the hit position of the ray scaled by textureSpan().
+  * @param  r : The ray the column is drawn for
   * @param  m : The map currently active in the game
+  * @param  s : The Screen used to display the game
   */
-static void drawColumn(float focalAngle, Ray *r, Map *m, Screen *s)
+static void drawColumn(Ray *r, Map *m, Screen *s)
 {
-	//fish eye fix
-	//the following rows fixes distortions making the image quite similar to the one of a panoramic lens.
-	float ca = focalAngle-r->angle;
-	if(ca<0)
-		ca+=2*M_PI;
-	else if(ca>2*M_PI)
-		ca-=2*M_PI;
-	r->distance*= cos(ca); //we tune the distance to avoid the distortion
-
-	float lineH = (m->blockSize*s->height) / r->distance;
-	float lineOffset = (s->height/2)-lineH / 2 ;
+	//the distance from the camera plane rather than from the player avoids the fish eye distortion,
+	//which would make the image quite similar to the one of a panoramic lens.
+	float fullH = (MAP_BLOCK_SIZE*s->height) / r->perpDistance;
+	float lineH = fullH;
 	if(lineH > s->height)
 		lineH = s->height;
-
-	//color selection
-	if(m->map[(int)r->pos.y/m->blockSize*m->mapBlockX+(int)(r->pos.x/m->blockSize)] == 2) //hit final wall
+	int wallTop = (s->height-lineH) / 2;
+	int wallRows = lineH;
+	pixel_t color;
+	const pixel_t black = pixelFromArgb(COLOR_BLACK);
+	const Material *material = &materials[mapBlockAt(m, r->pos.x, r->pos.y)];
+	const pixel_t *column = textures ? textureColumn(material->texture, !r->vertical, r->texX) : NULL;
+
+	//the faces hit by a vertical ray are the lighter ones
+	color = pixelFromArgb(r->vertical ? material->lightColor : material->darkColor);
+
+	//the last column sadly given the terrible aspect ratio of the display can be a little bit tighter
+	//(in RESOLUTION_LEGACY 13 pixel is the usual width, 7 is only for the last one)
+	int x = r->index*columnWidth;
+	int rectLeng = x + columnWidth <= s->width ? columnWidth : s->width - x;
+	int stride = s->width;
+	pixel_t *dst = ct_screen_backbuffer_ptr(s) + x;
+
+	dst = rasterFillSpan(dst, stride, rectLeng, wallTop, pixelFromArgb(CEILING_COLOR));
+
+	if(column != NULL && wallRows > 0)
 	{
-		if(r->vertical)
-			BSP_LCD_SetTextColor(LCD_COLOR_BLUE);
-		else
-			BSP_LCD_SetTextColor(LCD_COLOR_DARKBLUE);
+		//the texture is scaled on the whole wall height, the rows out of the screen are skipped;
+		//a wall closer than 1/4096 of the screen height is drawn as if it were there, so the step stays above 0
+		if(fullH > s->height * 4096.0f)
+			fullH = s->height * 4096.0f;
+		float step = TEXTURE_SIZE / fullH;
+		float texY = (wallTop - (s->height - fullH) / 2) * step;
+		if(texY < 0)
+			texY = 0;
+		dst = textureSpan(dst, stride, rectLeng, wallRows, column, FIXED_FROM_FLOAT(texY), FIXED_FROM_FLOAT(step));
 	}
-	else //hit wall
+	//the outline only makes sense when columns are wide enough to be told apart:
+	//a black top and bottom row and a black left edge, like the platformDrawRect() of the first versions
+	else if(columnWidth == LEGACY_COLUMN_WIDTH && wallRows >= 2)
 	{
-		if(r->vertical)
-			BSP_LCD_SetTextColor(LCD_COLOR_BROWN);
-		else
-			BSP_LCD_SetTextColor(LCD_COLOR_DARKRED);
+		dst = rasterFillSpan(dst, stride, rectLeng, 1, black);
+		rasterFillSpan(dst, stride, 1, wallRows - 2, black);
+		dst = rasterFillSpan(dst + 1, stride, rectLeng - 1, wallRows - 2, color) - 1;
+		dst = rasterFillSpan(dst, stride, rectLeng, 1, black);
 	}
+	else
+		dst = rasterFillSpan(dst, stride, rectLeng, wallRows, color);
+
+	rasterFillSpan(dst, stride, rectLeng, s->height - wallTop - wallRows, pixelFromArgb(FLOOR_COLOR));
+}
+
+/**
+  * @brief  Requests the horizontal resolution of the 3D scene
+  * @note   It can be called by any task: the new resolution is applied by castRays() at the beginning
+  * 		of the next frame, so the rays of a frame are always casted and drawn with the same one.
+  * @param  res : The requested resolution
+  * @param  s : The Screen used to display the game, its width defines the number of rays
+  */
+void setResolution(Resolution res, Screen *s)
+{
+	resolutionScreen = s;
+	requestedResolution = res;
+}
+
+/**
+  * @return the last requested horizontal resolution of the 3D scene
+  */
+Resolution getResolution(void)
+{
+	return requestedResolution;
+}
+
+/**
+  * @brief  Chooses between textured walls and flat colored walls, it can be called by any task
+  * @param  enable : true to draw the walls with textures
+  */
+void setTextures(bool enable)
+{
+	textures = enable;
+}
+
+/**
+  * @return true if the walls are drawn with textures
+  */
+bool getTextures(void)
+{
+	return textures;
+}
 
-	//the last rectangle saldy given the terrible aspect ration of the display will be a little bit tighter
-	//13 pixel is the usual width
-	//7 is only for the last one
-	int rectLeng = r->index < FOV-1 ? 13 : 7;
+/**
+  * @brief  Chooses how the rays are drawn on the map, it can be called by any task
+  * @param  style : The style of the rays
+  */
+void setMapRaysStyle(MapRaysStyle style)
+{
+	mapRaysStyle = style;
+}
 
-	BSP_LCD_FillRect(r->index*13, lineOffset, rectLeng, lineH);
+/**
+  * @return the style of the rays drawn on the map
+  */
+MapRaysStyle getMapRaysStyle(void)
+{
+	return mapRaysStyle;
+}
 
-	BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
-	BSP_LCD_DrawRect(r->index*13, lineOffset, rectLeng, lineH);
+/**
+  * @brief  Computes the number of rays and the per column tables of a resolution
+  * @note   Here is the only trigonometry of the camera plane ray generator, it runs only when the
+  * 		resolution changes so raising the number of columns doesn't raise the trig cost of a frame.
+  * @param  res : The resolution to apply
+  */
+static void applyResolution(Resolution res)
+{
+	resolution = res;
+	if(res == RESOLUTION_LEGACY)
+	{
+		rayCount = FOV;
+		columnWidth = LEGACY_COLUMN_WIDTH;
+		return;
+	}
+
+	columnWidth = res == RESOLUTION_FULL ? 1 : res == RESOLUTION_HALF ? 2 : 4;
+	rayCount = resolutionScreen->width / columnWidth;
+	if(rayCount > MAX_RAYS)
+		rayCount = MAX_RAYS;
+
+	double halfWidth = tan(FOV*DEGREE_RADIAN/2);
+	planeHalfWidth = (int32_t)lround(halfWidth * (1 << 30));
+	for(int i = 0; i < rayCount; i++)
+	{
+		//position of the column center on the camera plane, from -1 (left edge) to 1 (right edge)
+		double k = (2*i + 1 - rayCount) / (double)rayCount * halfWidth;
+		columnAngle[i] = raycastAngle(atan(k));
+		columnInvCos[i] = sqrt(1 + k*k);
+	}
 }
 
 /**
-  * @brief  Draws a single ray on the map
+  * @brief  Calculates all the rays end points and lengths with the fixed point DDA of raycast.c
+  * @note   In RESOLUTION_LEGACY the rays are one degree apart, in the other resolutions they are spread
+  * 		evenly on the camera plane: the direction of a ray is the one of the previous ray plus a constant
+  * 		step along the plane, the step is kept in Q2.30 so that it doesn't drift across 800 columns.
   * @param  focalX : The starting point x coordinate of the ray
   * @param  focalY : The ending point y coordinate of the ray
-  * @param  r : The actual ray
+  * @param  focalAngle : The angle of the central ray
+  * @param  m : The map currently active in the game
   */
-static void drawRayMap(float focalX, float focalY, Ray *r)
+void castRays(float focalX, float focalY, float focalAngle, Map *m)
 {
-	BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
-	BSP_LCD_DrawLine(focalX / MAP_SCALE, focalY / MAP_SCALE, r->pos.x / MAP_SCALE, r->pos.y / MAP_SCALE);
+	fixed x = FIXED_FROM_FLOAT(focalX);
+	fixed y = FIXED_FROM_FLOAT(focalY);
+	angle_t focal = raycastAngle(focalAngle);
+
+	if(requestedResolution != resolution)
+		applyResolution(requestedResolution);
+
+	rayIndex = 0;
+
+	if(resolution == RESOLUTION_LEGACY)
+	{
+		angle_t rayAngle = focal - 31*ANGLE_DEGREE;
+		for(int r = 0; r < FOV; r++)
+		{
+			Ray *ray = &rays[rayIndex++];
+			raycastCast(x, y, rayAngle, m, ray);
+			ray->index = r;
+			ray->perpDistance = ray->distance * FIXED_TO_FLOAT(raycastCos(rayAngle - focal));
+			rayAngle += ANGLE_DEGREE;
+		}
+		return;
+	}
+
+	fixed cosA = raycastCos(focal);
+	fixed sinA = raycastSin(focal);
+	//camera plane: perpendicular to the view direction, it spans the whole FOV at distance 1
+	int32_t planeX = -(int32_t)(((int64_t)sinA * planeHalfWidth) >> FIXED_SHIFT);
+	int32_t planeY = (int32_t)(((int64_t)cosA * planeHalfWidth) >> FIXED_SHIFT);
+	int32_t stepX = planeX / rayCount * 2;
+	int32_t stepY = planeY / rayCount * 2;
+	//direction of the first ray in Q2.30: the left edge of the plane plus half a step to hit the column center
+	int32_t dirX = cosA * (1 << 14) - planeX + stepX / 2;
+	int32_t dirY = sinA * (1 << 14) - planeY + stepY / 2;
+
+	for(int r = 0; r < rayCount; r++)
+	{
+		Ray *ray = &rays[rayIndex++];
+		raycastCastDir(x, y, dirX >> 14, dirY >> 14, m, ray);
+		ray->index = r;
+		ray->perpDistance = ray->distance;
+		ray->distance *= columnInvCos[r];
+		ray->angle = raycastRadians(focal + columnAngle[r]);
+		dirX += stepX;
+		dirY += stepY;
+	}
 }
 
 /**
-  * @brief  Calculates all the rays end points and lengths
+  * @brief  Calculates all the rays end points and lengths stepping on the grid lines with floats
   * @note   More details about the calculations in the pdf report
+  * @note   This is the original implementation, castRays() replaced it but it is kept as the reference
+  * 		the fixed point ray caster is compared with by the host test raycast_regress (see the tolerance
+  * 		documented in raycast.h)
   * @param  focalX : The starting point x coordinate of the ray
   * @param  focalY : The ending point y coordinate of the ray
   * @param  focalAngle : The angle of the central ray
   * @param  m : The map currently active in the game
   */
-void castRays(float focalX, float focalY, float focalAngle, Map *m)
+void castRaysFloat(float focalX, float focalY, float focalAngle, Map *m)
 {
 	//the hearth of the rendering "engine"
-	int mapX, mapY, mapIndex, dof;
+	int mapX, mapY, dof;
 	float rayX, rayY, rayAngle, xOffset, yOffset, finalDistance;
 
 	rayAngle = focalAngle - DEGREE_RADIAN*31;
+
+	//the reference always casts the RESOLUTION_LEGACY rays, castRays() restores the requested resolution
+	resolution = RESOLUTION_COUNT;
+	rayCount = FOV;
+	columnWidth = LEGACY_COLUMN_WIDTH;
 	if(rayAngle < 0)
 		rayAngle += 2*M_PI;
 	else if(rayAngle > 2*M_PI)
@@ -162,30 +314,30 @@ void castRays(float focalX, float focalY, float focalAngle, Map *m)
 		float aTan = -1/tan(rayAngle);
 		if(rayAngle > M_PI) //looking up
 		{
-			rayY = (((int)focalY / m->blockSize)*m->blockSize)-0.0001;
+			rayY = (((int)focalY >> MAP_BLOCK_SHIFT) << MAP_BLOCK_SHIFT)-0.0001;
 			rayX = (focalY-rayY)*aTan+focalX;
-			yOffset = -m->blockSize;
+			yOffset = -MAP_BLOCK_SIZE;
 			xOffset = -yOffset*aTan;
 		}
 		else if( rayAngle < M_PI) //looking down
 		{
-			rayY = (((int)focalY / m->blockSize)*m->blockSize)+m->blockSize;
+			rayY = (((int)focalY >> MAP_BLOCK_SHIFT) << MAP_BLOCK_SHIFT)+MAP_BLOCK_SIZE;
 			rayX = (focalY-rayY)*aTan+focalX;
-			yOffset = m->blockSize;
+			yOffset = MAP_BLOCK_SIZE;
 			xOffset = -yOffset*aTan;
 		}
-		else if(rayAngle == 0 || rayAngle==M_PI)
+		else //looking left or right, the ray crosses no horizontal line
 		{
 			rayX = focalX;
 			rayY = focalY;
+			xOffset = yOffset = 0;
 			dof = m->mapBlockY;
 		}
 		while(dof<m->mapBlockY)
 		{
-			mapX = (int)(rayX) / m->blockSize;
-			mapY = (int)(rayY) / m->blockSize;
-			mapIndex = mapY*m->mapBlockX+mapX;
-			if(mapIndex >= 0 && mapIndex < m->mapBlockX * m->mapBlockY && m->map[mapIndex] != 0) //hit wall
+			mapX = (int)floorf(rayX) >> MAP_BLOCK_SHIFT;
+			mapY = (int)floorf(rayY) >> MAP_BLOCK_SHIFT;
+			if(mapContains(m, mapX, mapY) && (materials[mapBlock(m, mapX, mapY)].flags & MATERIAL_OPAQUE)) //hit wall
 			{
 				hx = rayX;
 				hy = rayY;
@@ -207,30 +359,30 @@ void castRays(float focalX, float focalY, float focalAngle, Map *m)
 		float nTan = -tan(rayAngle);
 		if(rayAngle>P2 && rayAngle<P3) //looking left
 		{
-			rayX = (((int)focalX / m->blockSize)*m->blockSize)-0.0001;
+			rayX = (((int)focalX >> MAP_BLOCK_SHIFT) << MAP_BLOCK_SHIFT)-0.0001;
 			rayY = (focalX-rayX)*nTan+focalY;
-			xOffset = -m->blockSize;
+			xOffset = -MAP_BLOCK_SIZE;
 			yOffset = -xOffset*nTan;
 		}
 		else if(rayAngle<P2 || rayAngle>P3) //looking right
 		{
-			rayX = (((int)focalX  / m->blockSize)*m->blockSize)+m->blockSize;
+			rayX = (((int)focalX >> MAP_BLOCK_SHIFT) << MAP_BLOCK_SHIFT)+MAP_BLOCK_SIZE;
 			rayY = (focalX-rayX)*nTan+focalY;
-			xOffset = m->blockSize;
+			xOffset = MAP_BLOCK_SIZE;
 			yOffset = -xOffset*nTan;
 		}
-		else if(rayAngle == 0 || rayAngle==M_PI) //up or down
+		else //up or down, the ray crosses no vertical line
 		{
 			rayX = focalX;
 			rayY = focalY;
+			xOffset = yOffset = 0;
 			dof = m->mapBlockX;
 		}
 		while(dof<m->mapBlockX)
 		{
-			mapX = (int)(rayX) / m->blockSize;
-			mapY = (int)(rayY) / m->blockSize;
-			mapIndex = mapY*m->mapBlockX+mapX;
-			if(mapIndex >= 0 && mapIndex < m->mapBlockX * m->mapBlockY && m->map[mapIndex] != 0) //hit wall
+			mapX = (int)floorf(rayX) >> MAP_BLOCK_SHIFT;
+			mapY = (int)floorf(rayY) >> MAP_BLOCK_SHIFT;
+			if(mapContains(m, mapX, mapY) && (materials[mapBlock(m, mapX, mapY)].flags & MATERIAL_OPAQUE)) //hit wall
 			{
 				vx = rayX;
 				vy = rayY;
@@ -268,7 +420,13 @@ void castRays(float focalX, float focalY, float focalAngle, Map *m)
 		ray.angle = rayAngle;
 		ray.index = r;
 		ray.distance = finalDistance;
+		ray.perpDistance = finalDistance * cos(focalAngle - rayAngle);
 		ray.vertical = isVertical;
+		//mirrored on the faces seen looking left or down, as in raycastCastDir()
+		float along = isVertical ? rayY : rayX;
+		ray.texX = FIXED_FROM_FLOAT(fmodf(along, MAP_BLOCK_SIZE) / MAP_BLOCK_SIZE);
+		if(isVertical ? (rayAngle > P2 && rayAngle < P3) : rayAngle < M_PI)
+			ray.texX = FIXED_ONE - 1 - ray.texX;
 
 		rays[rayIndex++] = ray;
 
@@ -281,84 +439,197 @@ void castRays(float focalX, float focalY, float focalAngle, Map *m)
 }
 
 /**
-  * @brief  It draws on the top half of the screen a color used to represent the ceiling or sky of the 3D scene,
-  * while it draws in the bottom half another color used to represent the terrain
-  * @param  s : The Screen used to display the game
+  * @brief  Computes the statistics of the rays of the last castRays()
+  * @note   It must be called by the task that casts the rays.
+  * @param  stats : Where the statistics are written
   */
-void drawBackground(Screen *s)
+void getRayStats(RayStats *stats)
 {
-	BSP_LCD_SetTextColor(LCD_COLOR_DARKYELLOW);
-	BSP_LCD_FillRect(0, 0, s->width, s->height/2);
+	float sum = 0;
+	int hits = 0;
+
+	stats->rays = rayIndex;
+	stats->vertical = 0;
+	stats->misses = 0;
+	stats->minDistance = 0;
+	stats->maxDistance = 0;
+
+	for(int i = 0; i < rayIndex; i++)
+	{
+		Ray *r = &rays[i];
+		if(r->distance >= RAYCAST_NO_HIT)
+		{
+			stats->misses++;
+			continue;
+		}
+		stats->vertical += r->vertical;
+		if(hits == 0 || r->perpDistance < stats->minDistance)
+			stats->minDistance = r->perpDistance;
+		if(r->perpDistance > stats->maxDistance)
+			stats->maxDistance = r->perpDistance;
+		sum += r->perpDistance;
+		hits++;
+	}
 
-	BSP_LCD_SetTextColor(LCD_COLOR_DARKGRAY);
-	BSP_LCD_FillRect(0, s->height/2, s->width, s->height/2);
+	stats->avgDistance = hits ? sum / hits : 0;
+}
+
+/**
+  * @brief  Gives the rays of the last castRays() or castRaysFloat(), e.g. to compare the two on the host
+  * @note   It must be called by the task that casts the rays.
+  * @param  count : Where the number of rays is written
+  * @return the first ray
+  */
+const Ray* getRays(int *count)
+{
+	*count = rayIndex;
+	return rays;
 }
 
 /**
   * @brief  It renders the 3D scene with the pre-casted rays
   * @param  s : The Screen used to display the game
   * @param  m : The map currently active in the game
-  * @param  focalAngle : the angle of the central ray
   */
-void drawRays(Map *m, Screen *s, float focalAngle)
+void drawRays(Map *m, Screen *s)
 {
-	for(int i = 0; i<FOV; i++)
-	{
-		Ray r = rays[i];
-		drawColumn(focalAngle, &r, m, s);
-	}
+	for(int i = 0; i<rayCount; i++)
+		drawColumn(&rays[i], m, s);
+
+	//the columns are written by the CPU while the HUD on top of them is drawn by the DMA2D
+	platformFlushPixels();
 }
 
 /**
   * @brief  It draws the pre-casted rays on the 2D map
+  * @note   The lines of raster.h and the fan are written by the CPU straight into the back buffer and clipped to
+  * 		the map. The fan has a triangle between every two consecutive rays drawn, so it covers the floor seen
+  * 		by the player up to the walls.
   * @param  focalX : the x coordinate of the starting point used to draw all the rays
   * @param  focalY : the y coordinate of the starting point used to draw all the rays
+  * @param  m : The map currently active in the game
+  * @param  s : The Screen used to display the game
   */
-void drawMapRays(float focalX, float focalY)
+void drawMapRays(float focalX, float focalY, Map *m, Screen *s)
 {
-	for(int i = 0; i<FOV; i++)
+	//the map is too small to tell apart more than FOV rays, drawing them all would only cost time
+	int step = (rayCount + FOV - 1) / FOV;
+	MapRaysStyle style = mapRaysStyle;
+	vec2 scale = getMapScale(m, s);
+	float x = focalX * scale.x, y = focalY * scale.y;
+
+	//a map too large to be drawn has no rays either
+	if(getMapRect(m, s).width == 0)
+		return;
+	//the rays go over the map, which is copied by the DMA2D
+	platformWaitDrawing();
+	if(style == MAP_RAYS_PLATFORM)
+	{
+		platformSetTextColor(MAP_RAYS_COLOR);
+		for(int i = 0; i<rayCount; i+=step)
+			platformDrawLine(x, y, rays[i].pos.x * scale.x, rays[i].pos.y * scale.y);
+		return;
+	}
+
+	RasterTarget t = { ct_screen_backbuffer_ptr(s), s->width, getMapRect(m, s) };
+
+	if(style == MAP_RAYS_LINES)
 	{
-		Ray r = rays[i];
-		drawRayMap(focalX, focalY, &r);
+		pixel_t color = pixelFromArgb(MAP_RAYS_COLOR);
+		for(int i = 0; i<rayCount; i+=step)
+			rasterLine(&t, x, y, rays[i].pos.x * scale.x, rays[i].pos.y * scale.y, color);
 	}
+	else
+	{
+		//static, not on the stack of the render task: only the render task draws the rays
+		static RasterPoint points[FOV + 1];
+		RasterPoint center = { FIXED_FROM_FLOAT(x), FIXED_FROM_FLOAT(y) };
+		int count = 0;
+		for(int i = 0; i<rayCount; i+=step)
+			points[count++] = (RasterPoint){ FIXED_FROM_FLOAT(rays[i].pos.x * scale.x), FIXED_FROM_FLOAT(rays[i].pos.y * scale.y) };
+		//the last ray closes the fan at the edge of the field of view
+		if((rayCount - 1) % step != 0)
+			points[count++] = (RasterPoint){ FIXED_FROM_FLOAT(rays[rayCount - 1].pos.x * scale.x), FIXED_FROM_FLOAT(rays[rayCount - 1].pos.y * scale.y) };
+		rasterFan(&t, center, points, count, pixelFromArgb(MAP_FAN_COLOR));
+	}
+
+	platformFlushPixels();
 }
 
 /**
-  * @brief  It draws the control that can be used to move the player in the game
+  * @brief  Computes the areas of the screen covered by the controls, outline included
   * @param  s : The Screen used to display the game
+  * @param  scale : how big the controls are compared to a block of the CONTROLS_GRID_X x CONTROLS_GRID_Y grid
+  * @param  rects : Where the CONTROLS rectangles are written: forward, backward, rotate left, rotate right
+  */
+void getControlRects(Screen *s, int scale, Rect *rects)
+{
+	int mapBlockX = CONTROLS_GRID_X / scale;
+	int mapBlockY = CONTROLS_GRID_Y / scale;
+	int stepX = s->width/mapBlockX;
+	int stepY = s->height/mapBlockY;
+
+	rects[0] = (Rect){ 0, stepY*(mapBlockY-2), stepX, stepY };
+	rects[1] = (Rect){ 0, stepY*(mapBlockY-1), stepX, stepY };
+	rects[2] = (Rect){ stepX*(mapBlockX-3), stepY*(mapBlockY-1), stepX, stepY };
+	rects[3] = (Rect){ stepX*(mapBlockX-1), stepY*(mapBlockY-1), stepX, stepY };
+}
+
+/**
   * @param  m : The map currently active in the game
-  * @param  scale : the current scale compared to the size of a rectangle of the map
+  * @param  s : The Screen used to display the game
+  * @return the area of the screen covered by the map drawn by drawMap(), outline included; it is empty for the
+  * 		maps with more blocks than the pixels of the area, which are not drawn
   */
-void drawControls(Screen *s, Map *m, int scale)
+Rect getMapRect(Map *m, Screen *s)
 {
-	int mapBlockX = m->mapBlockX / scale;
-	int mapBlockY = m->mapBlockY / scale;
-	int blockSize = m->blockSize * scale;
+	int yInc = s->height/(m->mapBlockY*MAP_SCALE);
+	int xInc = s->width/(m->mapBlockX*MAP_SCALE);
 
-	BSP_LCD_SetBackColor(LCD_COLOR_ORANGE);
-	BSP_LCD_SetTextColor(LCD_COLOR_ORANGE);
+	if(xInc == 0 || yInc == 0)
+		return (Rect){ 0 };
+	return (Rect){ 0, 0, m->mapBlockX*xInc + 1, m->mapBlockY*yInc + 1 };
+}
 
-	BSP_LCD_FillRect(0, (s->height/mapBlockY)*(mapBlockY-2), blockSize-1, blockSize-1);
-	BSP_LCD_FillRect(0, (s->height/mapBlockY)*(mapBlockY-1), blockSize-1, blockSize-1);
-	BSP_LCD_FillRect((s->width/mapBlockX)*(mapBlockX-3), (s->height/mapBlockY)*(mapBlockY-1), blockSize-1, blockSize-1);
-	BSP_LCD_FillRect((s->width/mapBlockX)*(mapBlockX-1), (s->height/mapBlockY)*(mapBlockY-1), blockSize-1, blockSize-1);
+/**
+  * @param  m : The map currently active in the game
+  * @param  s : The Screen used to display the game
+  * @return the pixels of the map drawn by drawMap() per world unit, along x and y
+  */
+vec2 getMapScale(Map *m, Screen *s)
+{
+	int yInc = s->height/(m->mapBlockY*MAP_SCALE);
+	int xInc = s->width/(m->mapBlockX*MAP_SCALE);
 
+	return (vec2){ (float)xInc / MAP_BLOCK_SIZE, (float)yInc / MAP_BLOCK_SIZE };
+}
 
-	BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
+/**
+  * @brief  It draws the control that can be used to move the player in the game
+  * @param  s : The Screen used to display the game
+  * @param  scale : the current scale compared to the size of a block of the CONTROLS_GRID_X x CONTROLS_GRID_Y grid
+  */
+void drawControls(Screen *s, int scale)
+{
+	Rect rects[CONTROLS];
+	const char *labels[CONTROLS] = { " /\\", " \\/", "  <", "  >" };
 
+	getControlRects(s, scale, rects);
 
-	BSP_LCD_DisplayStringAt(0, (s->height/mapBlockY)*(mapBlockY-2), (uint8_t*)" /\\", LEFT_MODE);
-	BSP_LCD_DrawRect(0, (s->height/mapBlockY)*(mapBlockY-2), blockSize-1, blockSize-1);
+	platformSetBackColor(COLOR_ORANGE);
+	platformSetTextColor(COLOR_ORANGE);
 
-	BSP_LCD_DisplayStringAt(0, (s->height/mapBlockY)*(mapBlockY-1), (uint8_t*)" \\/", LEFT_MODE);
-	BSP_LCD_DrawRect(0, (s->height/mapBlockY)*(mapBlockY-1), blockSize-1, blockSize-1);
+	for(int i = 0; i < CONTROLS; i++)
+		platformFillRect(rects[i].x, rects[i].y, rects[i].width-1, rects[i].height-1);
 
-	BSP_LCD_DisplayStringAt((s->width/mapBlockX)*(mapBlockX-3), (s->height/mapBlockY)*(mapBlockY-1), (uint8_t*)"  <\0", LEFT_MODE);
-	BSP_LCD_DrawRect((s->width/mapBlockX)*(mapBlockX-3), (s->height/mapBlockY)*(mapBlockY-1), blockSize-1, blockSize-1);
 
-	BSP_LCD_DisplayStringAt((s->width/mapBlockX)*(mapBlockX-1), (s->height/mapBlockY)*(mapBlockY-1), (uint8_t*)"  >\0", LEFT_MODE);
-	BSP_LCD_DrawRect((s->width/mapBlockX)*(mapBlockX-1), (s->height/mapBlockY)*(mapBlockY-1), blockSize-1, blockSize-1);
+	platformSetTextColor(COLOR_BLACK);
 
+	for(int i = 0; i < CONTROLS; i++)
+	{
+		platformDrawString(rects[i].x, rects[i].y, labels[i], PLATFORM_ALIGN_LEFT);
+		platformDrawRect(rects[i].x, rects[i].y, rects[i].width-1, rects[i].height-1);
+	}
 }
 
 
@@ -2,37 +2,103 @@
 #define SCREEN_H	480
 
 #include "render/screen.h"
+#include "render/blit.h"
+#include "render/vram.h"
 #include "stm32f769i_discovery_lcd.h"
 #include <stdlib.h>
+#include <string.h>
+
+//the BSP draws into the frame buffer of its active layer: the back buffer is handed to it through this handle
+extern LTDC_HandleTypeDef hltdc_discovery;
 
 //instance of the screen that gets initialized and then returned by ct_screen_init()
 Screen *screen;
 
 /**
+  * @brief  Programs a buffer in the LTDC shadow registers, it is displayed from the next vertical blanking
+  * @note   It must be called with the LTDC interrupt masked or from the interrupt itself.
+  * @param  s : The Screen used to display the game
+  * @param  id : The index of the buffer
+  */
+static void ct_screen_program(Screen *screen, uint32_t id) {
+	screen->state[id] = BUFFER_PENDING;
+	screen->pending = id;
+	LTDC_Layer1->CFBAR = screen->addr[id];
+	LTDC->SRCR = LTDC_SRCR_VBR;
+}
+
+/**
+  * @param  s : The Screen used to display the game
+  * @return the index of a free buffer among the ones in use, SCREEN_NO_BUFFER if there is none
+  */
+static uint32_t ct_screen_free_buffer(Screen *screen) {
+	for(uint32_t i = 0; i < screen->buffers; i++)
+		if(screen->state[i] == BUFFER_FREE)
+			return i;
+	return SCREEN_NO_BUFFER;
+}
+
+/**
+  * @brief  Blocks the calling task until the LTDC interrupt reports that a frame has been displayed
+  * @note   The caller must have set flip_waiter before checking the condition it waits for. Before the scheduler
+  * 		is started FreeRTOS keeps the interrupt masked, so the reload flag is polled and handled here instead.
   * @param  s : The Screen used to display the game
-  * @return An integer used to identify the backbuffer display
   */
-uint32_t ct_screen_backbuffer_id(Screen *screen) {
-	return 1 - screen->front;
+static void ct_screen_sleep(Screen *screen) {
+	if(xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLIP_TIMEOUT_MS));
+	else if(LTDC->ISR & LTDC_ISR_RRIF)
+	{
+		HAL_NVIC_DisableIRQ(LTDC_IRQn);
+		ct_screen_irq_handler();
+		HAL_NVIC_EnableIRQ(LTDC_IRQn);
+	}
 }
 
 /**
   * @brief Configures the display so that it can be used
+  * @note  All the SCREEN_MAX_BUFFERS frame buffers are allocated, so the buffering can be changed at run time.
+  * 	   Their pixel format is chosen at compile time with SCREEN_PIXEL_FORMAT.
+  * 	   Only the LTDC layer 0 is used: a flip changes the address it scans out.
   * @return A Screen pointer referencing the screen that has just been initialized
   */
 Screen* ct_screen_init() {
 	BSP_LCD_Init();
+	ct_blit_init();
 	screen = (Screen*) malloc(sizeof(Screen));
+	memset(screen, 0, sizeof(Screen));
 	screen->width = BSP_LCD_GetXSize();
 	screen->height = BSP_LCD_GetYSize();
-	screen->addr[0] = LCD_FB_START_ADDRESS;
-	screen->addr[1] = LCD_FB_START_ADDRESS + screen->width * screen->height * 4;
-	screen->front = 1;
+	for(int i = 0; i < SCREEN_MAX_BUFFERS; i++)
+	{
+		screen->addr[i] = (uintptr_t)vramAlloc(screen->width * screen->height * PIXEL_BYTES);
+		screen->state[i] = BUFFER_FREE;
+	}
+	screen->buffers = SCREEN_DEFAULT_BUFFERS;
+	screen->requested_buffers = SCREEN_DEFAULT_BUFFERS;
+	screen->front = 0;
+	screen->state[0] = BUFFER_DISPLAYED;
+	screen->back = SCREEN_NO_BUFFER;
+	screen->pending = SCREEN_NO_BUFFER;
+	screen->stats.start = xTaskGetTickCount();
+
 	BSP_LCD_LayerDefaultInit(0, screen->addr[0]);
-	BSP_LCD_LayerDefaultInit(1, screen->addr[1]);
-	BSP_LCD_SetLayerVisible(0, DISABLE);
-	BSP_LCD_SetLayerVisible(1, ENABLE);
+	ct_screen_load_clut(0);
+	BSP_LCD_SetLayerVisible(0, ENABLE);
+	BSP_LCD_SetLayerVisible(1, DISABLE);
 	BSP_LCD_SelectLayer(0);
+
+	//the DWT cycle counter times the present latency
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->LAR = 0xC5ACCE55;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	//the BSP enables the LTDC interrupt with priority 3, the reload interrupt notifies a task so it must be lowered
+	LTDC->ICR = LTDC_ICR_CRRIF;
+	LTDC->IER |= LTDC_IER_RRIE;
+	HAL_NVIC_SetPriority(LTDC_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(LTDC_IRQn);
 	return screen;
 }
 
@@ -40,20 +106,170 @@ Screen* ct_screen_init() {
   * @param  s : The Screen used to display the game
   * @return the pointer to the back buffer of the display
   */
-uint32_t* ct_screen_backbuffer_ptr(Screen *screen) {
-	return (uint32_t*)(screen->addr[ct_screen_backbuffer_id(screen)]);
+pixel_t* ct_screen_backbuffer_ptr(Screen *screen) {
+	return (pixel_t*)(screen->addr[screen->back]);
 }
 
 /**
-  * @brief  It draws the pause screen
+  * @brief  Fills the CLUT of an LTDC layer with the RGB332 palette and enables it, it does nothing unless
+  * 		SCREEN_PIXEL_FORMAT is PIXEL_FORMAT_L8
+  * @note   The colors are the ones of pixelToArgb(), so black, white and the saturated colors are exact and
+  * 		can be used as color keys.
+  * @param  layer : The index of the layer, after BSP_LCD_LayerDefaultInit()
+  */
+void ct_screen_load_clut(uint32_t layer) {
+#if SCREEN_PIXEL_FORMAT == PIXEL_FORMAT_L8
+	static uint32_t clut[256];
+
+	for(uint32_t i = 0; i < 256; i++)
+		clut[i] = pixelToArgb(i) & 0x00FFFFFF;
+	HAL_LTDC_ConfigCLUT(&hltdc_discovery, clut, 256, layer);
+	HAL_LTDC_EnableCLUT(&hltdc_discovery, layer);
+#else
+	(void)layer;
+#endif
+}
+
+/**
+  * @brief  Requests double or triple buffering
+  * @note   It can be called by any task, the change is applied by ct_screen_wait_backbuffer() once every frame
+  * 		in flight has been displayed.
+  * @param  s : The Screen used to display the game
+  * @param  buffers : 2 for double buffering, 3 for triple buffering
+  */
+void ct_screen_set_buffering(Screen *screen, uint32_t buffers) {
+	if(buffers >= 2 && buffers <= SCREEN_MAX_BUFFERS)
+		screen->requested_buffers = buffers;
+}
+
+/**
+  * @brief  Submits the back buffer for display and returns without waiting for it
+  * @note   If no frame is pending the buffer is programmed straight away and the LTDC displays it from the next
+  * 		vertical blanking, otherwise it is queued and the LTDC interrupt programs it once the pending one is
+  * 		displayed. Before drawing again ct_screen_wait_backbuffer() must be called to get a new back buffer,
+  * 		everything that doesn't touch the frame buffers (input, ray casting) can run in the meantime.
   * @param  s : The Screen used to display the game
   */
 void ct_screen_flip_buffers(Screen *screen) {
-  // wait for VSYNC
-	while (!(LTDC->CDSR & LTDC_CDSR_VSYNCS));
-	BSP_LCD_SetLayerVisible(screen->front, DISABLE);
-	screen->front ^= 1;
-	BSP_LCD_SetLayerVisible(screen->front, ENABLE);
-	BSP_LCD_SelectLayer(ct_screen_backbuffer_id(screen));
+	ct_screen_wait_backbuffer(screen);
+
+	uint32_t id = screen->back;
+	screen->back = SCREEN_NO_BUFFER;
+	screen->submit[id] = DWT->CYCCNT;
+
+	taskENTER_CRITICAL();
+	if(screen->pending == SCREEN_NO_BUFFER)
+		ct_screen_program(screen, id);
+	else
+	{
+		screen->state[id] = BUFFER_READY;
+		screen->ready[(screen->ready_head + screen->ready_count) % SCREEN_MAX_BUFFERS] = id;
+		screen->ready_count++;
+	}
+	taskEXIT_CRITICAL();
 }
 
+/**
+  * @brief  Gets a free buffer to draw the next frame into, it does nothing if the back buffer has already been got
+  * @note   With double buffering the only free buffer is the one on display until the pending frame is displayed,
+  * 		with triple buffering a free buffer is usually ready straight away. The calling task is blocked until
+  * 		the LTDC reload interrupt notifies it, before the scheduler is started it polls the LTDC instead.
+  * @param  s : The Screen used to display the game
+  */
+void ct_screen_wait_backbuffer(Screen *screen) {
+	uint32_t id;
+
+	if(screen->back != SCREEN_NO_BUFFER)
+		return;
+
+	uint32_t start = DWT->CYCCNT;
+	screen->flip_waiter = xTaskGetCurrentTaskHandle();
+
+	//the number of buffers is changed only when none of them holds a frame waiting to be displayed
+	if(screen->requested_buffers != screen->buffers)
+	{
+		while(screen->pending != SCREEN_NO_BUFFER || screen->ready_count != 0)
+			ct_screen_sleep(screen);
+		screen->buffers = screen->requested_buffers;
+	}
+
+	while((id = ct_screen_free_buffer(screen)) == SCREEN_NO_BUFFER)
+		ct_screen_sleep(screen);
+
+	screen->flip_waiter = NULL;
+	screen->state[id] = BUFFER_DRAWING;
+	screen->back = id;
+	hltdc_discovery.LayerCfg[0].FBStartAdress = screen->addr[id];
+	BSP_LCD_SelectLayer(0);
+
+	screen->stats.stall_sum += DWT->CYCCNT - start;
+}
+
+/**
+  * @param  s : The Screen used to display the game
+  * @return the time in microseconds between the submission of the last displayed frame and its display
+  */
+uint32_t ct_screen_present_latency_us(Screen *screen) {
+	return screen->stats.latency_last / (SystemCoreClock / 1000000);
+}
+
+/**
+  * @brief  Copies the frame pacing counters
+  * @param  s : The Screen used to display the game
+  * @param  stats : Where the counters are copied
+  */
+void ct_screen_get_stats(Screen *screen, ScreenStats *stats) {
+	taskENTER_CRITICAL();
+	*stats = screen->stats;
+	taskEXIT_CRITICAL();
+}
+
+/**
+  * @brief  Resets the frame pacing counters, e.g. after changing the buffering
+  * @param  s : The Screen used to display the game
+  */
+void ct_screen_reset_stats(Screen *screen) {
+	taskENTER_CRITICAL();
+	memset(&screen->stats, 0, sizeof(ScreenStats));
+	screen->stats.start = xTaskGetTickCount();
+	taskEXIT_CRITICAL();
+}
+
+/**
+  * @brief  Completes a flip when the LTDC reloads its shadow registers, it must be called by LTDC_IRQHandler()
+  * @note   The buffer displayed until now becomes free and the oldest ready frame, if any, becomes pending.
+  */
+void ct_screen_irq_handler(void) {
+	BaseType_t woken = pdFALSE;
+
+	if(LTDC->ISR & LTDC_ISR_RRIF)
+	{
+		LTDC->ICR = LTDC_ICR_CRRIF;
+		if(screen != NULL && screen->pending != SCREEN_NO_BUFFER)
+		{
+			uint32_t latency = DWT->CYCCNT - screen->submit[screen->pending];
+			screen->stats.presented++;
+			screen->stats.latency_last = latency;
+			screen->stats.latency_sum += latency;
+			if(latency > screen->stats.latency_max)
+				screen->stats.latency_max = latency;
+
+			screen->state[screen->front] = BUFFER_FREE;
+			screen->front = screen->pending;
+			screen->state[screen->front] = BUFFER_DISPLAYED;
+			screen->pending = SCREEN_NO_BUFFER;
+
+			if(screen->ready_count != 0)
+			{
+				ct_screen_program(screen, screen->ready[screen->ready_head]);
+				screen->ready_head = (screen->ready_head + 1) % SCREEN_MAX_BUFFERS;
+				screen->ready_count--;
+			}
+
+			if(screen->flip_waiter != NULL)
+				vTaskNotifyGiveFromISR(screen->flip_waiter, &woken);
+		}
+	}
+
+	portYIELD_FROM_ISR(woken);
+}
@@ -0,0 +1,159 @@
+/*
+ * text.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/text.h"
+#include "render/blit.h"
+#include "render/vram.h"
+#include <string.h>
+
+static TextAtlas atlases[TEXT_MAX_FONTS];
+static int atlasCount = 0;
+
+/**
+  * @brief  Expands the glyphs of a font into an A8 atlas and finds the inked area of each one
+  * @param  a : The atlas
+  * @param  font : The font
+  * @return false if there is no SDRAM left for the atlas
+  */
+static bool buildAtlas(TextAtlas *a, const sFONT *font)
+{
+	int bytes = (font->Width + 7) / 8;
+	uint32_t glyphSize = font->Width * font->Height;
+
+	a->atlas = vramAlloc(glyphSize * TEXT_GLYPHS);
+	if(a->atlas == NULL)
+		return false;
+	a->font = font;
+
+	for(int c = 0; c < TEXT_GLYPHS; c++)
+	{
+		const uint8_t *bits = &font->table[c * font->Height * bytes];
+		uint8_t *glyph = a->atlas + c * glyphSize;
+		int left = font->Width, right = -1, top = font->Height, bottom = -1;
+
+		for(int row = 0; row < font->Height; row++, bits += bytes)
+		{
+			uint32_t line = 0;
+			for(int b = 0; b < bytes; b++)
+				line = (line << 8) | bits[b];
+			for(int col = 0; col < font->Width; col++)
+			{
+				bool ink = line & (1u << (bytes * 8 - 1 - col));
+				glyph[row * font->Width + col] = ink ? 255 : 0;
+				if(!ink)
+					continue;
+				left = col < left ? col : left;
+				right = col > right ? col : right;
+				top = row < top ? row : top;
+				bottom = row;
+			}
+		}
+
+		a->ink[c] = right < 0 ? (TextBox){ 0 } : (TextBox){ left, top, right - left + 1, bottom - top + 1 };
+	}
+
+	//the atlas is read by the DMA2D
+	platformFlushPixels();
+	return true;
+}
+
+/**
+  * @brief  Gets the glyph cache of a font, it is built the first time
+  * @param  font : The font
+  * @return the glyph cache, NULL if there is no room for it
+  */
+const TextAtlas* textAtlas(const sFONT *font)
+{
+	for(int i = 0; i < atlasCount; i++)
+		if(atlases[i].font == font)
+			return &atlases[i];
+
+	if(atlasCount == TEXT_MAX_FONTS || !buildAtlas(&atlases[atlasCount], font))
+		return NULL;
+	return &atlases[atlasCount++];
+}
+
+/**
+  * @brief  Computes the column where a string starts, as BSP_LCD_DisplayStringAt() does
+  * @param  width : The width of the buffer
+  * @param  font : The font of the string
+  * @param  text : The string
+  * @param  x : The x coordinate, its meaning depends on the alignment
+  * @param  align : The alignment of the string
+  * @return the x coordinate of the first character
+  */
+int textColumn(uint32_t width, const sFONT *font, const char *text, uint16_t x, PlatformAlign align)
+{
+	int size = strlen(text);
+	int lineChars = width / font->Width;
+	uint16_t column;
+
+	if(align == PLATFORM_ALIGN_CENTER)
+		column = x + ((lineChars - size) * font->Width) / 2;
+	else if(align == PLATFORM_ALIGN_RIGHT)
+		column = -x + ((lineChars - size) * font->Width);
+	else
+		column = x;
+	//the BSP moves a string starting out of the screen to the first column
+	if(column < 1 || column >= 0x8000)
+		column = 1;
+
+	return column;
+}
+
+/**
+  * @brief  Queues the drawing of a string: a fill of its cells with the back color, then a blend for every glyph
+  * @note   Nothing is drawn if the glyph cache of the font can't be built.
+  * @param  t : The buffer, the font and the colors
+  * @param  x : The x coordinate, its meaning depends on the alignment
+  * @param  y : The y coordinate of the top of the string
+  * @param  text : The string
+  * @param  align : The alignment of the string
+  * @return the fence of the last job of the string
+  */
+uint32_t textDrawString(const TextTarget *t, uint16_t x, uint16_t y, const char *text, PlatformAlign align)
+{
+	const TextAtlas *a = textAtlas(t->font);
+	int charWidth = t->font->Width, rows = t->font->Height;
+	int column = textColumn(t->width, t->font, text, x, align);
+	int count = 0;
+
+	if(a == NULL || y >= t->height)
+		return ct_blit_fence();
+	if(y + rows > (int)t->height)
+		rows = t->height - y;
+
+	//as the BSP, the string ends at the first character too far from the left edge, then at the right edge
+	while(text[count] != 0 && (int)t->width - count * charWidth >= charWidth && column + (count + 1) * charWidth <= (int)t->width)
+		count++;
+	if(count == 0)
+		return ct_blit_fence();
+
+	pixel_t *cell = t->buffer + y * t->width + column;
+	if(t->backColor >> 24)
+		ct_blit_fill(cell, count * charWidth, rows, t->width - count * charWidth, t->backColor);
+	if((t->color >> 24) == 0)
+		return ct_blit_fence();
+
+	for(int i = 0; i < count; i++, cell += charWidth)
+	{
+		int c = (uint8_t)text[i] - TEXT_FIRST_CHAR;
+		if(c < 0 || c >= TEXT_GLYPHS)
+			continue;
+
+		const TextBox *ink = &a->ink[c];
+		if(ink->width == 0 || ink->y >= rows)
+			continue;
+
+		int height = ink->y + ink->height > rows ? rows - ink->y : ink->height;
+		const uint8_t *mask = a->atlas + (c * t->font->Height + ink->y) * charWidth + ink->x;
+		ct_blit_blend_a8(mask, charWidth - ink->width, cell + ink->y * t->width + ink->x, t->width - ink->width,
+				ink->width, height, t->color);
+	}
+
+	return ct_blit_fence();
+}
@@ -0,0 +1,156 @@
+/*
+ * texture.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/texture.h"
+#include "render/vram.h"
+#include <stddef.h>
+
+//texels of a texture
+#define TEXTURE_TEXELS (TEXTURE_SIZE * TEXTURE_SIZE)
+
+//lit and dark copy of every texture, column by column
+static pixel_t *atlas;
+
+/**
+  * @brief  Scrambles an integer, it gives the textures a deterministic grain
+  * @param  x : The integer to scramble
+  * @return the scrambled integer
+  */
+static uint32_t noise(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352D;
+	x ^= x >> 15;
+	x *= 0x846CA68B;
+	x ^= x >> 16;
+	return x;
+}
+
+/**
+  * @brief  Builds an opaque ARGB8888 color adding the same offset to the three channels
+  * @param  rgb : The base color
+  * @param  delta : The offset, the channels are clamped to 0 and 255
+  * @return the color
+  */
+static uint32_t shade(uint32_t rgb, int delta)
+{
+	uint32_t argb = 0xFF000000;
+	for(int shift = 0; shift < 24; shift += 8)
+	{
+		int c = (int)((rgb >> shift) & 0xFF) + delta;
+		c = c < 0 ? 0 : c > 255 ? 255 : c;
+		argb |= (uint32_t)c << shift;
+	}
+	return argb;
+}
+
+/**
+  * @brief  Computes a texel of the bricks: rows of 32x16 bricks, every other row shifted by half a brick
+  * @param  u : The column of the texel
+  * @param  v : The row of the texel
+  * @return the ARGB8888 texel
+  */
+static uint32_t brickTexel(int u, int v)
+{
+	int row = v / 16;
+	int x = u + (row & 1) * 16;
+	int grain = (int)(noise(v * TEXTURE_SIZE + u) & 15) - 8;
+
+	if(v % 16 == 0 || x % 32 == 0) //mortar
+		return shade(0x8A8A8A, grain);
+
+	int tint = (int)(noise(0x1000 + row * 4 + (x / 32) % 2) & 31) - 16;
+	return shade(0xA52A2A, tint + grain);
+}
+
+/**
+  * @brief  Computes a texel of the door of the final wall: vertical planks in a light frame with a knob
+  * @param  u : The column of the texel
+  * @param  v : The row of the texel
+  * @return the ARGB8888 texel
+  */
+static uint32_t exitTexel(int u, int v)
+{
+	int grain = (int)(noise(0x2000 + v * TEXTURE_SIZE + u) & 15) - 8;
+
+	if(u < 4 || u >= TEXTURE_SIZE - 4 || v < 4 || v >= TEXTURE_SIZE - 4)
+		return shade(0x4040FF, grain);
+	if(u >= 46 && u < 50 && v >= 30 && v < 34)
+		return shade(0xFFFF00, 0);
+	if(u % 14 == 4)
+		return shade(0x000080, grain);
+	return shade(0x0000C0, grain);
+}
+
+/**
+  * @brief  Generates the textures into the SDRAM, it must be called once before drawing textured walls
+  */
+void textureInit(void)
+{
+	atlas = vramAlloc(TEXTURE_COUNT * 2 * TEXTURE_TEXELS * PIXEL_BYTES);
+	if(atlas == NULL)
+		return;
+
+	for(int id = 0; id < TEXTURE_COUNT; id++)
+	{
+		pixel_t *lit = atlas + id * 2 * TEXTURE_TEXELS;
+		pixel_t *dark = lit + TEXTURE_TEXELS;
+		for(int u = 0; u < TEXTURE_SIZE; u++)
+			for(int v = 0; v < TEXTURE_SIZE; v++)
+			{
+				uint32_t argb = id == TEXTURE_EXIT ? exitTexel(u, v) : brickTexel(u, v);
+				lit[u * TEXTURE_SIZE + v] = pixelFromArgb(argb);
+				//half the intensity, as LCD_COLOR_DARKRED is to LCD_COLOR_BROWN
+				dark[u * TEXTURE_SIZE + v] = pixelFromArgb(0xFF000000 | ((argb >> 1) & 0x7F7F7F));
+			}
+	}
+}
+
+/**
+  * @param  id : The texture
+  * @param  dark : true for the copy of the walls hit on a horizontal grid line
+  * @param  texX : The position of the hit along the wall, from 0 to FIXED_ONE
+  * @return the first texel of the texture column at the position, NULL if textureInit() failed
+  */
+const pixel_t* textureColumn(TextureId id, bool dark, fixed texX)
+{
+	if(atlas == NULL)
+		return NULL;
+
+	int u = (texX >> (FIXED_SHIFT - TEXTURE_BITS)) & (TEXTURE_SIZE - 1);
+	return atlas + (id * 2 + dark) * TEXTURE_TEXELS + u * TEXTURE_SIZE;
+}
+
+/**
+  * @brief  Scales a texture column on a span of rows of a column of the frame buffer
+  * @note   The texel of a row is read once and written on the whole width of the column.
+  * @param  dst : The first pixel of the span
+  * @param  stride : The distance in pixel between two rows of the frame buffer
+  * @param  width : The width of the column in pixel
+  * @param  rows : The number of rows of the span
+  * @param  column : The texture column, from textureColumn()
+  * @param  texY : The texel row of the first pixel in Q16.16
+  * @param  step : The texel rows between two pixel rows in Q16.16
+  * @return the first pixel of the row below the span
+  */
+pixel_t* textureSpan(pixel_t *dst, int stride, int width, int rows, const pixel_t *column, fixed texY, fixed step)
+{
+	if(width == 1)
+	{
+		for(int y = 0; y < rows; y++, dst += stride, texY += step)
+			*dst = column[(texY >> FIXED_SHIFT) & (TEXTURE_SIZE - 1)];
+		return dst;
+	}
+
+	for(int y = 0; y < rows; y++, dst += stride, texY += step)
+	{
+		pixel_t texel = column[(texY >> FIXED_SHIFT) & (TEXTURE_SIZE - 1)];
+		for(int x = 0; x < width; x++)
+			dst[x] = texel;
+	}
+	return dst;
+}
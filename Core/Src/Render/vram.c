@@ -0,0 +1,36 @@
+/*
+ * vram.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/vram.h"
+#include "stm32f769i_discovery_sdram.h"
+#include <stddef.h>
+
+//first free byte of the SDRAM
+static uint32_t vramNext = SDRAM_DEVICE_ADDR;
+
+/**
+  * @brief  Allocates a block of SDRAM, the block can't be freed
+  * @param  size : The size of the block in bytes
+  * @return the VRAM_ALIGN aligned block, NULL if the SDRAM is full
+  */
+void* vramAlloc(uint32_t size)
+{
+	uint32_t addr = (vramNext + VRAM_ALIGN - 1) & ~(uint32_t)(VRAM_ALIGN - 1);
+	if(size > SDRAM_DEVICE_ADDR + SDRAM_DEVICE_SIZE - addr)
+		return NULL;
+
+	vramNext = addr + size;
+	return (void*)addr;
+}
+
+/**
+  * @return the number of SDRAM bytes still available
+  */
+uint32_t vramFree(void)
+{
+	return SDRAM_DEVICE_ADDR + SDRAM_DEVICE_SIZE - vramNext;
+}
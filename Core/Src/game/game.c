@@ -1,9 +1,6 @@
 #include "game/game.h"
 #include "render/map.h"
-#include "stm32f769i_discovery_ts.h"
-#include "stm32f769i_discovery_lcd.h"
-#include "task.h"
-#include "timers.h"
+#include "platform/platform.h"
 #include <math.h>
 #include <stdio.h>
 
@@ -13,8 +10,7 @@ static inline void goForward(Player *p, Map *m);
 static inline void goBackward(Player *p, Map *m);
 static inline void rotateCW(Player *p);
 static inline void rotateCCW(Player *p);
-static void playerMovementTouchControls(uint16_t touchX, uint16_t touchY, Player *p, Map *m, Screen *s, int scale);
-static void timer_callback();
+static char touchControlCommand(uint16_t touchX, uint16_t touchY, Screen *s, int scale);
 
 /**
   * @brief  Moves the player forward
@@ -23,11 +19,11 @@ static void timer_callback();
   */
 static inline void goForward(Player *p, Map *m)
 {
-	int offsetX = p->dx > 0 ? 8 : -8;
-	int offsetY = p->dy > 0 ? 8 : -8;
+	int offsetX = p->dx > 0 ? PLAYER_MARGIN : -PLAYER_MARGIN;
+	int offsetY = p->dy > 0 ? PLAYER_MARGIN : -PLAYER_MARGIN;
 	float futureX = (p->pos.x + p->dx + offsetX);
 	float futureY = (p->pos.y + p->dy + offsetY);
-	if(m->map[(int)(futureY/m->blockSize)*m->mapBlockX+(int)(futureX/m->blockSize)] == 1) //hit wall
+	if(mapFlagsAt(m, futureX, futureY) & MATERIAL_SOLID) //hit wall
 		return;
 	p->pos.x += p->dx;
 	p->pos.y += p->dy;
@@ -40,11 +36,11 @@ static inline void goForward(Player *p, Map *m)
   */
 static inline void goBackward(Player *p, Map *m)
 {
-	int offsetX = p->dx > 0 ? 8 : -8;
-	int offsetY = p->dy > 0 ? 8 : -8;
+	int offsetX = p->dx > 0 ? PLAYER_MARGIN : -PLAYER_MARGIN;
+	int offsetY = p->dy > 0 ? PLAYER_MARGIN : -PLAYER_MARGIN;
 	float futureX = (p->pos.x - p->dx + offsetX);
 	float futureY = (p->pos.y - p->dy + offsetY);
-	if(m->map[(int)futureY/m->blockSize*m->mapBlockX+(int)(futureX/m->blockSize)] == 1) //hit wall
+	if(mapFlagsAt(m, futureX, futureY) & MATERIAL_SOLID) //hit wall
 		return;
 	p->pos.x -= p->dx;
 	p->pos.y -= p->dy;
@@ -60,8 +56,8 @@ static inline void rotateCW(Player *p)
 	p->angle+=0.1;
 	if(p->angle > 2*M_PI)
 		p->angle -= 2*M_PI;
-	p->dx = cos(p->angle)*5;
-	p->dy = sin(p->angle)*5;
+	p->dx = cos(p->angle)*PLAYER_SPEED;
+	p->dy = sin(p->angle)*PLAYER_SPEED;
 }
 
 /**
@@ -74,63 +70,57 @@ static inline void rotateCCW(Player *p)
 	p->angle-=0.1;
 	if(p->angle < 0)
 		p->angle += 2*M_PI;
-	p->dx = cos(p->angle)*5;
-	p->dy = sin(p->angle)*5;
+	p->dx = cos(p->angle)*PLAYER_SPEED;
+	p->dy = sin(p->angle)*PLAYER_SPEED;
 }
 
 /**
-  * @brief moves the player based on the touched touch screen panel area as a consequence
-  * @param  p : The Player that needs to be rotated
-  * @param  m : The Map on which the player stays
+  * @brief finds the movement command of the touched touch screen panel area
   * @param  s : The Screen used to display the game and detect touches
   * @param  scale : the current scale compared to the size of a rectangle of the map of the touchable area
   * @param  touchX : the x coordinate of the touched point on the panel
   * @param  touchY : the y coordinate of the touched point on the panel
+  * @return the command of playerMovementKeyboard() of the control, 0 if no control has been touched
   */
-static void playerMovementTouchControls(uint16_t touchX, uint16_t touchY, Player *p, Map *m, Screen *s, int scale)
+static char touchControlCommand(uint16_t touchX, uint16_t touchY, Screen *s, int scale)
 {
-	int mapBlockX = m->mapBlockX / scale;
-	int mapBlockY = m->mapBlockY / scale;
+	int mapBlockX = CONTROLS_GRID_X / scale;
+	int mapBlockY = CONTROLS_GRID_Y / scale;
 
 	if(touchX > (s->width / mapBlockX) * (mapBlockX-3) && touchX < (s->width / mapBlockX) * (mapBlockX-2)  && touchY > (s->height / mapBlockY) * (mapBlockY-1))
-		rotateCCW(p);
+		return 'a';
 	else if(touchX > (s->width / mapBlockX) * (mapBlockX-1) && touchY > (s->height / mapBlockY) * (mapBlockY-1))
-		rotateCW(p);
+		return 'd';
 	else if(touchX < (s->width / mapBlockX) && touchY > (s->height / mapBlockY) * (mapBlockY-2) && touchY < (s->height / mapBlockY) * (mapBlockY-1))
-		goForward(p, m);
+		return 'w';
 	else if(touchX < (s->width / mapBlockX) && touchY > (s->height / mapBlockY) * (mapBlockY-1))
-		goBackward(p, m);
+		return 's';
+	return 0;
 }
 
 /**
-  * @brief  detects if the defined area of the touch screen panel has been touched and pass the coordinates to the playerMovementTouchControls function
-  * @param  p : The Player that needs to be rotated
-  * @param  m : The Map on which the player stays
+  * @brief  checks if the defined areas of the touch screen panel have been touched and translates them in the
+  * 		commands of playerMovementKeyboard(), so touch and keyboard drive the player, and are recorded, the same way
   * @param  s : The Screen used to display the game and detect touches
   * @param  scale : the current scale compared to the size of a rectangle of the map of the touchable area
+  * @param  touch : the state of the touch panel, as sampled by the input task
+  * @param  commands : Where the commands are written, room for 2
+  * @return the number of commands, one for every touched control
   */
-void playerMovementTouch(Player *p, Map *m, Screen *s, int scale)
+int playerTouchCommands(Screen *s, int scale, const PlatformTouch *touch, char *commands)
 {
-	TS_StateTypeDef TS_State;
-	BSP_TS_GetState(&TS_State);
+	int count = 0;
 
-	if(TS_State.touchDetected)
-	{
-		BaseType_t ret;
-		ret = xSemaphoreTake(*p->player_pos_mut, portMAX_DELAY);
-		if(ret == pdTRUE)
-		{
-			playerMovementTouchControls(TS_State.touchX[0],TS_State.touchY[0], p, m, s, scale);
-			if(TS_State.touchDetected == 2)
-				playerMovementTouchControls(TS_State.touchX[1],TS_State.touchY[1], p, m, s, scale);
-			xSemaphoreGive(*p->player_pos_mut);
-		}
-	}
+	for(int i = 0; i < touch->count && i < 2; i++)
+		if((commands[count] = touchControlCommand(touch->x[i], touch->y[i], s, scale)) != 0)
+			count++;
+
+	return count;
 }
 
 /**
   * @brief  Moves the player based on the character received
-  * @note w(moves forward), a(moves backward), s(rotates to the left), d (rotates to the right)
+  * @note w(moves forward), s(moves backward), a(rotates to the left), d (rotates to the right)
   * @param  p : The Player that needs to be rotated
   * @param  m : The Map on which the player stays
   * @param  s : The Screen used to display the game and detect touches
@@ -138,95 +128,104 @@ void playerMovementTouch(Player *p, Map *m, Screen *s, int scale)
   */
 void playerMovementKeyboard(Player *p, Map *m, char command)
 {
-	BaseType_t ret;
-	ret = xSemaphoreTake(*p->player_pos_mut, portMAX_DELAY);
-	if(ret == pdTRUE)
+	switch(command)
 	{
-		switch(command)
-		{
-		case 'w':
-			goForward(p, m);
-			break;
-		case 'a':
-			rotateCCW(p);
-			break;
-		case 's':
-			goBackward(p, m);
-			break;
-		case 'd':
-			rotateCW(p);
-			break;
-		}
-		xSemaphoreGive(*p->player_pos_mut);
+	case 'w':
+		goForward(p, m);
+		break;
+	case 'a':
+		rotateCCW(p);
+		break;
+	case 's':
+		goBackward(p, m);
+		break;
+	case 'd':
+		rotateCW(p);
+		break;
 	}
 }
 
 /**
   * @brief  Draws the player position on the map with a black dot
   * @param  p : The Player that needs to be drawn
+  * @param  m : The Map on which the player stays
+  * @param  s : The Screen used to display the game
   */
-void drawMapPlayer(Player *p)
+void drawMapPlayer(Player *p, Map *m, Screen *s)
 {
-	int x = round(p->pos.x) / MAP_SCALE;
-	int y = round(p->pos.y) / MAP_SCALE;
-	int destX = round(p->pos.x +p->dx*10)  / MAP_SCALE;
-	int destY = round(p->pos.y +p->dy*10) / MAP_SCALE;
+	vec2 scale = getMapScale(m, s);
+	if(getMapRect(m, s).width == 0)
+		return;
+	int x = round(p->pos.x * scale.x);
+	int y = round(p->pos.y * scale.y);
+	int destX = round((p->pos.x +p->dx*10) * scale.x);
+	int destY = round((p->pos.y +p->dy*10) * scale.y);
 
-	BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
-	BSP_LCD_DrawPixel(x, y, LCD_COLOR_BLACK);
-	BSP_LCD_DrawLine(x,y,destX,destY);
+	platformSetTextColor(COLOR_BLACK);
+	platformDrawPixel(x, y, COLOR_BLACK);
+	platformDrawLine(x,y,destX,destY);
 }
 
 
-static TimerHandle_t timer;
-static int count = 3000;
-
 /**
-  * @brief  Handles what must happen when the player reaches the maze exit as explained in the report pdf document
-  * @param  p : The Player that needs to be checked
-  * @param  m : The Map on which the player stays
-  * @param  s : The Screen used to display the game
+  * @brief  Puts the player back at the start of the first map, facing right, as at boot
+  * @note   Recordings are recorded and replayed from this state, so a replay retraces the recorded path.
+  * @param  g : The state of the game
   */
-void gameLogic(Player *p, Map *m, Screen *s)
+void gameReset(GameState *g)
 {
-	if(m->map[(int)p->pos.y/m->blockSize*m->mapBlockX+(int)(p->pos.x/m->blockSize)] == 2 || count < 3000) //hit wall
-	{
-		BSP_LCD_Clear(LCD_COLOR_BLACK);
-		BSP_LCD_DisplayStringAt(0, s->height/2, (uint8_t*)"WINNER! You've reached the exit, next map in:", CENTER_MODE);
-		char count_s[12];
-		sprintf(count_s, "%d seconds", count/1000);
-		BSP_LCD_DisplayStringAt(0, (s->height/2) + 20, (uint8_t*)count_s, CENTER_MODE);
+	Player *p = &g->player;
 
-		BaseType_t ret;
-		ret = xSemaphoreTake(*p->player_pos_mut, portMAX_DELAY);
-		if(ret == pdTRUE)
-		{
-			p->pos.x = p->initial_pos.x;
-			p->pos.y = p->initial_pos.y;
-			xSemaphoreGive(*p->player_pos_mut);
-		}
+	p->pos = p->initial_pos;
+	p->angle = 0;
+	p->dx = cos(p->angle)*PLAYER_SPEED;
+	p->dy = sin(p->angle)*PLAYER_SPEED;
+	g->exitCountdown = 0;
+	loadMap(&g->map, 0);
+}
+
+/**
+  * @brief  Handles what must happen when the player reaches the maze exit as explained in the report pdf document:
+  * 		the player goes back to the start and after EXIT_SCREEN_MS the next map is loaded
+  * @param  g : The state of the game
+  * @param  elapsedMs : The milliseconds elapsed since the previous call
+  */
+void gameLogic(GameState *g, int elapsedMs)
+{
+	Player *p = &g->player;
+	Map *m = &g->map;
 
-		if(count <= 0)
+	if(g->exitCountdown == 0 && (mapFlagsAt(m, p->pos.x, p->pos.y) & MATERIAL_EXIT)) //reached the exit
+		g->exitCountdown = EXIT_SCREEN_MS;
+	else if(g->exitCountdown > 0)
+	{
+		g->exitCountdown -= elapsedMs;
+		if(g->exitCountdown <= 0)
 		{
-			xTimerStop(timer, portMAX_DELAY);
-			count = 3000;
+			g->exitCountdown = 0;
 			changeMap(m);
 		}
-		else if(count == 3000)
-		{
-			timer = xTimerCreate("tim_win", pdMS_TO_TICKS(1), pdTRUE, NULL, timer_callback);
-			xTimerReset(timer, portMAX_DELAY);
-			xTimerStart(timer, portMAX_DELAY);
-		}
+	}
+
+	if(g->exitCountdown > 0)
+	{
+		p->pos.x = p->initial_pos.x;
+		p->pos.y = p->initial_pos.y;
 	}
 }
 
 /**
-  * @brief  Callback called by the software timer defined at line 181. It is used to show the screen of congratulations when the player reaches the maze exit
+  * @brief  It draws the screen of congratulations shown while the next map is being loaded
+  * @param  s : The Screen used to display the game
+  * @param  exitCountdown : the milliseconds left before the next map
   */
-void timer_callback()
+void showExitScreen(Screen *s, int exitCountdown)
 {
-	count--;
+	platformClear(COLOR_BLACK);
+	platformDrawString(0, s->height/2, "WINNER! You've reached the exit, next map in:", PLATFORM_ALIGN_CENTER);
+	char count_s[20];
+	sprintf(count_s, "%d seconds", exitCountdown/1000);
+	platformDrawString(0, (s->height/2) + 20, count_s, PLATFORM_ALIGN_CENTER);
 }
 
 /**
@@ -236,10 +235,10 @@ void timer_callback()
   */
 void showPauseScreen(Screen *s, bool show)
 {
-	BSP_LCD_Clear(LCD_COLOR_ORANGE);
-	BSP_LCD_SetBackColor(LCD_COLOR_WHITE);
+	platformClear(COLOR_ORANGE);
+	platformSetBackColor(COLOR_WHITE);
 	if(show)
-		BSP_LCD_DisplayStringAt(0, s->height/2, (uint8_t*)"PAUSE", CENTER_MODE);
+		platformDrawString(0, s->height/2, "PAUSE", PLATFORM_ALIGN_CENTER);
 }
 
 /**
@@ -249,13 +248,13 @@ void showPauseScreen(Screen *s, bool show)
   */
 void showStartScreen(Screen *s, bool show)
 {
-	BSP_LCD_Clear(LCD_COLOR_ORANGE);
-	BSP_LCD_DisplayStringAt(0, s->height/2, (uint8_t*)"RAYCAST MAZE", CENTER_MODE);
+	platformClear(COLOR_ORANGE);
+	platformDrawString(0, s->height/2, "RAYCAST MAZE", PLATFORM_ALIGN_CENTER);
 
 	if(show)
 	{
-		BSP_LCD_DisplayStringAt(0, (s->height)/2 + 30, (uint8_t*)"PRESS THE USER BUTTON TO PLAY", CENTER_MODE);
+		platformDrawString(0, (s->height)/2 + 30, "PRESS THE USER BUTTON TO PLAY", PLATFORM_ALIGN_CENTER);
 	}
 
-	BSP_LCD_DisplayStringAt(0, (s->height) - 25, (uint8_t*)"Mrnikifabio 2022, SUPSI DTI-ISEA", CENTER_MODE);
+	platformDrawString(0, (s->height) - 25, "Mrnikifabio 2022, SUPSI DTI-ISEA", PLATFORM_ALIGN_CENTER);
 }
@@ -0,0 +1,257 @@
+/*
+ * replay.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "game/replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+//the step of an event has the 24 bits above the command
+#define MAX_STEPS (1UL << 24)
+
+const char replayDemo[] =
+	"# start to exit of the first map\n"
+	"0-14 a\n15-25 w\n26 a\n27-36 w\n37 d\n38-43 w\n"
+	"44 a\n45-48 w\n49 d\n50-52 w\n53 a\n54 w\n"
+	"55-70 d\n71-117 w\n118 a\n119-125 w\n126 d\n127-131 w\n"
+	"132 a\n133-135 w\n136 d\n137 w\n138-152 d\n153-166 w\n"
+	"167 d\n168-171 w\n172 a\n173-175 w\n176 d\n177-178 w\n"
+	"179-193 a\n194 w\n195 a\n196-204 w\n205 d\n206-211 w\n"
+	"212 a\n213-216 w\n217 d\n218-220 w\n221-234 d\n235-249 w\n"
+	"250-264 a\n265-287 w\n288 d\n289-294 w\n295 a\n296-299 w\n"
+	"300 d\n301-303 w\n304 a\n305-306 w\n307 d\n308 w\n"
+	"309-322 d\n323-337 w\n338-351 a\n352-355 w\n356 d\n357 w\n"
+	"end 489\n";
+
+/**
+  * @brief  Empties a recording
+  * @param  r : The recording
+  */
+void replayClear(Recording *r)
+{
+	r->count = 0;
+	r->steps = 0;
+	r->complete = false;
+	r->overflow = false;
+}
+
+/**
+  * @brief  Appends a command to a recording, the steps of the commands must not decrease
+  * @param  r : The recording
+  * @param  step : The simulation step the command is applied in
+  * @param  command : The command of playerMovementKeyboard()
+  * @return false if the recording is full or the step has already REPLAY_STEP_COMMANDS commands
+  */
+bool replayAdd(Recording *r, uint32_t step, char command)
+{
+	int sameStep = 0;
+
+	for(uint32_t i = r->count; i > 0 && r->events[i - 1] >> 8 == step; i--)
+		sameStep++;
+
+	if(r->count == REPLAY_MAX_EVENTS || sameStep == REPLAY_STEP_COMMANDS || step >= MAX_STEPS)
+	{
+		r->overflow = true;
+		return false;
+	}
+
+	r->events[r->count++] = step << 8 | (uint8_t)command;
+	return true;
+}
+
+/**
+  * @brief  Completes a recording
+  * @param  r : The recording
+  * @param  steps : The number of steps recorded, the last command included
+  */
+void replayStop(Recording *r, uint32_t steps)
+{
+	r->steps = steps;
+	r->complete = true;
+}
+
+/**
+  * @brief  Gets the commands of a step, the steps must be asked in order
+  * @param  r : The recording
+  * @param  cursor : The index of the next event, 0 before the first step
+  * @param  step : The step
+  * @param  commands : Where the commands are written, room for REPLAY_STEP_COMMANDS
+  * @return the number of commands of the step
+  */
+int replayCommands(const Recording *r, uint32_t *cursor, uint32_t step, char *commands)
+{
+	int count = 0;
+
+	while(*cursor < r->count && r->events[*cursor] >> 8 <= step)
+	{
+		uint32_t event = r->events[(*cursor)++];
+		if(event >> 8 == step && count < REPLAY_STEP_COMMANDS)
+			commands[count++] = (char)(event & 0xff);
+	}
+
+	return count;
+}
+
+static const char* skipSpaces(const char *p)
+{
+	while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+		p++;
+	return p;
+}
+
+/**
+  * @brief  Reads a step number, only digits are accepted
+  * @return the first character after the number, NULL if there is no number
+  */
+static const char* parseStep(const char *p, uint32_t *step)
+{
+	char *end;
+	unsigned long value;
+
+	if(!isdigit((unsigned char)*p))
+		return NULL;
+	value = strtoul(p, &end, 10);
+	if(value >= MAX_STEPS)
+		return NULL;
+	*step = value;
+	return end;
+}
+
+/**
+  * @brief  Parses a line of the text form of a recording, see replay.h, and adds its events to a recording
+  * @note   The steps of the lines must not decrease, a recording is only complete once its end line is parsed.
+  * @param  r : The recording, emptied by replayClear() before the first line
+  * @param  line : The line, terminated, with or without its line ending
+  * @return the kind of line, REPLAY_LINE_ERROR if it is malformed or its commands don't fit
+  */
+ReplayLine replayParseLine(Recording *r, const char *line)
+{
+	const char *p = skipSpaces(line);
+	uint32_t first, last, lastEvent = r->count ? r->events[r->count - 1] >> 8 : 0;
+	int length;
+
+	if(*p == '\0' || *p == '#')
+		return REPLAY_LINE_OK;
+	if(r->complete)
+		return REPLAY_LINE_ERROR;
+
+	if(strncmp(p, "end", 3) == 0)
+	{
+		p = parseStep(skipSpaces(p + 3), &last);
+		if(p == NULL || *skipSpaces(p) != '\0' || (r->count && last <= lastEvent))
+			return REPLAY_LINE_ERROR;
+		replayStop(r, last);
+		return REPLAY_LINE_END;
+	}
+
+	p = parseStep(p, &first);
+	last = first;
+	if(p != NULL && *p == '-')
+		p = parseStep(p + 1, &last);
+	if(p == NULL || last < first || (r->count && first < lastEvent) || (*p != ' ' && *p != '\t'))
+		return REPLAY_LINE_ERROR;
+
+	p = skipSpaces(p);
+	length = strspn(p, REPLAY_COMMANDS);
+	if(length == 0 || *skipSpaces(p + length) != '\0')
+		return REPLAY_LINE_ERROR;
+
+	for(uint32_t step = first; step <= last; step++)
+		for(int i = 0; i < length; i++)
+			if(!replayAdd(r, step, p[i]))
+				return REPLAY_LINE_ERROR;
+
+	return REPLAY_LINE_OK;
+}
+
+/**
+  * @brief  Parses the whole text form of a recording
+  * @param  r : The recording, it is emptied first
+  * @param  text : The text, terminated, with a line ending after every line
+  * @return true if every line is valid and the text has an end line
+  */
+bool replayParse(Recording *r, const char *text)
+{
+	char line[REPLAY_LINE_SIZE];
+
+	replayClear(r);
+	while(*text != '\0')
+	{
+		size_t length = strcspn(text, "\n");
+
+		if(length >= sizeof(line))
+			return false;
+		memcpy(line, text, length);
+		line[length] = '\0';
+		if(replayParseLine(r, line) == REPLAY_LINE_ERROR)
+			return false;
+		text += text[length] == '\n' ? length + 1 : length;
+	}
+
+	return r->complete;
+}
+
+/**
+  * @brief  Gets the commands of the step of an event
+  * @param  r : The recording
+  * @param  i : The index of the event, moved after the last event of the step
+  * @param  commands : Where the commands are written, terminated
+  */
+static void stepCommands(const Recording *r, uint32_t *i, char *commands)
+{
+	uint32_t step = r->events[*i] >> 8;
+	int count = 0;
+
+	while(*i < r->count && r->events[*i] >> 8 == step && count < REPLAY_STEP_COMMANDS)
+		commands[count++] = (char)(r->events[(*i)++] & 0xff);
+	commands[count] = '\0';
+}
+
+/**
+  * @brief  Prints the text form of a recording, a line at a time
+  * @note   The consecutive steps with the same commands are printed as a single range.
+  * @param  r : The recording
+  * @param  print : The function printing a line, the lines end with \r\n
+  */
+void replayWrite(const Recording *r, void (*print)(const char *line))
+{
+	char line[REPLAY_LINE_SIZE];
+	char commands[REPLAY_STEP_COMMANDS + 1], next[REPLAY_STEP_COMMANDS + 1];
+	uint32_t i = 0;
+
+	snprintf(line, sizeof(line), "# %lu events%s\r\n", (unsigned long)r->count, r->overflow ? ", some lost" : "");
+	print(line);
+
+	while(i < r->count)
+	{
+		uint32_t first = r->events[i] >> 8, last = first;
+
+		stepCommands(r, &i, commands);
+		while(i < r->count && r->events[i] >> 8 == last + 1)
+		{
+			uint32_t j = i;
+			stepCommands(r, &j, next);
+			if(strcmp(next, commands) != 0)
+				break;
+			i = j;
+			last++;
+		}
+
+		if(first == last)
+			snprintf(line, sizeof(line), "%lu %s\r\n", (unsigned long)first, commands);
+		else
+			snprintf(line, sizeof(line), "%lu-%lu %s\r\n", (unsigned long)first, (unsigned long)last, commands);
+		print(line);
+	}
+
+	if(r->complete)
+	{
+		snprintf(line, sizeof(line), "end %lu\r\n", (unsigned long)r->steps);
+		print(line);
+	}
+}
@@ -0,0 +1,53 @@
+/*
+ * snapshot.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "game/snapshot.h"
+#include "platform/seqlock.h"
+#include <string.h>
+
+/**
+  * @brief  Sets up a snapshot, it must be called before the tasks using it are started
+  * @param  s : The snapshot
+  * @param  storage : The memory holding the published value, size bytes
+  * @param  size : The size of the value
+  * @param  initial : The value read until the first snapshotWrite()
+  */
+void snapshotInit(Snapshot *s, void *storage, uint32_t size, const void *initial)
+{
+	s->seq = 0;
+	s->value = storage;
+	s->size = size;
+	memcpy(storage, initial, size);
+}
+
+/**
+  * @brief  Publishes a new value, only one task may write a snapshot
+  * @param  s : The snapshot
+  * @param  value : The new value, size bytes
+  */
+void snapshotWrite(Snapshot *s, const void *value)
+{
+	seqlockWriteBegin(&s->seq);
+	memcpy(s->value, value, s->size);
+	seqlockWriteEnd(&s->seq);
+}
+
+/**
+  * @brief  Copies the latest published value
+  * @param  s : The snapshot
+  * @param  value : Where the value is copied, size bytes
+  */
+void snapshotRead(Snapshot *s, void *value)
+{
+	uint32_t seq;
+
+	do
+	{
+		seq = seqlockReadBegin(&s->seq);
+		memcpy(value, s->value, s->size);
+	} while(seqlockReadRetry(&s->seq, seq));
+}
@@ -30,142 +30,498 @@
 #include "semphr.h"
 #include "render/screen.h"
 #include "render/render.h"
+#include "render/raycast.h"
+#include "render/texture.h"
+#include "render/blit.h"
+#include "render/overlay.h"
+#include "render/bench.h"
+#include "render/maze.h"
+#include "render/vram.h"
+#include "profile/profile.h"
+#include "profile/frametime.h"
 #include "game/game.h"
+#include "game/snapshot.h"
+#include "game/replay.h"
+#include "serial/uart.h"
+#include "serial/console.h"
+#include "serial/log.h"
+#include "serial/telemetry.h"
+#include "queue.h"
 #include "stm32f769i_discovery_lcd.h"
+#include "stm32f769i_discovery_ts.h"
 #include "tim.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* Private define ------------------------------------------------------------*/
+#define FPS_REFRESH_MS 250	//period of refresh of the fps overlay
+#define TOUCH_RELEASE_MS 50	//while the panel is touched it is read at least this often, in case the interrupt of the release is lost
+#define SIM_PERIOD_MS 25	//period of a step of the simulation task: the player moves 40 times per second
+#define COMMAND_QUEUE_LENGTH 16	//keyboard commands waiting for the simulation task
+#define TELEMETRY_TASKS_MS 1000	//period of the task statistics in the telemetry stream
 /* Private data types definition ---------------------------------------------*/
+//where the simulation task takes the commands moving the player from
+typedef enum {
+	INPUT_LIVE,	//the touch panel and the keyboard
+	INPUT_RECORDING,	//the touch panel and the keyboard, the commands are appended to the recording
+	INPUT_REPLAY	//the recording, the touch panel and the keyboard are ignored
+} InputMode;
 /* Public variables ----------------------------------------------------------*/
-TaskHandle_t uart_rx_task_handler;
 TaskHandle_t button_task_handler;
+TaskHandle_t input_task_handler;
 /* Private variables ---------------------------------------------------------*/
 static TaskHandle_t main_task_handler;	//main task handle
-static SemaphoreHandle_t player_pos_mut;  //mutex used by various tasks to claim the player position object
-static Player p; //the player object represents the user in the game
-static Map map; //the map object represents the current map that is used to render the 3D world
+static TaskHandle_t sim_task_handler;
+static TaskHandle_t uart_task_handler;
+static QueueHandle_t command_queue; //keyboard commands of the navigation mode, consumed by the simulation task
+static GameState game; //the player and the current map, owned by the simulation task
+static GameState frame; //the copy of the game drawn in the current frame, owned by the main task
+static PlatformTouch touchValue;
+static GameState gameValue;
+static Snapshot touchSnapshot; //the last sample of the touch panel, written by the input task
+static Snapshot gameSnapshot; //the state of the game after the last step, written by the simulation task
 
 
 static bool showMap;
 static bool showFPSCounter;
+static bool showFrameGraph; //draws the frame time graph under the fps overlay
 static bool firstLaunch;
 static bool pause;
 static bool showText; //used to animate the text in the welcome and pause screen
-static int frameCounter = 0;
-static int frameCounterToShow = 0; //current fps value to actually print on the screen
+static volatile bool benchRequested; //the renderer benchmark runs in place of the next frame
+static volatile bool textBenchRequested; //the text benchmark runs in place of the next frame
+static volatile bool mazeBenchRequested; //the maze benchmark runs in place of the next frame
+static volatile bool telemetryOn; //the main task streams the telemetry packets on the console
+static uint32_t frameCount; //frames drawn since boot
+static TickType_t tasksSent; //tick count of the last telemetry packet of the tasks
+static ProfileTasks telemetryTasks; //run time of the tasks at the last telemetry packet of the tasks
+static uint8_t telemetryPacket[TELEMETRY_MAX_ENCODED];
+static bool navigating; //the characters received on the console move the player instead of being commands
+static Recording recording; //the recording of the i command, used by the simulation task unless the input is live
+static volatile InputMode inputMode; //the input of the simulation task, changed by it only
+static volatile InputMode inputRequest; //the input asked by the console, taken by the simulation task at its next step
+static volatile bool inputRequested;
+static bool loadingRecording; //the lines received on the console are a recording instead of being commands
+static volatile bool mazeRequested; //the maze of the z command is built by the simulation task at its next step
+static int mazeSize;
+static uint32_t mazeSeed;
+static MazeStyle mazeStyle;
+static uint8_t *mazeStorage[2]; //blocks of the maze played and of the next one, used in turn
+static int mazeNext;
+static const uint8_t * volatile blocksDrawn; //blocks of the map of the frame drawn by the main task
+static TickType_t fpsUpdated; //tick count of the last refresh of the fps overlay
+static char fps[48]; //text of the fps overlay
+static uint8_t *mapShown; //map currently drawn in the map overlay and the revision of its blocks
+static uint32_t mapShownRevision;
+static int mapOverlay, controlsOverlay, fpsOverlay; //ids of the cached HUD overlays
 
 
 /* Private function prototypes -----------------------------------------------*/
 static void main_task( void *pvParameters );
+static void input_task( void *pvParameters );
+static void sim_task( void *pvParameters );
 static void uart_task( void *pvParameters );
 static void button_task(void *pvParameters);
-static void cmd_parser_execute(char *cmd);
-static void navigation_mode();
-static void show_menu();
+static void cmd_parser_execute(Console *console);
+static void navigation_key(char key);
+static void cmd_show_menu(int argc, char **argv);
+static void cmd_navigation(int argc, char **argv);
+static void cmd_toggle_map(int argc, char **argv);
+static void cmd_toggle_fps(int argc, char **argv);
+static void cmd_toggle_graph(int argc, char **argv);
+static void cmd_resolution(int argc, char **argv);
+static void cmd_buffering(int argc, char **argv);
+static void cmd_screen_stats(int argc, char **argv);
+static void cmd_hud_mode(int argc, char **argv);
+static void cmd_textures(int argc, char **argv);
+static void cmd_map_rays(int argc, char **argv);
+static void cmd_benchmark(int argc, char **argv);
+static void cmd_profile(int argc, char **argv);
+static void cmd_pause(int argc, char **argv);
+static void cmd_telemetry(int argc, char **argv);
+static void cmd_input(int argc, char **argv);
+static void cmd_maze(int argc, char **argv);
+static void cmd_distance(int argc, char **argv);
+static void load_recording_line(Console *console);
+static void set_input_mode(InputMode mode, uint32_t steps);
+static bool load_maze();
+static void run_benchmark();
+static void send_telemetry(bool playing);
+static void draw_map_overlay();
+static void draw_controls_overlay();
+static void draw_fps_overlay();
+static void update_fps_overlay();
+
+//commands of the serial console, listed by the menu in this order
+static const ConsoleCommand commands[] = {
+	{ "m", "Show menu", cmd_show_menu },
+	{ "n", "Control player", cmd_navigation },
+	{ "b", "Show Map", cmd_toggle_map },
+	{ "f", "Show FPS Counter", cmd_toggle_fps },
+	{ "g", "Show frame time graph", cmd_toggle_graph },
+	{ "r", "Change resolution, r <n> selects the resolution n", cmd_resolution },
+	{ "t", "Toggle double / triple buffering", cmd_buffering },
+	{ "s", "Show frame pacing statistics", cmd_screen_stats },
+	{ "h", "Toggle HUD on the second LCD layer", cmd_hud_mode },
+	{ "x", "Toggle wall textures", cmd_textures },
+	{ "v", "Change the rays on the map, v <n> selects 0 lines of the BSP, 1 clipped lines, 2 filled fan", cmd_map_rays },
+	{ "k", "Run the renderer benchmark, k text compares the text drawing methods, k maze the map sizes", cmd_benchmark },
+	{ "c", "Show profiler zones, task CPU usage and stack", cmd_profile },
+	{ "y", "Toggle the binary telemetry stream, see Host/telemetry_decode.c", cmd_telemetry },
+	{ "i", "Input recording: i rec | stop | play [demo] | dump | load", cmd_input },
+	{ "z", "Play a maze: z <size 5-256> [seed] [braid]", cmd_maze },
+	{ "d", "Show the view distance in blocks, d <n> sets it, d 0 removes the limit", cmd_distance },
+	{ "p", "Play / Pause", cmd_pause },
+};
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
 
 /* Functions definition ------------------------------------------------------*/
 /**
   * @brief Create the FreeRTOS objects and tasks. Configures initial player position and direction. Configures initial game settings e map size.
+  * @note  A frame goes through three tasks: the input task reads the touch panel, the simulation task moves
+  * 	   the player at a fixed rate and the main task draws the last state of the game. They hand the data
+  * 	   over with snapshots, so the blocking I2C reads and the game logic never delay a frame.
   * @return true if the tasks are created, false otherwise.
   */
 void freeRTOS_user_init(void)
 {
-	player_pos_mut = xSemaphoreCreateMutex();
-	p.player_pos_mut = &player_pos_mut;
-
-	//number of horizontal blocks in the map
-	map.mapBlockX = 20;
-	//number of vertical blocks in the map
-	map.mapBlockY = 12;
-
-	//size in pixel of a block
-	map.blockSize = 40;
+	Player *p = &game.player;
+	Map *map = &game.map;
+	PlatformTouch noTouch = { 0 };
 
 	showMap = false;
 
-	//load the first map
-	changeMap(&map);
+	//import the maps once, before the tasks read them, and load the first one: its size comes with it
+	importMaps();
+	changeMap(map);
+
+	//fill the step tables of the ray caster and generate the wall textures
+	raycastInit();
+	textureInit();
+	setResolution(RESOLUTION_LEGACY, screen);
 
 	firstLaunch = true;
 	showFPSCounter = true;
 	pause = false;
 	showText = true;
 
-	p.initial_pos.x = 95; p.initial_pos.y = 320;
-	p.pos.x=95; p.pos.y=320;
+	p->initial_pos.x = 152; p->initial_pos.y = 512;
+	p->pos.x=152; p->pos.y=512;
 
 	//set initial direction of the player
-	p.dx = cos(p.angle)*5;
-	p.dy = sin(p.angle)*5;
+	p->dx = cos(p->angle)*PLAYER_SPEED;
+	p->dy = sin(p->angle)*PLAYER_SPEED;
+
+	frame = game;
+	snapshotInit(&touchSnapshot, &touchValue, sizeof(PlatformTouch), &noTouch);
+	snapshotInit(&gameSnapshot, &gameValue, sizeof(GameState), &game);
+	command_queue = xQueueCreate(COMMAND_QUEUE_LENGTH, sizeof(char));
+	//the console can be written by any task as soon as the scheduler starts
+	ct_uart_init(&huart1);
 
+	//the HUD is drawn once into a cache and copied on every frame, it is drawn again only when it changes
+	Rect rects[CONTROLS];
+	ct_overlay_init(screen);
+	rects[0] = getMapRect(map, screen);
+	mapOverlay = ct_overlay_add(draw_map_overlay, rects, 1);
+	//on the HUD layer the minimap is translucent, so the rays drawn under it on the 3D view show through
+	ct_overlay_set_alpha(mapOverlay, 160);
+	getControlRects(screen, 2, rects);
+	controlsOverlay = ct_overlay_add(draw_controls_overlay, rects, CONTROLS);
+	fpsOverlay = ct_overlay_add(draw_fps_overlay, rects, 0);
+
+	//the main task draws the frames and runs the benchmarks, formats the fps overlay and the telemetry of the
+	//tasks on its stack, and every interrupt stacks its FPU frame there too
 	xTaskCreate( main_task,		//Task function
 				"main_task",					//Task function comment
-				256,							//Task stack dimension (1kB)
+				8*configMINIMAL_STACK_SIZE,		//Task stack dimension (4kB)
 				NULL,							//Task parameter
 				1,								//Task priority
 				&main_task_handler );			//Task handle
 
+	//the producers of the pipeline run above the main task: a snapshot reader must not preempt its writer
+	xTaskCreate(input_task, "input_task", 2*configMINIMAL_STACK_SIZE, NULL, 3, &input_task_handler);
+	//the simulation task formats the report of a replay on its stack
+	xTaskCreate(sim_task, "sim_task", 3*configMINIMAL_STACK_SIZE, NULL, 2, &sim_task_handler);
 	xTaskCreate(button_task, "button_task", configMINIMAL_STACK_SIZE, NULL, 1, &button_task_handler);
-	xTaskCreate(uart_task, "uart_task", configMINIMAL_STACK_SIZE, NULL, 1, &uart_rx_task_handler);
+	//the uart task formats the reports of the console commands on its stack
+	xTaskCreate(uart_task, "uart_task", 3*configMINIMAL_STACK_SIZE, NULL, 1, &uart_task_handler);
 }
 
 /**
-  * @brief  Main loop task: every cycle renders a frame and handles the game logic.
+  * @brief  Main loop task: every cycle renders a frame of the last state published by the simulation task.
   * @param pvParameters : void* parameters that might be needed by the task
   */
 static void main_task( void *pvParameters )
 {
-	char fps[10];
 	HAL_TIM_Base_Start_IT(&htim2);
 
 	while(1){
-		ct_screen_flip_buffers(screen);
+		bool playing = !firstLaunch && !pause;
 
-		if(firstLaunch)
-			showStartScreen(screen, showText);
-		else if(!pause)
+		if(benchRequested || textBenchRequested || mazeBenchRequested)
 		{
-			playerMovementTouch(&p, &map, screen, 2);
-			drawBackground(screen);
-			castRays(p.pos.x, p.pos.y, p.angle, &map);
-			drawRays(&map, screen, p.angle);
+			run_benchmark();
+			continue;
+		}
 
-			if(showMap)
+		uint32_t frameStart = profileBegin();
+
+		//the whole frame is drawn from the same state of the game, however the simulation goes on meanwhile
+		snapshotRead(&gameSnapshot, &frame);
+		//a maze is not built into these blocks until the next frame, see load_maze()
+		blocksDrawn = frame.map.blocks;
+
+		//the rays are casted while the flip of the previous frame waits for the vertical blanking
+		if(playing)
+			PROFILE_SCOPE(PROFILE_CAST)
+				castRays(frame.player.pos.x, frame.player.pos.y, frame.player.angle, &frame.map);
+
+		PROFILE_SCOPE(PROFILE_WAIT)
+			ct_screen_wait_backbuffer(screen);
+
+		if(playing)
+		{
+			PROFILE_SCOPE(PROFILE_WALLS)
+				drawRays(&frame.map, screen);
+
+			PROFILE_SCOPE(PROFILE_HUD)
 			{
-				drawMap(&map, screen);
-				drawMapRays(p.pos.x, p.pos.y);
-				drawMapPlayer(&p);
+				if(frame.map.blocks != mapShown || frame.map.revision != mapShownRevision)
+				{
+					//the maps built at run time can have another size, or be too large to be drawn
+					Rect mapRect = getMapRect(&frame.map, screen);
+					mapShown = frame.map.blocks;
+					mapShownRevision = frame.map.revision;
+					ct_overlay_set_rects(mapOverlay, &mapRect, mapRect.width != 0);
+				}
+				if(showFPSCounter && xTaskGetTickCount() - fpsUpdated >= pdMS_TO_TICKS(FPS_REFRESH_MS))
+					update_fps_overlay();
+				ct_overlay_set_visible(mapOverlay, showMap);
+				ct_overlay_set_visible(fpsOverlay, showFPSCounter);
+				ct_overlay_show_layer(true);
+				ct_overlay_composite(screen);
+
+				if(showMap)
+				{
+					drawMapRays(frame.player.pos.x, frame.player.pos.y, &frame.map, screen);
+					drawMapPlayer(&frame.player, &frame.map, screen);
+				}
+				if(showFrameGraph)
+					frameTimeDrawGraph(screen->width - FRAMETIME_GRAPH_WIDTH, BSP_LCD_GetFont()->Height);
 			}
 
-			drawControls(screen, &map, 2);
-			gameLogic(&p, &map, screen);
+			if(frame.exitCountdown > 0)
+				showExitScreen(screen, frame.exitCountdown);
+		}
+		else PROFILE_SCOPE(PROFILE_MENU)
+		{
+			//the full screen pages hide the HUD layer, in copy mode the overlays are simply not composited
+			ct_overlay_show_layer(false);
+			if(firstLaunch)
+				showStartScreen(screen, showText);
+			else
+				showPauseScreen(screen, showText);
+		}
+
+		PROFILE_SCOPE(PROFILE_FLIP)
+		{
+			ct_blit_wait(ct_blit_fence());
+			ct_screen_flip_buffers(screen);
+		}
+		frameTimeMark();
+		frameCount++;
+
+		profileEnd(PROFILE_FRAME, frameStart);
+
+		if(telemetryOn)
+			send_telemetry(playing);
+	}
+}
+
+/**
+  * @brief  Input task: reads the touch panel when its controller signals new data and publishes the state in touchSnapshot.
+  * @note   The FT6x06 pulses its INT line for every new report while the panel is touched, the EXTI callback
+  * 		notifies this task with the cycle counter of the pulse. Nothing is read over I2C while nobody touches
+  * 		the panel; while somebody does, a read every TOUCH_RELEASE_MS at least makes sure the release is seen.
+  * @param pvParameters : void* parameters that might be needed by the task
+  */
+static void input_task( void *pvParameters )
+{
+	PlatformTouch touch = { 0 };
+	uint32_t stamp;
+
+	BSP_TS_ITConfig();
+
+	while(1)
+	{
+		if(xTaskNotifyWait(0, 0, &stamp, touch.count ? pdMS_TO_TICKS(TOUCH_RELEASE_MS) : portMAX_DELAY) != pdTRUE)
+			stamp = platformCycles();
+
+		PROFILE_SCOPE(PROFILE_INPUT)
+			platformGetTouch(&touch);
+		touch.stamp = stamp;
+		snapshotWrite(&touchSnapshot, &touch);
+	}
+}
 
-			//FPS COUNTER
-			frameCounter++;
-			if(showFPSCounter)
+/**
+  * @brief  Simulation task: every SIM_PERIOD_MS it moves the player with the last touch sample and the keyboard
+  * 		commands received meanwhile, or with the commands of the step of the recording being replayed, runs
+  * 		the game logic and publishes the new state in gameSnapshot.
+  * @note   The game is only advanced while it is being played. It is the only task touching the game variable.
+  * 		The touch controls are turned into keyboard commands, so every input moves the player through
+  * 		playerMovementKeyboard() and a recording replays any run exactly.
+  * @param pvParameters : void* parameters that might be needed by the task
+  */
+static void sim_task( void *pvParameters )
+{
+	TickType_t wake = xTaskGetTickCount();
+	PlatformTouch touch;
+	uint32_t touchApplied = 0; //stamp of the last touch sample that moved the player
+	uint32_t step = 0, cursor = 0; //steps since the start of the recording or of the replay, next event replayed
+	char commands[REPLAY_STEP_COMMANDS];
+	int count;
+
+	while(1)
+	{
+		if(inputRequested)
+		{
+			set_input_mode(inputRequest, step);
+			step = cursor = 0;
+			inputRequested = false;
+		}
+		if(mazeRequested && load_maze())
+			mazeRequested = false;
+
+		if(!firstLaunch && !pause)
+			PROFILE_SCOPE(PROFILE_LOGIC)
 			{
-				sprintf(fps, "%d FPS", 1000/frameCounterToShow);
-				BSP_LCD_DisplayStringAt(0, 0, (uint8_t*)fps, RIGHT_MODE);
+				snapshotRead(&touchSnapshot, &touch);
+				if(inputMode == INPUT_REPLAY)
+				{
+					count = replayCommands(&recording, &cursor, step, commands);
+					xQueueReset(command_queue);
+				}
+				else
+				{
+					count = playerTouchCommands(screen, 2, &touch, commands);
+					while(count < REPLAY_STEP_COMMANDS && xQueueReceive(command_queue, &commands[count], 0) == pdTRUE)
+						count++;
+				}
+				if(touch.count && touch.stamp != touchApplied)
+				{
+					profileEnd(PROFILE_TOUCH, touch.stamp);
+					touchApplied = touch.stamp;
+				}
+
+				for(int i = 0; i < count; i++)
+				{
+					if(inputMode == INPUT_RECORDING)
+						replayAdd(&recording, step, commands[i]);
+					//while the exit screen is shown the player stays at the start
+					if(game.exitCountdown == 0)
+						playerMovementKeyboard(&game.player, &game.map, commands[i]);
+				}
+				gameLogic(&game, SIM_PERIOD_MS);
+				snapshotWrite(&gameSnapshot, &game);
+
+				step++;
+				if(inputMode == INPUT_REPLAY && step >= recording.steps)
+					set_input_mode(INPUT_LIVE, step);
 			}
-		}
-		else
-			showPauseScreen(screen, showText);
+		vTaskDelayUntil(&wake, pdMS_TO_TICKS(SIM_PERIOD_MS));
+	}
+}
+
+/**
+  * @brief  Changes the input of the simulation task, it is called by the simulation task only.
+  * @note   Recordings are recorded and replayed from gameReset(). The end of a recording and of a replay are
+  * 		reported on the console, a replay with the frames drawn meanwhile and their average rate.
+  * @param  mode : The new input
+  * @param  steps : The steps of the game since the start of the current recording or replay
+  */
+static void set_input_mode(InputMode mode, uint32_t steps)
+{
+	static TickType_t replayStart;
+	static uint32_t replayFrames;
+
+	if(inputMode == INPUT_RECORDING)
+	{
+		replayStop(&recording, steps);
+		logPrintf("recorded %lu steps, %lu events%s\r\n", (unsigned long)steps, (unsigned long)recording.count,
+				recording.overflow ? ", some lost" : "");
+	}
+	else if(inputMode == INPUT_REPLAY)
+	{
+		uint32_t ms = (xTaskGetTickCount() - replayStart) * portTICK_PERIOD_MS;
+		uint32_t frames = frameCount - replayFrames;
+		uint32_t fps10 = ms ? (uint64_t)frames * 10000 / ms : 0;
+
+		logPrintf("replay %s: %lu steps, %lu frames in %lu ms, %lu.%lu fps\r\n", steps >= recording.steps ? "done" : "stopped",
+				(unsigned long)steps, (unsigned long)frames, (unsigned long)ms, (unsigned long)(fps10 / 10), (unsigned long)(fps10 % 10));
+	}
+
+	if(mode == INPUT_RECORDING)
+		replayClear(&recording);
+	if(mode != INPUT_LIVE)
+	{
+		gameReset(&game);
+		snapshotWrite(&gameSnapshot, &game);
+		xQueueReset(command_queue);
+		replayStart = xTaskGetTickCount();
+		replayFrames = frameCount;
 	}
+	inputMode = mode;
+}
+
+/**
+  * @brief  Builds the maze asked by the z command into the map of the game and puts the player at its start,
+  * 		it is called by the simulation task only.
+  * @note   The mazes are built in turn in two buffers: the frame being drawn may still be using the blocks of
+  * 		the maze played until now. The buffer of the next maze may be the one of the frame being drawn too, if
+  * 		the mazes follow each other faster than the frames: then the maze is built at a later step, once the
+  * 		main task has drawn the frame of the maze before. Once the exit of the maze is reached the game goes on
+  * 		with the maps of map.c.
+  * @return false if the maze must be built at a later step
+  */
+static bool load_maze()
+{
+	Player *p = &game.player;
+	uint32_t size = mapStorageSize(MAZE_MAX_SIZE, MAZE_MAX_SIZE);
+	const uint8_t *drawn = blocksDrawn;
+
+	if(mazeStorage[mazeNext] == NULL)
+		mazeStorage[mazeNext] = vramAlloc(size);
+	if(mazeStorage[mazeNext] == NULL)
+	{
+		logPrint("no SDRAM left for the maze\r\n");
+		return true;
+	}
+	if(drawn >= mazeStorage[mazeNext] && drawn < mazeStorage[mazeNext] + size)
+		return false;
+
+	mazeGenerate(&game.map, mazeStorage[mazeNext], mazeSize, mazeSize, mazeSeed, mazeStyle);
+	mazeNext ^= 1;
+	p->pos.x = MAZE_START;
+	p->pos.y = MAZE_START;
+	p->angle = 0;
+	p->dx = cos(p->angle)*PLAYER_SPEED;
+	p->dy = sin(p->angle)*PLAYER_SPEED;
+	game.exitCountdown = 0;
+	snapshotWrite(&gameSnapshot, &game);
+	return true;
 }
 
 /**
   * @brief Callback called by Timer2 ISR. Timer2 timeout expires every second.
-  * @note The function resets the fps counter used in the main loop.
   * @note It also negate the boolean value used to animate text in the welcome and pause screen
   */
 void secondElapsed()
 {
 	showText = !showText;
-	frameCounterToShow = frameCounter;
-	frameCounter = 0;
 }
 
 /**
@@ -188,90 +544,520 @@ static void button_task(void *pvParameters)
 }
 
 /**
-  * @brief  Checks if target device is ready for communication.
-  * @note   This function is used with Memory devices
-  * @param  i2c_handler : I2C handler
-  * @param  DevAddress: Target device address
-  * @param  Trials: Number of trials
-  * @retval HAL status
+  * @brief  Console task: reads the characters received by the UART and executes the commands.
+  * @note   The characters arrive in bursts through the DMA receiver of serial/uart.c, a burst wakes up the
+  * 		task once. In navigation mode every character is a key moving the player, otherwise they are
+  * 		collected in lines and every line is a command, or a line of a recording after i load.
+  * @param pvParameters : void* parameters that might be needed by the task
   */
 static void uart_task(void *pvParameters)
 {
-	char cmd_buffer[20];
-	int i = 0;
-	uint32_t byte;
+	uint8_t received[UART_RX_DMA_SIZE];
+	uint32_t count;
+	Console console;
+
+	consoleInit(&console);
 
 	while(1)
 	{
-		HAL_UART_Receive_IT(&huart1, (uint8_t *)&huart1.Instance->RDR, sizeof(char));
-		xTaskNotifyWait(0, 0, &byte, portMAX_DELAY);
-		cmd_buffer[i++] = (char)byte;
-		if(byte != '\r' && i <= 17)
-			continue;
-		cmd_buffer[i++] = '\n';
-		cmd_buffer[i++] = '\0';
-		cmd_parser_execute(cmd_buffer);
-		memset(cmd_buffer, 0, sizeof(cmd_buffer));
-		i = 0;
+		count = ct_uart_read(received, sizeof(received), portMAX_DELAY);
+		for(uint32_t i = 0; i < count; i++)
+		{
+			if(navigating)
+				navigation_key((char)received[i]);
+			else if(!consoleFeed(&console, (char)received[i]))
+				continue;
+			else if(loadingRecording)
+				load_recording_line(&console);
+			else
+				cmd_parser_execute(&console);
+		}
 	}
 }
 
 /**
-  * @brief  handles the various options of the menu based on the string it receives as a parameter. The function works only if the player is already after the welcome screen
-  * @param  cmd : *char
+  * @brief  Executes the command of a line received on the console. The first line only leaves the welcome screen,
+  * 		while the game is paused only the pause command works.
+  * @param  console : The console holding the line
   */
-static void cmd_parser_execute(char *cmd)
+static void cmd_parser_execute(Console *console)
 {
+	char *argv[CONSOLE_MAX_ARGS];
+	const ConsoleCommand *command;
+	int argc;
+
 	if(firstLaunch)
+	{
 		firstLaunch = false;
+		return;
+	}
+
+	if(console->overflow)
+	{
+		logPrint("line too long\r\n");
+		return;
+	}
+
+	argc = consoleSplit(console->line, argv, CONSOLE_MAX_ARGS);
+	if(argc == 0)
+		return;
+
+	command = consoleFind(commands, COMMAND_COUNT, argv[0]);
+	if(command == NULL)
+	{
+		if(!pause)
+			cmd_show_menu(argc, argv);
+	}
+	else if(!pause || command->run == cmd_pause)
+		command->run(argc, argv);
+}
+
+/**
+  * @brief Sends to USART1 the list of the commands of the console.
+  */
+static void cmd_show_menu(int argc, char **argv)
+{
+	char line[80];
+
+	for(int i = 0; i < COMMAND_COUNT; i++)
+	{
+		snprintf(line, sizeof(line), "%s. %s\r\n", commands[i].name, commands[i].help);
+		logPrint(line);
+	}
+}
+
+/**
+  * @brief  Enters the navigation mode: the following characters are handled by navigation_key() until n is received.
+  */
+static void cmd_navigation(int argc, char **argv)
+{
+	navigating = true;
+}
+
+/**
+  * @brief  Handles a character received in navigation mode.
+  * @note   When it receives w, a, s or d as characters it queues them for the simulation task, which calls playerMovementKeyboard so that the player position can be changed as a consequence.
+  * @note 	When n is received the navigation mode ends.
+  * @param  key : The character
+  */
+static void navigation_key(char key)
+{
+	//the line ending of the command that started the navigation mode
+	if(key == '\r' || key == '\n')
+		return;
+
+	if(key == 'n')
+		navigating = false;
 	else
+		xQueueSend(command_queue, &key, 0);
+}
+
+static void cmd_toggle_map(int argc, char **argv)
+{
+	showMap = !showMap;
+}
+
+static void cmd_toggle_fps(int argc, char **argv)
+{
+	showFPSCounter = !showFPSCounter;
+}
+
+static void cmd_toggle_graph(int argc, char **argv)
+{
+	showFrameGraph = !showFrameGraph;
+}
+
+/**
+  * @brief  Selects the next resolution, or the one given as argument
+  */
+static void cmd_resolution(int argc, char **argv)
+{
+	int res = (getResolution() + 1) % RESOLUTION_COUNT;
+
+	if(argc > 1)
 	{
-		if(cmd[0] == 'p')
-			pause = !pause;
-		else if(!pause)
+		res = atoi(argv[1]);
+		if(res < 0 || res >= RESOLUTION_COUNT)
 		{
-			switch(cmd[0])
-			{
-			case 'n':
-				navigation_mode();
-				break;
-			case 'b':
-				showMap = !showMap;
-				break;
-			case 'f':
-				showFPSCounter = !showFPSCounter;
-			default:
-				show_menu();
-				break;
-			}
+			logPrint("no such resolution\r\n");
+			return;
+		}
+	}
+	setResolution(res, screen);
+}
+
+static void cmd_buffering(int argc, char **argv)
+{
+	ct_screen_set_buffering(screen, screen->requested_buffers == 2 ? 3 : 2);
+	ct_screen_reset_stats(screen);
+}
+
+static void cmd_hud_mode(int argc, char **argv)
+{
+	ct_overlay_set_mode(ct_overlay_get_mode() == OVERLAY_COPY ? OVERLAY_LAYER : OVERLAY_COPY);
+}
+
+static void cmd_textures(int argc, char **argv)
+{
+	setTextures(!getTextures());
+}
+
+static void cmd_map_rays(int argc, char **argv)
+{
+	int style = (getMapRaysStyle() + 1) % MAP_RAYS_STYLES;
+
+	if(argc > 1)
+	{
+		style = atoi(argv[1]);
+		if(style < 0 || style >= MAP_RAYS_STYLES)
+		{
+			logPrint("no such style\r\n");
+			return;
 		}
 	}
+	setMapRaysStyle(style);
+}
+
+static void cmd_benchmark(int argc, char **argv)
+{
+	if(argc > 1 && strcmp(argv[1], "text") == 0)
+		textBenchRequested = true;
+	else if(argc > 1 && strcmp(argv[1], "maze") == 0)
+		mazeBenchRequested = true;
+	else
+		benchRequested = true;
+}
+
+static void cmd_profile(int argc, char **argv)
+{
+	char line[128];
+	UartStats stats;
+
+	profileReport(logPrint);
+	ct_uart_get_stats(&stats);
+	snprintf(line, sizeof(line), "uart rx: %lu dropped, %lu errors; tx: %lu bytes, %lu dropped (%lu bytes), %lu errors, peak %lu/%u\r\n",
+			(unsigned long)stats.rxDropped, (unsigned long)stats.rxErrors, (unsigned long)stats.txBytes,
+			(unsigned long)stats.txDropped, (unsigned long)stats.txDroppedBytes, (unsigned long)stats.txErrors,
+			(unsigned long)stats.txPeak, UART_TX_RING_SIZE);
+	logPrint(line);
+}
+
+static void cmd_pause(int argc, char **argv)
+{
+	pause = !pause;
+}
+
+static void cmd_telemetry(int argc, char **argv)
+{
+	telemetryOn = !telemetryOn;
 }
 
 /**
-  * @brief Sends to USART1 a string containing the various options available from the menu.
+  * @brief  Asks the simulation task for a new input, unless the console already asked for one.
+  * @return false if the previous request has not been taken yet
   */
-static void show_menu()
+static bool request_input_mode(InputMode mode)
 {
-	char menu[] = "m. Show menu\r\nn. Control player\r\nb. Show Map\r\nf. Show FPS Counter\r\np. Play / Pause\r\n";
-	HAL_UART_Transmit(&huart1, (unsigned char*)menu, strlen(menu)*sizeof(char), -1);
+	if(inputRequested)
+		return false;
+	inputRequest = mode;
+	inputRequested = true;
+	return true;
 }
 
 /**
-  * @brief  Starts an infinite loop where it listens for characters coming from USART1.
-  * @note   When it receives w, a, s or d as characters it makes a call to playerMovementKeyboard so that the player position can be changed as a consequence.
-  * @note 	When n is received the loop ends.
+  * @brief  Records and replays the commands moving the player, see game/replay.h.
+  * @note   i rec records from the start of the first map until i stop; i play replays the recording, i play demo
+  * 		the demo in flash, from the same start; i dump prints the recording in its text form, which i load
+  * 		reads back a line at a time from the following lines, up to its end line. Without arguments it
+  * 		shows the state of the recording. The recording is only changed while the input is live.
   */
-static void navigation_mode()
+static void cmd_input(int argc, char **argv)
 {
-	uint32_t byte;
-	while(1)
+	char line[80];
+	bool live = !inputRequested && inputMode == INPUT_LIVE;
+
+	if(argc < 2)
+	{
+		snprintf(line, sizeof(line), "input %s, recording of %lu events%s\r\n",
+				inputMode == INPUT_RECORDING ? "recording" : inputMode == INPUT_REPLAY ? "replaying" : "live",
+				(unsigned long)recording.count, recording.complete ? "" : ", incomplete");
+		logPrint(line);
+	}
+	else if(strcmp(argv[1], "stop") == 0)
+		request_input_mode(INPUT_LIVE);
+	else if(!live)
+		logPrint("stop the recording or the replay first\r\n");
+	else if(strcmp(argv[1], "rec") == 0)
+		request_input_mode(INPUT_RECORDING);
+	else if(strcmp(argv[1], "play") == 0)
+	{
+		if(argc > 2 && strcmp(argv[2], "demo") == 0)
+			replayParse(&recording, replayDemo);
+		if(recording.complete)
+			request_input_mode(INPUT_REPLAY);
+		else
+			logPrint("no recording to play\r\n");
+	}
+	else if(strcmp(argv[1], "dump") == 0)
+		replayWrite(&recording, logPrint);
+	else if(strcmp(argv[1], "load") == 0)
+	{
+		replayClear(&recording);
+		loadingRecording = true;
+	}
+	else
+		logPrint("usage: i [rec | stop | play [demo] | dump | load]\r\n");
+}
+
+/**
+  * @brief  Asks the simulation task to build a maze of render/maze.h and to play it.
+  * @note   z <size> [seed] [braid] builds a maze of size x size blocks from the seed, 1 if it is not given, braided
+  * 		if braid follows. The maze is only built while the input is live: the recordings start from the first map.
+  */
+static void cmd_maze(int argc, char **argv)
+{
+	int size = argc > 1 ? atoi(argv[1]) : 0;
+
+	if(size < MAZE_MIN_SIZE || size > MAZE_MAX_SIZE)
+	{
+		logPrint("no such maze size\r\n");
+		return;
+	}
+	if(inputRequested || mazeRequested || inputMode != INPUT_LIVE)
+	{
+		logPrint("stop the recording or the replay first\r\n");
+		return;
+	}
+
+	mazeSize = size;
+	mazeSeed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+	mazeStyle = argc > 3 && strcmp(argv[3], "braid") == 0 ? MAZE_BRAIDED : MAZE_PERFECT;
+	mazeRequested = true;
+}
+
+/**
+  * @brief  Shows or sets how far the rays go, see raycastSetMaxBlocks().
+  */
+static void cmd_distance(int argc, char **argv)
+{
+	if(argc > 1)
+		raycastSetMaxBlocks(atoi(argv[1]));
+	if(raycastGetMaxBlocks() > 0)
+		logPrintf("view distance %d blocks\r\n", raycastGetMaxBlocks());
+	else
+		logPrintf("view distance unlimited, up to %d blocks\r\n", RAYCAST_RANGE_BLOCKS);
+}
+
+/**
+  * @brief  Adds a line received after i load to the recording, the loading ends with the end line or a bad line.
+  * @param  console : The console holding the line
+  */
+static void load_recording_line(Console *console)
+{
+	char line[48];
+	ReplayLine result = console->overflow ? REPLAY_LINE_ERROR : replayParseLine(&recording, console->line);
+
+	if(result == REPLAY_LINE_OK)
+		return;
+
+	loadingRecording = false;
+	if(result == REPLAY_LINE_END)
+	{
+		snprintf(line, sizeof(line), "loaded %lu steps, %lu events\r\n", (unsigned long)recording.steps, (unsigned long)recording.count);
+		logPrint(line);
+	}
+	else
+	{
+		replayClear(&recording);
+		logPrint("bad recording line, loading stopped\r\n");
+	}
+}
+
+/**
+  * @brief Sends to USART1 the frame pacing counters of the screen and resets them.
+  */
+static void cmd_screen_stats(int argc, char **argv)
+{
+	char msg[160];
+	ScreenStats stats;
+	ct_screen_get_stats(screen, &stats);
+	ct_screen_reset_stats(screen);
+
+	uint32_t elapsed = xTaskGetTickCount() - stats.start;
+	uint32_t cyclesUs = SystemCoreClock / 1000000;
+	uint32_t presented = stats.presented ? stats.presented : 1;
+
+	snprintf(msg, sizeof(msg), "buffers: %lu, fps: %lu, latency avg/max: %lu/%lu us, stall avg: %lu us\r\n",
+			(unsigned long)screen->buffers,
+			(unsigned long)(elapsed ? stats.presented * 1000UL / elapsed : 0),
+			(unsigned long)(stats.latency_sum / presented / cyclesUs),
+			(unsigned long)(stats.latency_max / cyclesUs),
+			(unsigned long)(stats.stall_sum / presented / cyclesUs));
+	logPrint(msg);
+}
+
+/**
+  * @brief Runs the requested benchmark, the renderer one, the text one or the maze one, and sends its report to USART1.
+  * @note  It is called by the main task, which is the only one drawing: the benchmark takes a few seconds, then
+  * 	   the game goes on from the same map. The report is queued without waiting for the UART.
+  */
+static void run_benchmark()
+{
+	static char msg[512];
+	static BenchReport report;
+	static BenchTextReport textReport;
+	static BenchMazeReport mazeReport;
+
+	ct_overlay_show_layer(false);
+	if(benchRequested)
+	{
+		benchRun(screen, &report);
+		benchFormat(&report, msg, sizeof(msg));
+		benchRequested = false;
+	}
+	else if(mazeBenchRequested)
 	{
-		HAL_UART_Receive_IT(&huart1, (uint8_t *)&huart1.Instance->RDR, sizeof(char));
-		xTaskNotifyWait(0, 0, &byte, portMAX_DELAY);
-		if((char)byte == 'n')
-			break;
+		if(benchMazes(screen, &mazeReport))
+			benchMazesFormat(&mazeReport, msg, sizeof(msg));
 		else
-			playerMovementKeyboard(&p, &map, (char)byte);
+			snprintf(msg, sizeof(msg), "no SDRAM left for the mazes\r\n");
+		mazeBenchRequested = false;
+	}
+	else
+	{
+		benchText(screen, &textReport);
+		benchTextFormat(&textReport, msg, sizeof(msg));
+		textBenchRequested = false;
+	}
+	//the frames of the benchmark and the time it took are not frames of the game
+	frameTimeReset();
+	logWrite(msg);
+}
+
+/**
+  * @brief  Converts a number of cycles in microseconds for a 16 bit field of the telemetry
+  */
+static uint16_t telemetry_us(uint32_t cycles)
+{
+	uint32_t us = cycles / platformCyclesPerUs();
+	return us > UINT16_MAX ? UINT16_MAX : us;
+}
+
+/**
+  * @brief  Clamps a distance in pixel for a 16 bit field of the telemetry
+  */
+static uint16_t telemetry_distance(float distance)
+{
+	return distance > UINT16_MAX ? UINT16_MAX : (uint16_t)distance;
+}
+
+/**
+  * @brief Queues the telemetry packets of the frame just drawn by the main task.
+  * @note  A frame packet is sent for every frame of the game, the stage times are the last ones of the profiler
+  * 	   zones; the task packet is sent every TELEMETRY_TASKS_MS. The packets are dropped if the transmit
+  * 	   ring is full: the main task never waits for the UART.
+  * @param playing : true if the frame drawn was a frame of the game rather than a menu page
+  */
+static void send_telemetry(bool playing)
+{
+	TickType_t now = xTaskGetTickCount();
+
+	if(playing)
+	{
+		TelemetryFrame f;
+		RayStats rays;
+
+		getRayStats(&rays);
+		f.frame = frameCount;
+		f.timeMs = now * portTICK_PERIOD_MS;
+		f.frameUs = frameTimeLast();
+		f.castUs = telemetry_us(profileLast(PROFILE_CAST));
+		f.wallsUs = telemetry_us(profileLast(PROFILE_WALLS));
+		f.hudUs = telemetry_us(profileLast(PROFILE_HUD));
+		f.flipUs = telemetry_us(profileLast(PROFILE_FLIP));
+		f.x = frame.player.pos.x;
+		f.y = frame.player.pos.y;
+		f.angle = frame.player.angle;
+		f.map = frame.map.index;
+		f.rays = rays.rays;
+		f.vertical = rays.vertical;
+		f.misses = rays.misses;
+		f.minDistance = telemetry_distance(rays.minDistance);
+		f.avgDistance = telemetry_distance(rays.avgDistance);
+		f.maxDistance = telemetry_distance(rays.maxDistance);
+		ct_uart_write(telemetryPacket, telemetryEncodeFrame(&f, telemetryPacket));
 	}
+
+	if(now - tasksSent >= pdMS_TO_TICKS(TELEMETRY_TASKS_MS))
+	{
+		static TelemetryTasks t;
+		ProfileTasks *sample = &telemetryTasks;
+
+		tasksSent = now;
+		profileSampleTasks(sample);
+		t.timeMs = now * portTICK_PERIOD_MS;
+		t.count = sample->count < TELEMETRY_MAX_TASKS ? sample->count : TELEMETRY_MAX_TASKS;
+		for(int i = 0; i < t.count; i++)
+		{
+			t.task[i].number = sample->task[i].number;
+			strncpy(t.task[i].name, sample->task[i].name, TELEMETRY_TASK_NAME);
+			t.task[i].name[TELEMETRY_TASK_NAME] = '\0';
+			t.task[i].cpuPermille = sample->totalRunTime ? (uint64_t)sample->task[i].runTime * 1000 / sample->totalRunTime : 0;
+			t.task[i].stackFree = sample->task[i].stackFree;
+		}
+		ct_uart_write(telemetryPacket, telemetryEncodeTasks(&t, telemetryPacket));
+	}
+}
+
+/**
+  * @brief Draws the map overlay: the blocks of the current map.
+  */
+static void draw_map_overlay()
+{
+	drawMap(&frame.map, screen);
+}
+
+/**
+  * @brief Draws the controls overlay: the on screen buttons used to move the player.
+  */
+static void draw_controls_overlay()
+{
+	drawControls(screen, 2);
+}
+
+/**
+  * @brief Draws the fps overlay: the text prepared by update_fps_overlay().
+  */
+static void draw_fps_overlay()
+{
+	platformSetTextColor(COLOR_BLACK);
+	platformSetBackColor(COLOR_ORANGE);
+	platformDrawString(0, 0, fps, PLATFORM_ALIGN_RIGHT);
+}
+
+/**
+  * @brief Prepares the text of the fps overlay and resizes the overlay to fit it, the overlay is drawn again
+  * at the next composition. It is called every FPS_REFRESH_MS, the overlay is left alone if the text is the same.
+  * @note  The text shows the average fps, the 1% low fps and the longest frame time of the last FRAMETIME_SAMPLES frames.
+  */
+static void update_fps_overlay()
+{
+	Rect rect;
+	FrameTimeStats stats;
+	char text[sizeof(fps)];
+
+	fpsUpdated = xTaskGetTickCount();
+	frameTimeGetStats(&stats);
+	snprintf(text, sizeof(text), "%lu FPS 1%% %lu max %lu.%lu ms", (unsigned long)stats.avgFps, (unsigned long)stats.lowFps,
+			(unsigned long)(stats.maxUs / 1000), (unsigned long)(stats.maxUs % 1000 / 100));
+	if(strcmp(text, fps) == 0)
+		return;
+	strcpy(fps, text);
+
+	rect.width = strlen(fps) * BSP_LCD_GetFont()->Width;
+	rect.height = BSP_LCD_GetFont()->Height;
+	rect.x = screen->width - rect.width;
+	rect.y = 0;
+	ct_overlay_set_rects(fpsOverlay, &rect, 1);
 }
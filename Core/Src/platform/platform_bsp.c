@@ -0,0 +1,180 @@
+/*
+ * platform_bsp.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "platform/platform.h"
+#include "render/blit.h"
+#include "render/text.h"
+#include "stm32f769i_discovery_lcd.h"
+#include "stm32f769i_discovery_ts.h"
+
+//the BSP draws into the frame buffer of layer 0, which screen.c and overlay.c point to the buffer being drawn
+extern LTDC_HandleTypeDef hltdc_discovery;
+
+/**
+  * @param  color : The ARGB8888 color of the following lines, rectangles and text
+  */
+void platformSetTextColor(uint32_t color)
+{
+	BSP_LCD_SetTextColor(color);
+}
+
+/**
+  * @param  color : The ARGB8888 color of the background of the following text
+  */
+void platformSetBackColor(uint32_t color)
+{
+	BSP_LCD_SetBackColor(color);
+}
+
+/**
+  * @brief  Fills the whole back buffer with a color
+  * @param  color : The ARGB8888 color
+  */
+void platformClear(uint32_t color)
+{
+	BSP_LCD_Clear(color);
+}
+
+/**
+  * @brief  Fills a rectangle with the text color
+  * @param  x : The x coordinate of the top left corner
+  * @param  y : The y coordinate of the top left corner
+  * @param  width : The width of the rectangle
+  * @param  height : The height of the rectangle
+  */
+void platformFillRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	BSP_LCD_FillRect(x, y, width, height);
+}
+
+/**
+  * @brief  Draws the outline of a rectangle with the text color, it spans width+1 x height+1 pixels
+  * @param  x : The x coordinate of the top left corner
+  * @param  y : The y coordinate of the top left corner
+  * @param  width : The width of the rectangle
+  * @param  height : The height of the rectangle
+  */
+void platformDrawRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	BSP_LCD_DrawRect(x, y, width, height);
+}
+
+/**
+  * @brief  Draws a line with the text color, both ends included
+  * @param  x1 : The x coordinate of the first end
+  * @param  y1 : The y coordinate of the first end
+  * @param  x2 : The x coordinate of the second end
+  * @param  y2 : The y coordinate of the second end
+  */
+void platformDrawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+	BSP_LCD_DrawLine(x1, y1, x2, y2);
+}
+
+/**
+  * @param  x : The x coordinate of the pixel
+  * @param  y : The y coordinate of the pixel
+  * @param  color : The ARGB8888 color of the pixel
+  */
+void platformDrawPixel(uint16_t x, uint16_t y, uint32_t color)
+{
+	BSP_LCD_DrawPixel(x, y, color);
+}
+
+/**
+  * @brief  Draws a string with the text color on the back color, with the font of the BSP
+  * @note   The glyphs are blended by the DMA2D from the glyph cache of text.c, the string is complete once
+  * 		platformWaitDrawing() returns. With COLOR_TRANSPARENT as back color only the glyphs are drawn.
+  * @param  x : The x coordinate, its meaning depends on the alignment
+  * @param  y : The y coordinate of the top of the string
+  * @param  text : The string
+  * @param  align : The alignment of the string
+  */
+void platformDrawString(uint16_t x, uint16_t y, const char *text, PlatformAlign align)
+{
+	TextTarget t = {
+		.buffer = platformDrawBuffer(), .width = BSP_LCD_GetXSize(), .height = BSP_LCD_GetYSize(),
+		.font = BSP_LCD_GetFont(), .color = BSP_LCD_GetTextColor(), .backColor = BSP_LCD_GetBackColor()
+	};
+	textDrawString(&t, x, y, text, align);
+}
+
+/**
+  * @brief  Draws a string with the text color on the back color with BSP_LCD_DisplayStringAt(), a CPU write
+  * 		per pixel of the cells of the string
+  * @param  x : The x coordinate, its meaning depends on the alignment
+  * @param  y : The y coordinate of the top of the string
+  * @param  text : The string
+  * @param  align : The alignment of the string
+  */
+void platformDrawStringPerPixel(uint16_t x, uint16_t y, const char *text, PlatformAlign align)
+{
+	static const Text_AlignModeTypdef modes[] = { CENTER_MODE, RIGHT_MODE, LEFT_MODE };
+	BSP_LCD_DisplayStringAt(x, y, (uint8_t*)text, modes[align]);
+}
+
+/**
+  * @param  touch : Where the state of the touch panel is written
+  */
+void platformGetTouch(PlatformTouch *touch)
+{
+	TS_StateTypeDef state;
+	BSP_TS_GetState(&state);
+
+	touch->stamp = platformCycles();
+	touch->count = state.touchDetected > 2 ? 2 : state.touchDetected;
+	for(int i = 0; i < 2; i++)
+	{
+		touch->x[i] = state.touchX[i];
+		touch->y[i] = state.touchY[i];
+	}
+}
+
+/**
+  * @return the frame buffer the functions above draw into: the back buffer, or the HUD cache of overlay.c
+  * 		while an overlay is drawn
+  */
+pixel_t* platformDrawBuffer(void)
+{
+	return (pixel_t*)hltdc_discovery.LayerCfg[0].FBStartAdress;
+}
+
+/**
+  * @brief  Makes the pixels written by the CPU visible to the DMA2D and the LTDC
+  * @note   The frame buffers are in the SDRAM behind the D-cache: the lines written by the CPU must reach the
+  * 		SDRAM before the DMA2D touches the same frame buffer or the frame is displayed.
+  */
+void platformFlushPixels(void)
+{
+	SCB_CleanDCache();
+}
+
+/**
+  * @brief  Waits until the drawing submitted so far has reached the back buffer: the fills of the BSP are
+  * 		DMA2D jobs that run while the CPU goes on
+  */
+void platformWaitDrawing(void)
+{
+	ct_blit_wait(ct_blit_fence());
+}
+
+/**
+  * @note   The DWT cycle counter is enabled by ct_screen_init().
+  * @return the current value of the DWT cycle counter
+  */
+uint32_t platformCycles(void)
+{
+	return DWT->CYCCNT;
+}
+
+/**
+  * @return the number of cycles counted by platformCycles() in a microsecond
+  */
+uint32_t platformCyclesPerUs(void)
+{
+	return SystemCoreClock / 1000000;
+}
@@ -0,0 +1,129 @@
+/*
+ * frametime.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "profile/frametime.h"
+#include "platform/platform.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+//frame times in microseconds, next is the slot of the next one
+static uint32_t samples[FRAMETIME_SAMPLES];
+static uint32_t next;
+static uint32_t count;
+static uint64_t sum;
+//cycle counter at the previous frameTimeMark(), started tells whether there has been one
+static uint32_t last;
+static bool started;
+//copy of the ring sorted by frameTimeGetStats()
+static uint32_t sorted[FRAMETIME_SAMPLES];
+
+/**
+  * @brief  Stores the time elapsed since the previous call as the time of a frame
+  */
+void frameTimeMark(void)
+{
+	uint32_t now = platformCycles();
+
+	if(started)
+	{
+		uint32_t us = (now - last) / platformCyclesPerUs();
+		if(count == FRAMETIME_SAMPLES)
+			sum -= samples[next];
+		else
+			count++;
+		samples[next] = us;
+		sum += us;
+		next = (next + 1) % FRAMETIME_SAMPLES;
+	}
+
+	last = now;
+	started = true;
+}
+
+/**
+  * @return the time of the last frame in microseconds, 0 if there is none
+  */
+uint32_t frameTimeLast(void)
+{
+	return count ? samples[(next + FRAMETIME_SAMPLES - 1) % FRAMETIME_SAMPLES] : 0;
+}
+
+/**
+  * @brief  Empties the ring, e.g. after the frames have been stopped for a while: the next frameTimeMark()
+  * 		starts measuring again
+  */
+void frameTimeReset(void)
+{
+	next = 0;
+	count = 0;
+	sum = 0;
+	started = false;
+}
+
+/**
+  * @brief  qsort() comparison of two frame times, the longest first
+  */
+static int compareDescending(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return x > y ? -1 : x < y;
+}
+
+/**
+  * @brief  Computes the statistics of the frames in the ring
+  * @param  stats : Where the statistics are written, all 0 if there are no frames yet
+  */
+void frameTimeGetStats(FrameTimeStats *stats)
+{
+	stats->frames = count;
+	stats->avgFps = 0;
+	stats->lowFps = 0;
+	stats->maxUs = 0;
+	if(count == 0)
+		return;
+
+	for(uint32_t i = 0; i < count; i++)
+		sorted[i] = samples[i];
+	qsort(sorted, count, sizeof(uint32_t), compareDescending);
+
+	//the slowest 1% of the frames, at least one
+	uint32_t slow = (count + 99) / 100;
+	uint64_t slowSum = 0;
+	for(uint32_t i = 0; i < slow; i++)
+		slowSum += sorted[i];
+
+	stats->avgFps = sum ? (uint32_t)(1000000ULL * count / sum) : 0;
+	stats->lowFps = slowSum ? (uint32_t)(1000000ULL * slow / slowSum) : 0;
+	stats->maxUs = sorted[0];
+}
+
+/**
+  * @brief  Draws the frame times of the ring as bars, the oldest on the left: green within a 60 fps frame,
+  * 		orange within a 30 fps frame and red above, the bars taller than the graph are cut
+  * @param  x : The x coordinate of the top left corner of the graph
+  * @param  y : The y coordinate of the top left corner of the graph
+  */
+void frameTimeDrawGraph(uint16_t x, uint16_t y)
+{
+	const uint16_t bottom = y + FRAMETIME_GRAPH_HEIGHT - 1;
+
+	platformSetTextColor(COLOR_BLACK);
+	platformFillRect(x, y, FRAMETIME_GRAPH_WIDTH, FRAMETIME_GRAPH_HEIGHT);
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		uint32_t us = samples[(next + FRAMETIME_SAMPLES - count + i) % FRAMETIME_SAMPLES];
+		uint32_t height = us / FRAMETIME_GRAPH_US;
+		if(height == 0)
+			continue;
+		if(height > FRAMETIME_GRAPH_HEIGHT)
+			height = FRAMETIME_GRAPH_HEIGHT;
+
+		platformSetTextColor(us <= 1000000 / 60 ? COLOR_GREEN : us <= 1000000 / 30 ? COLOR_ORANGE : COLOR_DARKRED);
+		platformDrawLine(x + FRAMETIME_GRAPH_WIDTH - count + i, bottom - height + 1, x + FRAMETIME_GRAPH_WIDTH - count + i, bottom);
+	}
+}
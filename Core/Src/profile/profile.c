@@ -0,0 +1,249 @@
+/*
+ * profile.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "profile/profile.h"
+#include "platform/platform.h"
+#include "platform/seqlock.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+	uint32_t count;
+	uint64_t sum;
+	uint32_t max; //maximum time since the report number epoch
+	uint32_t epoch;
+	uint32_t histogram[PROFILE_BUCKETS];
+} ZoneStats;
+
+typedef struct {
+	volatile uint32_t seq; //odd while the writer updates stats
+	ZoneStats stats;
+	volatile uint32_t last; //the last time, it is a single word: it can be read without the sequence number
+} Zone;
+
+static Zone zones[PROFILE_ZONES];
+//number of reports printed so far, the maximum of a zone restarts from 0 when it changes
+static volatile uint32_t reportEpoch;
+//statistics and run times of the previous report, the next one prints the difference
+static ZoneStats previousZones[PROFILE_ZONES];
+static ProfileTasks reportTasks;
+//state of the run time counter: last value of the cycle counter and number of times it wrapped around
+static uint32_t runTimeLast;
+static uint32_t runTimeHigh;
+static char line[200];
+
+static const char *zoneNames[PROFILE_ZONES] = { "frame", "input", "cast", "wait", "walls", "hud", "logic", "touch", "menu", "flip" };
+
+/**
+  * @return the current value of the cycle counter, to be passed to profileEnd()
+  */
+uint32_t profileBegin(void)
+{
+	return platformCycles();
+}
+
+/**
+  * @brief  Adds the time elapsed since profileBegin() to the statistics of a zone
+  * @param  zone : The zone
+  * @param  start : The value returned by profileBegin()
+  */
+void profileEnd(ProfileZone zone, uint32_t start)
+{
+	uint32_t cycles = platformCycles() - start;
+	uint32_t bucket = cycles >> PROFILE_BUCKET_SHIFT;
+	Zone *z = &zones[zone];
+
+	bucket = bucket ? 32 - __builtin_clz(bucket) : 0;
+	if(bucket >= PROFILE_BUCKETS)
+		bucket = PROFILE_BUCKETS - 1;
+
+	seqlockWriteBegin(&z->seq);
+	if(z->stats.epoch != reportEpoch)
+	{
+		z->stats.epoch = reportEpoch;
+		z->stats.max = 0;
+	}
+	z->stats.count++;
+	z->stats.sum += cycles;
+	if(cycles > z->stats.max)
+		z->stats.max = cycles;
+	z->stats.histogram[bucket]++;
+	seqlockWriteEnd(&z->seq);
+	z->last = cycles;
+}
+
+/**
+  * @param  zone : The zone
+  * @return the time of the last run of a zone in cycles, 0 if it never ran
+  */
+uint32_t profileLast(ProfileZone zone)
+{
+	return zones[zone].last;
+}
+
+/**
+  * @brief  Copies the statistics of a zone while its writer may be updating them
+  * @param  z : The zone
+  * @param  stats : Where the statistics are copied
+  */
+static void readZone(Zone *z, ZoneStats *stats)
+{
+	uint32_t seq;
+
+	do
+	{
+		seq = seqlockReadBegin(&z->seq);
+		*stats = z->stats;
+	} while(seqlockReadRetry(&z->seq, seq));
+
+	//the writer has not run since the previous report: its maximum is an old one
+	if(stats->epoch != reportEpoch)
+		stats->max = 0;
+}
+
+/**
+  * @brief  Writes a time in microseconds with one decimal digit
+  */
+static int formatUs(char *text, size_t size, uint64_t cycles)
+{
+	uint64_t tenths = cycles * 10 / platformCyclesPerUs();
+	return snprintf(text, size, "%lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+}
+
+/**
+  * @brief  Prints a line with the statistics of a zone since the previous report
+  * @param  print : The function printing the line
+  * @param  name : The name of the zone
+  * @param  now : The current statistics of the zone
+  * @param  before : The statistics of the previous report
+  */
+static void reportZone(void (*print)(const char *line), const char *name, const ZoneStats *now, const ZoneStats *before)
+{
+	uint32_t count = now->count - before->count;
+	uint32_t histogram[PROFILE_BUCKETS];
+	int first = PROFILE_BUCKETS, last = -1;
+	int length;
+
+	for(int i = 0; i < PROFILE_BUCKETS; i++)
+	{
+		histogram[i] = now->histogram[i] - before->histogram[i];
+		if(histogram[i] != 0)
+		{
+			first = i < first ? i : first;
+			last = i;
+		}
+	}
+
+	length = snprintf(line, sizeof(line), "%-6s %6lu  avg ", name, (unsigned long)count);
+	length += formatUs(line + length, sizeof(line) - length, count ? (now->sum - before->sum) / count : 0);
+	length += snprintf(line + length, sizeof(line) - length, " max ");
+	length += formatUs(line + length, sizeof(line) - length, now->max);
+	length += snprintf(line + length, sizeof(line) - length, " us |");
+
+	//the histogram from the first to the last bucket with some time in it, each with its upper bound
+	for(int i = first; i <= last && length < (int)sizeof(line) - 24; i++)
+	{
+		if(i == PROFILE_BUCKETS - 1)
+			length += snprintf(line + length, sizeof(line) - length, " more:%lu", (unsigned long)histogram[i]);
+		else
+			length += snprintf(line + length, sizeof(line) - length, " <%lu:%lu",
+					(unsigned long)((1u << (PROFILE_BUCKET_SHIFT + i)) / platformCyclesPerUs()), (unsigned long)histogram[i]);
+	}
+	snprintf(line + length, sizeof(line) - length, "\r\n");
+	print(line);
+}
+
+/**
+  * @brief  Prints the statistics of the zones and of the tasks since the previous report
+  * @note   Zones print the number of times they ran, the average and maximum time and a histogram of the times,
+  * 		each bucket as <bound in us:count. Tasks print their share of CPU time and the minimum free stack.
+  * @param  print : The function printing a line, e.g. on the serial console
+  */
+void profileReport(void (*print)(const char *line))
+{
+	ZoneStats now;
+	ProfileTasks *t = &reportTasks;
+
+	print("zone    count  times\r\n");
+	for(int i = 0; i < PROFILE_ZONES; i++)
+	{
+		readZone(&zones[i], &now);
+		reportZone(print, zoneNames[i], &now, &previousZones[i]);
+		previousZones[i] = now;
+	}
+	reportEpoch++;
+
+	profileSampleTasks(t);
+
+	print("task             cpu %  free stack (words)\r\n");
+	for(UBaseType_t i = 0; i < t->count; i++)
+	{
+		uint32_t tenths = t->totalRunTime ? (uint64_t)t->task[i].runTime * 1000 / t->totalRunTime : 0;
+		snprintf(line, sizeof(line), "%-16s %3lu.%lu  %lu\r\n", t->task[i].name,
+				(unsigned long)(tenths / 10), (unsigned long)(tenths % 10), (unsigned long)t->task[i].stackFree);
+		print(line);
+	}
+}
+
+/**
+  * @brief  Takes the run time since the previous sample and the minimum free stack of every task
+  * @note   Every consumer has its own ProfileTasks, the first sample of each one counts the run time since boot.
+  * @param  t : The tasks of the previous sample, replaced by the new ones
+  */
+void profileSampleTasks(ProfileTasks *t)
+{
+	uint32_t totalRunTime;
+
+	t->count = uxTaskGetSystemState(t->status, PROFILE_MAX_TASKS, &totalRunTime);
+	t->totalRunTime = 0;
+
+	//the run time of a task is compared with the one of the previous sample of the same task
+	for(UBaseType_t i = 0; i < t->count; i++)
+	{
+		ProfileTask *task = &t->task[i];
+		task->name = t->status[i].pcTaskName;
+		task->number = t->status[i].xTaskNumber;
+		task->runTime = t->status[i].ulRunTimeCounter;
+		task->stackFree = t->status[i].usStackHighWaterMark;
+		for(UBaseType_t j = 0; j < t->previousCount; j++)
+			if(t->previousNumbers[j] == task->number)
+				task->runTime -= t->previousRunTimes[j];
+		t->totalRunTime += task->runTime;
+	}
+
+	for(UBaseType_t i = 0; i < t->count; i++)
+	{
+		t->previousNumbers[i] = t->status[i].xTaskNumber;
+		t->previousRunTimes[i] = t->status[i].ulRunTimeCounter;
+	}
+	t->previousCount = t->count;
+}
+
+/**
+  * @brief  Starts the run time counter, called by the kernel before the scheduler starts
+  * @note   The DWT cycle counter has already been enabled by ct_screen_init().
+  */
+void profileInitRunTime(void)
+{
+	runTimeLast = platformCycles();
+	runTimeHigh = 0;
+}
+
+/**
+  * @brief  Run time counter of the kernel: the cycle counter extended to 64 bit and divided by 2^PROFILE_RUN_TIME_SHIFT
+  * @note   It is called by the kernel at every context switch, which happens well within the 20 seconds the
+  * 		cycle counter takes to wrap around, so every wrap is seen.
+  * @return the current value of the counter
+  */
+uint32_t profileRunTime(void)
+{
+	uint32_t now = platformCycles();
+	if(now < runTimeLast)
+		runTimeHigh++;
+	runTimeLast = now;
+	return (runTimeHigh << (32 - PROFILE_RUN_TIME_SHIFT)) | (now >> PROFILE_RUN_TIME_SHIFT);
+}
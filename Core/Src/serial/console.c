@@ -0,0 +1,107 @@
+/*
+ * console.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "serial/console.h"
+#include <string.h>
+
+/**
+  * @brief  Empties the line of a console
+  * @param  c : The console
+  */
+void consoleInit(Console *c)
+{
+	c->line[0] = '\0';
+	c->length = 0;
+	c->overflow = false;
+	c->lastCR = false;
+	c->ended = false;
+}
+
+/**
+  * @brief  Adds a received character to the line of a console
+  * @note   When it returns true the line is in c->line, terminated, until the next call. A line too long is
+  * 		returned anyway with c->overflow set, so the caller can reject it.
+  * @param  c : The console
+  * @param  ch : The character
+  * @return true if ch ended a line
+  */
+bool consoleFeed(Console *c, char ch)
+{
+	bool crlf = c->lastCR && ch == '\n';
+
+	//the previous line has been handed to the caller: this character starts a new one
+	if(c->ended)
+	{
+		c->ended = false;
+		c->overflow = false;
+	}
+
+	c->lastCR = ch == '\r';
+	if(crlf)
+		return false;
+
+	if(ch == '\r' || ch == '\n')
+	{
+		c->line[c->length] = '\0';
+		c->length = 0;
+		c->ended = true;
+		return true;
+	}
+
+	if(ch == '\b' || ch == 0x7f)
+	{
+		if(c->length > 0)
+			c->length--;
+	}
+	else if(c->length < CONSOLE_LINE_SIZE - 1)
+		c->line[c->length++] = ch;
+	else
+		c->overflow = true;
+
+	return false;
+}
+
+/**
+  * @brief  Splits a line in words separated by spaces or tabs, the line is modified
+  * @param  line : The line
+  * @param  argv : Where the words are written
+  * @param  max : The size of argv, the words past it are ignored
+  * @return the number of words
+  */
+int consoleSplit(char *line, char **argv, int max)
+{
+	int argc = 0;
+
+	while(argc < max)
+	{
+		line += strspn(line, " \t");
+		if(*line == '\0')
+			break;
+		argv[argc++] = line;
+		line += strcspn(line, " \t");
+		if(*line != '\0')
+			*line++ = '\0';
+	}
+
+	return argc;
+}
+
+/**
+  * @brief  Looks up a command by name
+  * @param  commands : The table of the commands
+  * @param  count : The number of commands in the table
+  * @param  name : The name, the first word of a line
+  * @return the command, NULL if there is no command with that name
+  */
+const ConsoleCommand* consoleFind(const ConsoleCommand *commands, int count, const char *name)
+{
+	for(int i = 0; i < count; i++)
+		if(strcmp(commands[i].name, name) == 0)
+			return &commands[i];
+
+	return NULL;
+}
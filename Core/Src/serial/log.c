@@ -0,0 +1,62 @@
+/*
+ * log.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "serial/log.h"
+#include "serial/uart.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+//period of the checks of the free space of the transmit ring while logPrint() waits
+#define LOG_WAIT_MS 10
+
+/**
+  * @brief  Formats a message as printf() and queues it, it never waits
+  * @param  format : The format, as printf()
+  * @return true if the message has been queued, false if it has been dropped
+  */
+bool logPrintf(const char *format, ...)
+{
+	char line[LOG_LINE_SIZE];
+	va_list args;
+	int length;
+
+	va_start(args, format);
+	length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+
+	if(length < 0)
+		return false;
+	if(length >= (int)sizeof(line))
+		length = sizeof(line) - 1;
+	return ct_uart_write(line, length);
+}
+
+/**
+  * @brief  Queues a text, it never waits
+  * @param  text : The text, terminated
+  * @return true if the text has been queued, false if it has been dropped
+  */
+bool logWrite(const char *text)
+{
+	return ct_uart_write(text, strlen(text));
+}
+
+/**
+  * @brief  Queues a text, waiting for enough free space in the transmit ring if needed
+  * @note   It blocks the caller until the text is queued, the render task must use logWrite() instead.
+  * 		A text longer than the whole ring is dropped.
+  * @param  text : The text, terminated
+  */
+void logPrint(const char *text)
+{
+	uint32_t length = strlen(text);
+
+	while(length <= UART_TX_RING_SIZE && ct_uart_tx_free() < length)
+		vTaskDelay(pdMS_TO_TICKS(LOG_WAIT_MS));
+	ct_uart_write(text, length);
+}
@@ -0,0 +1,308 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "serial/telemetry.h"
+#include <string.h>
+
+//payload of a TELEMETRY_FRAME packet, CRC included
+#define FRAME_PAYLOAD 49
+
+/**
+  * @brief  Computes the CRC-16/CCITT-FALSE of a buffer: polynomial 0x1021, initial value 0xffff
+  * @note   Bit by bit: a frame packet costs about 400 iterations, a table would cost 512 bytes of flash.
+  */
+static uint16_t crc16(const uint8_t *data, size_t length)
+{
+	uint16_t crc = 0xffff;
+
+	while(length--)
+	{
+		crc ^= (uint16_t)*data++ << 8;
+		for(int i = 0; i < 8; i++)
+			crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+
+	return crc;
+}
+
+static uint8_t* put8(uint8_t *p, uint8_t v)
+{
+	*p++ = v;
+	return p;
+}
+
+static uint8_t* put16(uint8_t *p, uint16_t v)
+{
+	*p++ = v;
+	*p++ = v >> 8;
+	return p;
+}
+
+static uint8_t* put32(uint8_t *p, uint32_t v)
+{
+	p = put16(p, v);
+	return put16(p, v >> 16);
+}
+
+static uint8_t* putFloat(uint8_t *p, float v)
+{
+	uint32_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	return put32(p, bits);
+}
+
+static const uint8_t* get16(const uint8_t *p, uint16_t *v)
+{
+	*v = p[0] | p[1] << 8;
+	return p + 2;
+}
+
+static const uint8_t* get32(const uint8_t *p, uint32_t *v)
+{
+	*v = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+	return p + 4;
+}
+
+static const uint8_t* getFloat(const uint8_t *p, float *v)
+{
+	uint32_t bits;
+	p = get32(p, &bits);
+	memcpy(v, &bits, sizeof(bits));
+	return p;
+}
+
+/**
+  * @brief  Appends the CRC to a payload and writes it COBS encoded between two delimiters
+  * @param  payload : The payload, with 2 free bytes at its end for the CRC
+  * @param  length : The length of the payload without the CRC
+  * @param  out : Where the packet is written
+  * @return the length of the packet
+  */
+static size_t frame(uint8_t *payload, size_t length, uint8_t *out)
+{
+	uint8_t *code, *p = out;
+	uint16_t crc = crc16(payload, length);
+
+	put16(payload + length, crc);
+	length += 2;
+
+	*p++ = 0;
+	//every block of non zero bytes is preceded by its length plus one, a block of 254 bytes has no zero after it
+	code = p++;
+	for(size_t i = 0; i < length; i++)
+	{
+		if(payload[i] != 0)
+			*p++ = payload[i];
+		if(payload[i] == 0 || p - code == 255)
+		{
+			*code = p - code;
+			code = p++;
+		}
+	}
+	*code = p - code;
+	*p++ = 0;
+
+	return p - out;
+}
+
+/**
+  * @brief  Encodes a TELEMETRY_FRAME packet
+  * @param  f : The fields of the packet
+  * @param  out : Where the packet is written, at least TELEMETRY_MAX_ENCODED bytes
+  * @return the length of the packet
+  */
+size_t telemetryEncodeFrame(const TelemetryFrame *f, uint8_t *out)
+{
+	uint8_t payload[FRAME_PAYLOAD];
+	uint8_t *p = payload;
+
+	p = put8(p, TELEMETRY_FRAME);
+	p = put8(p, TELEMETRY_VERSION);
+	p = put32(p, f->frame);
+	p = put32(p, f->timeMs);
+	p = put32(p, f->frameUs);
+	p = put16(p, f->castUs);
+	p = put16(p, f->wallsUs);
+	p = put16(p, f->hudUs);
+	p = put16(p, f->flipUs);
+	p = putFloat(p, f->x);
+	p = putFloat(p, f->y);
+	p = putFloat(p, f->angle);
+	p = put8(p, f->map);
+	p = put16(p, f->rays);
+	p = put16(p, f->vertical);
+	p = put16(p, f->misses);
+	p = put16(p, f->minDistance);
+	p = put16(p, f->avgDistance);
+	p = put16(p, f->maxDistance);
+
+	return frame(payload, p - payload, out);
+}
+
+/**
+  * @brief  Encodes a TELEMETRY_TASKS packet
+  * @param  t : The fields of the packet, only the first TELEMETRY_MAX_TASKS tasks are encoded
+  * @param  out : Where the packet is written, at least TELEMETRY_MAX_ENCODED bytes
+  * @return the length of the packet
+  */
+size_t telemetryEncodeTasks(const TelemetryTasks *t, uint8_t *out)
+{
+	uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+	uint8_t *p = payload;
+	uint8_t count = t->count < TELEMETRY_MAX_TASKS ? t->count : TELEMETRY_MAX_TASKS;
+
+	p = put8(p, TELEMETRY_TASKS);
+	p = put8(p, TELEMETRY_VERSION);
+	p = put32(p, t->timeMs);
+	p = put8(p, count);
+	for(int i = 0; i < count; i++)
+	{
+		p = put8(p, t->task[i].number);
+		strncpy((char*)p, t->task[i].name, TELEMETRY_TASK_NAME);
+		p += TELEMETRY_TASK_NAME;
+		p = put16(p, t->task[i].cpuPermille);
+		p = put16(p, t->task[i].stackFree);
+	}
+
+	return frame(payload, p - payload, out);
+}
+
+/**
+  * @brief  Prepares a decoder for the start of a stream
+  * @param  d : The decoder
+  */
+void telemetryDecoderInit(TelemetryDecoder *d)
+{
+	memset(d, 0, sizeof(*d));
+}
+
+/**
+  * @brief  Decodes COBS in place
+  * @param  data : The encoded bytes, without delimiters, replaced by the decoded ones
+  * @param  length : The number of encoded bytes
+  * @return the number of decoded bytes, 0 if the encoding is broken
+  */
+static size_t unstuff(uint8_t *data, size_t length)
+{
+	size_t in = 0, out = 0;
+
+	while(in < length)
+	{
+		uint8_t code = data[in++];
+		if(code == 0 || in + code - 1 > length)
+			return 0;
+		for(int i = 1; i < code; i++)
+			data[out++] = data[in++];
+		//a block shorter than 254 bytes was followed by a zero, except the last one
+		if(code < 255 && in < length)
+			data[out++] = 0;
+	}
+
+	return out;
+}
+
+/**
+  * @brief  Parses the payload of a packet whose CRC has already been checked
+  * @return false if the payload is not a packet of this version
+  */
+static bool parse(const uint8_t *p, size_t length, TelemetryPacket *packet)
+{
+	const uint8_t *end = p + length;
+
+	if(length < 2 || p[1] != TELEMETRY_VERSION)
+		return false;
+
+	packet->type = p[0];
+	p += 2;
+	if(packet->type == TELEMETRY_FRAME && length == FRAME_PAYLOAD - 2)
+	{
+		TelemetryFrame *f = &packet->frame;
+		p = get32(p, &f->frame);
+		p = get32(p, &f->timeMs);
+		p = get32(p, &f->frameUs);
+		p = get16(p, &f->castUs);
+		p = get16(p, &f->wallsUs);
+		p = get16(p, &f->hudUs);
+		p = get16(p, &f->flipUs);
+		p = getFloat(p, &f->x);
+		p = getFloat(p, &f->y);
+		p = getFloat(p, &f->angle);
+		f->map = *p++;
+		p = get16(p, &f->rays);
+		p = get16(p, &f->vertical);
+		p = get16(p, &f->misses);
+		p = get16(p, &f->minDistance);
+		p = get16(p, &f->avgDistance);
+		p = get16(p, &f->maxDistance);
+		return true;
+	}
+
+	if(packet->type == TELEMETRY_TASKS && length >= 7)
+	{
+		TelemetryTasks *t = &packet->tasks;
+		p = get32(p, &t->timeMs);
+		t->count = *p++;
+		if(t->count > TELEMETRY_MAX_TASKS || end - p != t->count * (5 + TELEMETRY_TASK_NAME))
+			return false;
+		for(int i = 0; i < t->count; i++)
+		{
+			t->task[i].number = *p++;
+			memcpy(t->task[i].name, p, TELEMETRY_TASK_NAME);
+			t->task[i].name[TELEMETRY_TASK_NAME] = '\0';
+			p += TELEMETRY_TASK_NAME;
+			p = get16(p, &t->task[i].cpuPermille);
+			p = get16(p, &t->task[i].stackFree);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/**
+  * @brief  Feeds a byte of the stream to a decoder
+  * @note   Anything between two delimiters that is not a valid packet is counted and skipped.
+  * @param  d : The decoder
+  * @param  byte : The next byte of the stream
+  * @param  packet : Where a decoded packet is written
+  * @return true if the byte completed a valid packet
+  */
+bool telemetryDecode(TelemetryDecoder *d, uint8_t byte, TelemetryPacket *packet)
+{
+	size_t length;
+	bool valid = false;
+
+	if(byte != 0)
+	{
+		if(d->length < sizeof(d->buffer))
+			d->buffer[d->length++] = byte;
+		else
+			d->overflow = true;
+		return false;
+	}
+
+	//two delimiters in a row are the end of a packet and the start of the next one
+	if(d->length == 0)
+		return false;
+
+	length = d->overflow ? 0 : unstuff(d->buffer, d->length);
+	if(length < 4)
+		d->malformed++;
+	else if(crc16(d->buffer, length - 2) != (d->buffer[length - 2] | d->buffer[length - 1] << 8))
+		d->crcErrors++;
+	else if(!parse(d->buffer, length - 2, packet))
+		d->malformed++;
+	else
+	{
+		d->packets++;
+		valid = true;
+	}
+
+	d->length = 0;
+	d->overflow = false;
+	return valid;
+}
@@ -0,0 +1,342 @@
+/*
+ * uart.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "serial/uart.h"
+#include "platform/seqlock.h"
+#include <string.h>
+
+//positions in the transmit ring count the bytes modulo 2^16, they fit in half of txState
+#define TX_POSITION(n) ((n) & 0xffff)
+#define TX_DISTANCE(to, from) TX_POSITION((to) - (from))
+//a writer in the high half of txState
+#define TX_WRITER (1u << 16)
+
+static UART_HandleTypeDef *uart;
+static DMA_HandleTypeDef dmaRx;
+static DMA_HandleTypeDef dmaTx;
+static UartStats stats;
+//written by the DMA only, the CPU invalidates it before reading
+static uint8_t dmaBuffer[UART_RX_DMA_SIZE] __attribute__((aligned(32)));
+//position in dmaBuffer of the first byte not yet moved in the ring
+static uint32_t dmaRead;
+
+//bytes received and not yet read: the byte number n is stored in ring[n % UART_RX_RING_SIZE]
+static uint8_t ring[UART_RX_RING_SIZE];
+static volatile uint32_t head; //written by the interrupt only
+static volatile uint32_t tail; //written by the reading task only
+static volatile TaskHandle_t reader;
+
+//bytes waiting to be sent, read by the DMA: the CPU cleans the lines of a transfer before starting it
+static uint8_t txRing[UART_TX_RING_SIZE] __attribute__((aligned(32)));
+//position where the next message will be written in the low half, number of writers copying a message in the high half
+static volatile uint32_t txState;
+//position of the end of the last message completely copied: the DMA can send everything before it
+static volatile uint32_t txCommit;
+//position of the first byte not yet sent and number of bytes of the transfer in progress
+static volatile uint32_t txTail;
+static volatile uint32_t txLength;
+//a transfer is in progress or about to be started, it is owned by whoever set it
+static volatile bool txBusy;
+
+/**
+  * @brief  Starts the circular reception from the beginning of the DMA buffer
+  */
+static void startReception(void)
+{
+	dmaRead = 0;
+	HAL_UARTEx_ReceiveToIdle_DMA(uart, dmaBuffer, UART_RX_DMA_SIZE);
+}
+
+/**
+  * @brief  Configures the DMA streams of the receiver and of the transmitter and starts the reception
+  * @note   USART1_RX and USART1_TX are served by channel 4 of stream 2 and 7 of DMA2. It must be called once,
+  * 		before anything is written.
+  * @param  huart : The UART of the console, already initialized
+  */
+void ct_uart_init(UART_HandleTypeDef *huart)
+{
+	uart = huart;
+
+	__HAL_RCC_DMA2_CLK_ENABLE();
+	dmaTx.Instance = DMA2_Stream7;
+	dmaTx.Init.Channel = DMA_CHANNEL_4;
+	dmaTx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	dmaTx.Init.PeriphInc = DMA_PINC_DISABLE;
+	dmaTx.Init.MemInc = DMA_MINC_ENABLE;
+	dmaTx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	dmaTx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	dmaTx.Init.Mode = DMA_NORMAL;
+	dmaTx.Init.Priority = DMA_PRIORITY_LOW;
+	dmaTx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	HAL_DMA_Init(&dmaTx);
+	__HAL_LINKDMA(huart, hdmatx, dmaTx);
+
+	dmaRx.Instance = DMA2_Stream2;
+	dmaRx.Init.Channel = DMA_CHANNEL_4;
+	dmaRx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	dmaRx.Init.PeriphInc = DMA_PINC_DISABLE;
+	dmaRx.Init.MemInc = DMA_MINC_ENABLE;
+	dmaRx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	dmaRx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	dmaRx.Init.Mode = DMA_CIRCULAR;
+	dmaRx.Init.Priority = DMA_PRIORITY_LOW;
+	dmaRx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	HAL_DMA_Init(&dmaRx);
+	__HAL_LINKDMA(huart, hdmarx, dmaRx);
+
+	//the same priority of USART1_IRQn: both end up in ct_uart_rx_event()
+	HAL_NVIC_SetPriority(DMA2_Stream2_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+	HAL_NVIC_SetPriority(DMA2_Stream7_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream7_IRQn);
+
+	startReception();
+}
+
+/**
+  * @brief  Copies the received bytes in dst, it waits for some if there are none
+  * @note   Only one task can read.
+  * @param  dst : Where the bytes are copied
+  * @param  size : The maximum number of bytes copied
+  * @param  timeout : The longest time waited for a byte, in ticks
+  * @return the number of bytes copied, 0 if none arrived within the timeout
+  */
+uint32_t ct_uart_read(uint8_t *dst, uint32_t size, TickType_t timeout)
+{
+	uint32_t count, first;
+
+	reader = xTaskGetCurrentTaskHandle();
+	//a notification given after the check of the ring is not lost: it makes the take return straight away
+	while(head == tail)
+		if(ulTaskNotifyTake(pdTRUE, timeout) == 0 && head == tail)
+			return 0;
+
+	count = head - tail;
+	if(count > size)
+		count = size;
+	compilerBarrier();
+
+	first = tail % UART_RX_RING_SIZE;
+	if(first + count <= UART_RX_RING_SIZE)
+		memcpy(dst, ring + first, count);
+	else
+	{
+		memcpy(dst, ring + first, UART_RX_RING_SIZE - first);
+		memcpy(dst + UART_RX_RING_SIZE - first, ring, count - (UART_RX_RING_SIZE - first));
+	}
+
+	compilerBarrier();
+	tail += count;
+	return count;
+}
+
+/**
+  * @brief  Sends the bytes of the transmit ring completed so far, the caller must own txBusy
+  * @note   A transfer stops at the end of the ring, the next one starts from the beginning. When there is
+  * 		nothing left to send txBusy is released.
+  */
+static void sendNext(void)
+{
+	uint32_t tail, length, first, line;
+	bool idle;
+
+	while(1)
+	{
+		tail = txTail;
+		length = TX_DISTANCE(txCommit, tail);
+		if(length == 0)
+		{
+			__atomic_store_n(&txBusy, false, __ATOMIC_RELEASE);
+			//a writer that completed a message meanwhile found the transmitter busy and left it to us
+			idle = false;
+			if(TX_DISTANCE(txCommit, tail) == 0 || !__atomic_compare_exchange_n(&txBusy, &idle, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+				return;
+			continue;
+		}
+
+		first = tail % UART_TX_RING_SIZE;
+		if(first + length > UART_TX_RING_SIZE)
+			length = UART_TX_RING_SIZE - first;
+		txLength = length;
+
+		line = (uint32_t)(txRing + first) & ~31u;
+		SCB_CleanDCache_by_Addr((uint32_t*)line, (uint32_t)(txRing + first) + length - line);
+		if(HAL_UART_Transmit_DMA(uart, txRing + first, length) == HAL_OK)
+			return;
+
+		//somebody else is using the transmitter: the bytes are thrown away rather than waiting for it
+		stats.txErrors++;
+		txTail = TX_POSITION(tail + length);
+	}
+}
+
+/**
+  * @brief  Starts a transfer if the transmitter is idle
+  */
+static void kick(void)
+{
+	bool idle = false;
+
+	if(__atomic_compare_exchange_n(&txBusy, &idle, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+		sendNext();
+}
+
+/**
+  * @brief  Queues a message for transmission, it never waits
+  * @note   It can be called by any task or interrupt at the same time as other writers. The message is sent
+  * 		whole and never mixed with other messages, or dropped whole when the ring hasn't enough free space.
+  * @param  data : The message, it is copied
+  * @param  size : The size of the message in bytes
+  * @return true if the message has been queued, false if it has been dropped
+  */
+bool ct_uart_write(const void *data, uint32_t size)
+{
+	uint32_t state, next, pos, queued, first, commit;
+
+	if(size == 0)
+		return true;
+
+	//reserves the space of the message, and counts the writer, by moving the head of the ring
+	state = __atomic_load_n(&txState, __ATOMIC_RELAXED);
+	do
+	{
+		pos = TX_POSITION(state);
+		queued = TX_DISTANCE(pos, txTail);
+		if(queued + size > UART_TX_RING_SIZE)
+		{
+			__atomic_fetch_add(&stats.txDropped, 1, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&stats.txDroppedBytes, size, __ATOMIC_RELAXED);
+			return false;
+		}
+		next = ((state & ~0xffffu) + TX_WRITER) | TX_POSITION(pos + size);
+	}
+	while(!__atomic_compare_exchange_n(&txState, &state, next, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	first = pos % UART_TX_RING_SIZE;
+	if(first + size <= UART_TX_RING_SIZE)
+		memcpy(txRing + first, data, size);
+	else
+	{
+		memcpy(txRing + first, data, UART_TX_RING_SIZE - first);
+		memcpy(txRing, (const uint8_t*)data + UART_TX_RING_SIZE - first, size - (UART_TX_RING_SIZE - first));
+	}
+
+	//the last writer to finish publishes all the messages reserved so far, the ones it interrupted included;
+	//a writer preempted before publishing may come back with an older position, the commit never goes back
+	state = __atomic_sub_fetch(&txState, TX_WRITER, __ATOMIC_ACQ_REL);
+	if((state >> 16) == 0)
+	{
+		commit = txCommit;
+		while((int16_t)(TX_POSITION(state) - commit) > 0 &&
+				!__atomic_compare_exchange_n(&txCommit, &commit, TX_POSITION(state), true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+	}
+
+	__atomic_fetch_add(&stats.txBytes, size, __ATOMIC_RELAXED);
+	if(queued + size > stats.txPeak)
+		stats.txPeak = queued + size;
+
+	kick();
+	return true;
+}
+
+/**
+  * @return the free space of the transmit ring in bytes
+  */
+uint32_t ct_uart_tx_free(void)
+{
+	return UART_TX_RING_SIZE - TX_DISTANCE(TX_POSITION(txState), txTail);
+}
+
+/**
+  * @brief  Copies the counters of the receiver and of the transmitter
+  * @param  s : Where the counters are copied
+  */
+void ct_uart_get_stats(UartStats *s)
+{
+	*s = stats;
+}
+
+/**
+  * @brief  Moves the bytes written by the DMA since the previous event in the ring and wakes up the reader,
+  * 		it must be called by HAL_UARTEx_RxEventCallback() for the console UART
+  * @param  pos : The position in the DMA buffer of the next byte the DMA will write, UART_RX_DMA_SIZE when it wrapped
+  */
+void ct_uart_rx_event(uint16_t pos)
+{
+	BaseType_t woken = pdFALSE;
+	uint32_t h = head;
+
+	if(pos == dmaRead)
+		return;
+
+	SCB_InvalidateDCache_by_Addr((uint32_t*)dmaBuffer, UART_RX_DMA_SIZE);
+	//the DMA buffer is at most crossed once: the interrupt of the half transfer comes before it is overwritten
+	while(dmaRead != pos)
+	{
+		if(h - tail < UART_RX_RING_SIZE)
+			ring[h++ % UART_RX_RING_SIZE] = dmaBuffer[dmaRead];
+		else
+			stats.rxDropped++;
+		dmaRead = (dmaRead + 1) % UART_RX_DMA_SIZE;
+		if(pos == UART_RX_DMA_SIZE && dmaRead == 0)
+			break;
+	}
+
+	compilerBarrier();
+	head = h;
+	if(reader != NULL)
+		vTaskNotifyGiveFromISR(reader, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+/**
+  * @brief  Starts the next transfer once the previous one is over, it must be called by HAL_UART_TxCpltCallback()
+  * 		for the console UART
+  */
+void ct_uart_tx_done(void)
+{
+	txTail = TX_POSITION(txTail + txLength);
+	sendNext();
+}
+
+/**
+  * @brief  Restarts the reception or the transmission after the HAL stopped them for an error,
+  * 		it must be called by HAL_UART_ErrorCallback() for the console UART
+  * @note   The HAL stops the DMA on every error of a DMA reception: the bytes not yet moved in the ring are lost.
+  * 		A transfer stopped by a DMA error is given up and the transmitter goes on with the next bytes.
+  */
+void ct_uart_error(void)
+{
+	if(uart->RxState == HAL_UART_STATE_READY)
+	{
+		stats.rxErrors++;
+		startReception();
+	}
+
+	if(dmaTx.ErrorCode != HAL_DMA_ERROR_NONE && uart->gState == HAL_UART_STATE_READY)
+	{
+		dmaTx.ErrorCode = HAL_DMA_ERROR_NONE;
+		stats.txErrors++;
+		ct_uart_tx_done();
+	}
+}
+
+/**
+  * @brief  Handles the interrupts of the DMA stream of the receiver, it must be called by DMA2_Stream2_IRQHandler()
+  */
+void ct_uart_rx_irq_handler(void)
+{
+	HAL_DMA_IRQHandler(&dmaRx);
+}
+
+/**
+  * @brief  Handles the interrupts of the DMA stream of the transmitter, it must be called by DMA2_Stream7_IRQHandler()
+  */
+void ct_uart_tx_irq_handler(void)
+{
+	HAL_DMA_IRQHandler(&dmaTx);
+}
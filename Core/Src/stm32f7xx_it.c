@@ -26,6 +26,10 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "main_user.h"
+#include "render/blit.h"
+#include "render/screen.h"
+#include "platform/platform.h"
+#include "serial/uart.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -35,7 +39,7 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
- 
+#define TS_INT_Pin GPIO_PIN_13 //INT line of the touch panel controller, PI13, configured by BSP_TS_ITConfig()
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -68,15 +72,23 @@ void HAL_GPIO_EXTI_Callback (uint16_t GPIO_Pin)
 	uint32_t byte;
 	if(GPIO_Pin == BUTTON_Pin)
 		xTaskNotifyFromISR(button_task_handler, byte, eSetValueWithoutOverwrite, NULL);
+	else if(GPIO_Pin == TS_INT_Pin) //the touch panel has new data: the input task reads it, the cycle counter dates it
+		xTaskNotifyFromISR(input_task_handler, platformCycles(), eSetValueWithOverwrite, NULL);
 }
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	if(huart == &huart1) //the DMA of the console received a burst of characters, or half of its buffer
+		ct_uart_rx_event(Size);
+}
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if(huart == &huart1) //the DMA sent a part of the transmit ring of the console
+		ct_uart_tx_done();
+}
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
-	uint32_t byte;
 	if(huart == &huart1)
-	{
-		byte = (uint32_t)huart1.Instance->RDR;
-		xTaskNotifyFromISR(uart_rx_task_handler, byte, eSetValueWithoutOverwrite, NULL);
-	}
+		ct_uart_error();
 }
 /* USER CODE END EV */
 
@@ -233,5 +245,44 @@ void TIM6_DAC_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA2D global interrupt.
+  */
+void DMA2D_IRQHandler(void)
+{
+	ct_blit_irq_handler();
+}
+
+/**
+  * @brief This function handles LTDC global interrupt.
+  */
+void LTDC_IRQHandler(void)
+{
+	ct_screen_irq_handler();
+}
+
+/**
+  * @brief This function handles EXTI lines 10 to 15 interrupt: the INT line of the touch panel controller.
+  */
+void EXTI15_10_IRQHandler(void)
+{
+	HAL_GPIO_EXTI_IRQHandler(TS_INT_Pin);
+}
+
+/**
+  * @brief This function handles DMA2 stream2 global interrupt: the receiver of USART1.
+  */
+void DMA2_Stream2_IRQHandler(void)
+{
+	ct_uart_rx_irq_handler();
+}
+
+/**
+  * @brief This function handles DMA2 stream7 global interrupt: the transmitter of USART1.
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+	ct_uart_tx_irq_handler();
+}
 
 /* USER CODE END 1 */
@@ -0,0 +1,70 @@
+/*
+ * bench_render.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+/*
+ * Host run of the renderer benchmark of render/bench.h.
+ *
+ * Usage: bench_render [resolution 0-3]
+ * Without arguments every resolution is measured in turn, then the other styles of the rays on the map at the
+ * first resolution, then the mazes of growing size at the first resolution, then the text drawing methods are compared. The frame buffers are in the heap and the drawing is
+ * done by the software backend of platform_host.c, so the numbers are only comparable with other host runs.
+ */
+
+#include "host.h"
+#include "render/bench.h"
+#include "render/raycast.h"
+#include "render/texture.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+	Resolution first = argc > 1 ? (Resolution)(atoi(argv[1]) % RESOLUTION_COUNT) : RESOLUTION_LEGACY;
+	Resolution last = argc > 1 ? first : RESOLUTION_COUNT - 1;
+	BenchReport report;
+	BenchTextReport textReport;
+	BenchMazeReport mazeReport;
+	char text[512];
+
+	Screen *s = ct_screen_init();
+	importMaps();
+	raycastInit();
+	textureInit();
+
+	for(Resolution res = first; res <= last; res++)
+	{
+		setResolution(res, s);
+		benchRun(s, &report);
+		benchFormat(&report, text, sizeof(text));
+		fputs(text, stdout);
+	}
+
+	MapRaysStyle measured = getMapRaysStyle();
+	setResolution(first, s);
+	for(MapRaysStyle style = 0; style < MAP_RAYS_STYLES; style++)
+	{
+		if(style == measured)
+			continue;
+		setMapRaysStyle(style);
+		benchRun(s, &report);
+		benchFormat(&report, text, sizeof(text));
+		fputs(text, stdout);
+	}
+	setMapRaysStyle(measured);
+
+	if(benchMazes(s, &mazeReport))
+	{
+		benchMazesFormat(&mazeReport, text, sizeof(text));
+		fputs(text, stdout);
+	}
+
+	benchText(s, &textReport);
+	benchTextFormat(&textReport, text, sizeof(text));
+	fputs(text, stdout);
+
+	return 0;
+}
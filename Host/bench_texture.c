@@ -0,0 +1,90 @@
+/*
+ * bench_texture.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+/*
+ * Host benchmark of the wall texture sampler.
+ *
+ * It draws the walls of a frame of 3D scene, every column with the same height, with textureSpan() and with
+ * a flat fill of the same pixels, for the column widths of RESOLUTION_LEGACY, QUARTER, HALF and FULL and for
+ * a range of wall heights, and prints the time per frame of both. The frame buffer is a plain malloc'd
+ * buffer, so the numbers only compare the two inner loops: on the board the SDRAM writes dominate both.
+ *
+ * It is built by the host CMake target bench_texture, configure with -DSCREEN_PIXEL_FORMAT=1 or 2 to
+ * measure the RGB565 and L8 frame buffers.
+ */
+
+#include "render/texture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define WIDTH 800
+#define HEIGHT 480
+#define FRAMES 200
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+//flat fill of a span, the loop drawColumn() used before textures apart from the 64 bit stores
+static pixel_t* flatSpan(pixel_t *dst, int stride, int width, int rows, pixel_t color)
+{
+	for(int y = 0; y < rows; y++, dst += stride)
+		for(int x = 0; x < width; x++)
+			dst[x] = color;
+	return dst;
+}
+
+int main(void)
+{
+	static const int widths[] = { 13, 4, 2, 1 };
+	static const char *names[] = { "legacy", "quarter", "half", "full" };
+	static const int heights[] = { 60, 240, 480 };
+	pixel_t *fb = malloc(WIDTH * HEIGHT * PIXEL_BYTES);
+	uint32_t check = 0;
+
+	textureInit();
+	printf("%-8s %6s %12s %12s %8s\n", "res", "wall", "flat us", "texture us", "ratio");
+
+	for(unsigned w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+		for(unsigned h = 0; h < sizeof(heights) / sizeof(heights[0]); h++)
+		{
+			int columns = WIDTH / widths[w];
+			int rows = heights[h];
+			int top = (HEIGHT - rows) / 2;
+			fixed step = FIXED_ONE * TEXTURE_SIZE / rows;
+			double flat, textured, start;
+
+			start = now();
+			for(int f = 0; f < FRAMES; f++)
+				for(int c = 0; c < columns; c++)
+					flatSpan(fb + top * WIDTH + c * widths[w], WIDTH, widths[w], rows, (pixel_t)(f + c));
+			flat = (now() - start) / FRAMES * 1e6;
+			check += fb[(HEIGHT / 2) * WIDTH];
+
+			start = now();
+			for(int f = 0; f < FRAMES; f++)
+				for(int c = 0; c < columns; c++)
+				{
+					fixed texX = (fixed)((int64_t)(c + f) * FIXED_ONE / columns) & (FIXED_ONE - 1);
+					const pixel_t *column = textureColumn(c & 1 ? TEXTURE_EXIT : TEXTURE_WALL, f & 1, texX);
+					textureSpan(fb + top * WIDTH + c * widths[w], WIDTH, widths[w], rows, column, 0, step);
+				}
+			textured = (now() - start) / FRAMES * 1e6;
+			check += fb[(HEIGHT / 2) * WIDTH];
+
+			printf("%-8s %6d %12.1f %12.1f %8.2f\n", names[w], rows, flat, textured, textured / flat);
+		}
+
+	//printed so that the compiler can't drop the drawing
+	printf("checksum %u\n", (unsigned)check);
+	free(fb);
+	return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * blit_regress.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+/*
+ * Host regression test of the DMA2D job queue of render/blit.h.
+ *
+ * The queue is built with BLIT_MOCK, so the jobs are executed only when ct_blit_mock_step() is called: the
+ * test queues fills and copies, steps the mock one job at a time and checks after every step the fences
+ * reached and the pixels written, so the order of the jobs, the start of the next job by the interrupt and
+ * the wait for a free slot of a full ring are checked deterministically.
+ *
+ * It is built by the host CMake target blit_regress and run by ctest, in every SCREEN_PIXEL_FORMAT: the
+ * rectangles are 8 byte aligned and of even width, so in L8 they are queued as pixel pairs as on the board.
+ */
+
+#include "render/blit.h"
+#include "render/pixel.h"
+#include <stdio.h>
+
+#define WIDTH 16
+#define HEIGHT 8
+
+#define CHECK(condition) check(condition, #condition, __LINE__)
+
+static int failures;
+
+static void check(bool condition, const char *text, int line)
+{
+	if(!condition)
+	{
+		fprintf(stderr, "blit_regress.c:%d: %s\n", line, text);
+		failures++;
+	}
+}
+
+/**
+  * @return true if every pixel of a rectangle of a WIDTH pixel wide buffer has a color
+  */
+static bool rectIs(const pixel_t *buffer, int x, int y, int width, int height, uint32_t color)
+{
+	pixel_t pixel = pixelFromArgb(color);
+	for(int j = y; j < y + height; j++)
+		for(int i = x; i < x + width; i++)
+			if(buffer[j * WIDTH + i] != pixel)
+				return false;
+	return true;
+}
+
+int main(void)
+{
+	static _Alignas(8) pixel_t a[WIDTH * HEIGHT];
+	static _Alignas(8) pixel_t b[WIDTH * HEIGHT];
+	const uint32_t black = 0xFF000000, red = 0xFFFF0000, green = 0xFF00FF00, blue = 0xFF0000FF;
+
+	ct_blit_init();
+	for(int i = 0; i < WIDTH * HEIGHT; i++)
+		a[i] = b[i] = pixelFromArgb(black);
+	uint32_t start = ct_blit_fence();
+	CHECK(ct_blit_done(start));
+	CHECK(!ct_blit_mock_step());
+
+	//three jobs, nothing is executed until the mock is stepped
+	uint32_t fillA = ct_blit_fill(a, WIDTH, HEIGHT, 0, red);
+	uint32_t copyAB = ct_blit_copy(a, 0, b, 0, WIDTH, HEIGHT);
+	uint32_t refillA = ct_blit_fill(a + WIDTH + 2, 4, 2, WIDTH - 4, blue);
+	CHECK(fillA == start + 1 && copyAB == start + 2 && refillA == start + 3);
+	CHECK(ct_blit_fence() == refillA);
+	CHECK(!ct_blit_done(fillA));
+	CHECK(rectIs(a, 0, 0, WIDTH, HEIGHT, black));
+
+	//every step completes the running job and starts the next one, as the interrupt does
+	CHECK(ct_blit_mock_step());
+	CHECK(ct_blit_done(fillA) && !ct_blit_done(copyAB));
+	CHECK(rectIs(a, 0, 0, WIDTH, HEIGHT, red));
+	CHECK(rectIs(b, 0, 0, WIDTH, HEIGHT, black));
+
+	CHECK(ct_blit_mock_step());
+	CHECK(ct_blit_done(copyAB) && !ct_blit_done(refillA));
+	CHECK(rectIs(b, 0, 0, WIDTH, HEIGHT, red));
+
+	//the copy has read the source before the fill queued after it, the offset keeps the fill in its rectangle
+	ct_blit_wait(refillA);
+	CHECK(ct_blit_done(refillA));
+	CHECK(rectIs(a, 2, 1, 4, 2, blue));
+	CHECK(rectIs(a, 0, 0, WIDTH, 1, red) && rectIs(a, 0, 3, WIDTH, HEIGHT - 3, red));
+	CHECK(rectIs(a, 0, 1, 2, 2, red) && rectIs(a, 6, 1, WIDTH - 6, 2, red));
+	CHECK(rectIs(b, 0, 0, WIDTH, HEIGHT, red));
+	CHECK(!ct_blit_mock_step());
+
+	//a copy with offsets on both sides: the first 4 columns of a go to the last 4 of b
+	uint32_t copyCorner = ct_blit_copy(a, WIDTH - 4, b + WIDTH - 4, WIDTH - 4, 4, HEIGHT);
+	ct_blit_wait(copyCorner);
+	CHECK(rectIs(b, WIDTH - 2, 1, 2, 2, blue) && rectIs(b, WIDTH - 4, 1, 2, 2, red));
+	CHECK(rectIs(b, 0, 0, WIDTH - 4, HEIGHT, red));
+
+	//a full ring: the submit of the job after BLIT_QUEUE_SIZE queued ones waits for the oldest, the jobs
+	//are still executed in order and the last color wins
+	uint32_t first = ct_blit_fence() + 1, last = 0;
+	for(int i = 0; i < BLIT_QUEUE_SIZE + 4; i++)
+		last = ct_blit_fill(a, WIDTH, HEIGHT, 0, i & 1 ? green : blue);
+	CHECK(last == first + BLIT_QUEUE_SIZE + 3);
+	CHECK(ct_blit_done(first + 3) && !ct_blit_done(first + 4));
+	CHECK(rectIs(a, 0, 0, WIDTH, HEIGHT, green));
+	ct_blit_wait(last);
+	CHECK(ct_blit_done(last));
+	CHECK(rectIs(a, 0, 0, WIDTH, HEIGHT, green));
+	CHECK(!ct_blit_mock_step());
+
+	CHECK(ct_blit_errors() == 0);
+
+	if(failures > 0)
+	{
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	printf("blit queue: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,30 @@
+/*
+ * host.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef HOST_HOST_H_
+#define HOST_HOST_H_
+
+#include "render/screen.h"
+#include "platform/platform.h"
+
+/*
+ * Host (Linux) backend of the platform layer.
+ *
+ * screen_host.c implements the ct_screen API of render/screen.h with frame buffers in the heap: a flip
+ * displays the back buffer straight away, there is no vertical blanking to wait for. platform_host.c draws
+ * into the back buffer with the CPU, pixel by pixel as the BSP would, so the host frames match the board ones.
+ * vram_host.c serves vramAlloc() from the heap.
+ */
+
+//size of the display of the STM32F769I-DISCO
+#define HOST_SCREEN_WIDTH 800
+#define HOST_SCREEN_HEIGHT 480
+
+void hostSetTouch(const PlatformTouch *touch);
+int hostDumpPpm(Screen *screen, const char *path);
+
+#endif /* HOST_HOST_H_ */
@@ -0,0 +1,32 @@
+/*
+ * FreeRTOS.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef HOST_INCLUDE_FREERTOS_H_
+#define HOST_INCLUDE_FREERTOS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Host stand in of the FreeRTOS headers used by the render and game modules.
+ *
+ * The host build is single threaded: mutexes are always free, critical sections do nothing and software
+ * timers never fire. Only the types and calls of the modules built by the host CMake target are provided.
+ */
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / (TickType_t)1000))
+
+#endif /* HOST_INCLUDE_FREERTOS_H_ */
@@ -0,0 +1,34 @@
+/*
+ * semphr.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef HOST_INCLUDE_SEMPHR_H_
+#define HOST_INCLUDE_SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+typedef void* SemaphoreHandle_t;
+
+//a single thread always gets the mutex straight away
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	return (SemaphoreHandle_t)1;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+	(void)sem;
+	(void)ticks;
+	return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+	(void)sem;
+	return pdTRUE;
+}
+
+#endif /* HOST_INCLUDE_SEMPHR_H_ */
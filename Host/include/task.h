@@ -0,0 +1,30 @@
+/*
+ * task.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef HOST_INCLUDE_TASK_H_
+#define HOST_INCLUDE_TASK_H_
+
+#include "FreeRTOS.h"
+#include <time.h>
+
+typedef void* TaskHandle_t;
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskYIELD()
+
+/**
+  * @return the milliseconds elapsed on the monotonic clock, a tick is a millisecond as on the board
+  */
+static inline TickType_t xTaskGetTickCount(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (TickType_t)(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+}
+
+#endif /* HOST_INCLUDE_TASK_H_ */
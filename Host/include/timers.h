@@ -0,0 +1,39 @@
+/*
+ * timers.h
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#ifndef HOST_INCLUDE_TIMERS_H_
+#define HOST_INCLUDE_TIMERS_H_
+
+#include "FreeRTOS.h"
+
+typedef void* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+//there is no timer task on the host: timers are created but their callback is never called
+static inline TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload, void *id,
+		TimerCallbackFunction_t callback)
+{
+	(void)name;
+	(void)period;
+	(void)autoReload;
+	(void)id;
+	(void)callback;
+	return (TimerHandle_t)1;
+}
+
+static inline BaseType_t xTimerCommand(TimerHandle_t timer, TickType_t ticks)
+{
+	(void)timer;
+	(void)ticks;
+	return pdPASS;
+}
+
+#define xTimerStart(timer, ticks) xTimerCommand(timer, ticks)
+#define xTimerStop(timer, ticks) xTimerCommand(timer, ticks)
+#define xTimerReset(timer, ticks) xTimerCommand(timer, ticks)
+
+#endif /* HOST_INCLUDE_TIMERS_H_ */
@@ -0,0 +1,162 @@
+/*
+ * main_host.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+/*
+ * Host run of the game: a recording of game/replay.h moves the player as sim_task() does on the board, a step
+ * for every frame, and every frame is drawn as main_task() draws it (3D scene, minimap with rays and player,
+ * controls), then flipped.
+ *
+ * Usage: raycast_host [frames|0] [output directory|-] [resolution 0-3] [telemetry output|-] [recording]
+ * The recording is a text file, e.g. dumped by the i dump console command, or the demo of replay.c when it
+ * is not given. With 0 frames, the default, the run lasts as long as the recording, with more frames the
+ * recording starts over from gameReset(). When an output directory is given every frame is written there as
+ * frame_NNNN.ppm. The average time of a frame, with the average fps, the 1% low fps and the longest frame of
+ * the last frames, is printed at the end.
+ * When a telemetry output is given, a file or one end of a pty pair, a TELEMETRY_FRAME packet is written
+ * there for every frame as the board streams it, to be read by telemetry_decode.
+ */
+
+#include "host.h"
+#include "game/game.h"
+#include "game/replay.h"
+#include "render/raycast.h"
+#include "render/texture.h"
+#include "profile/frametime.h"
+#include "serial/telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//milliseconds of game time simulated for every frame
+#define STEP_MS 25
+
+static Recording recording;
+
+/**
+  * @brief  Reads a recording from a text file
+  * @return true if the file is a complete recording
+  */
+static bool loadRecording(const char *name, Recording *r)
+{
+	static char text[1 << 20];
+	FILE *in = fopen(name, "rb");
+	size_t length;
+
+	if(in == NULL)
+		return false;
+	length = fread(text, 1, sizeof(text) - 1, in);
+	text[length] = '\0';
+	fclose(in);
+	return length < sizeof(text) - 1 && replayParse(r, text);
+}
+
+int main(int argc, char **argv)
+{
+	int frames = argc > 1 ? atoi(argv[1]) : 0;
+	const char *outDir = argc > 2 && strcmp(argv[2], "-") != 0 ? argv[2] : NULL;
+	Resolution res = argc > 3 ? (Resolution)(atoi(argv[3]) % RESOLUTION_COUNT) : RESOLUTION_LEGACY;
+	FILE *telemetry = argc > 4 && strcmp(argv[4], "-") != 0 ? fopen(argv[4], "wb") : NULL;
+	uint8_t packet[TELEMETRY_MAX_ENCODED];
+	char commands[REPLAY_STEP_COMMANDS];
+	uint32_t step = 0, cursor = 0;
+
+	if(argc > 4 && strcmp(argv[4], "-") != 0 && telemetry == NULL)
+	{
+		fprintf(stderr, "can't write %s\n", argv[4]);
+		return 1;
+	}
+	if(argc > 5 ? !loadRecording(argv[5], &recording) : !replayParse(&recording, replayDemo))
+	{
+		fprintf(stderr, "can't read the recording %s\n", argc > 5 ? argv[5] : "demo");
+		return 1;
+	}
+	if(frames <= 0)
+		frames = recording.steps;
+
+	GameState game = { 0 };
+	importMaps();
+	game.player.initial_pos = (vec2){ 152, 512 };
+	gameReset(&game);
+
+	Screen *s = ct_screen_init();
+	raycastInit();
+	textureInit();
+	setResolution(res, s);
+
+	TickType_t start = xTaskGetTickCount();
+	for(int f = 0; f < frames; f++)
+	{
+		//a step of the simulation task for every frame, then the frame is drawn from a copy of the state
+		if(step == recording.steps)
+		{
+			gameReset(&game);
+			step = cursor = 0;
+		}
+		int count = replayCommands(&recording, &cursor, step++, commands);
+		for(int i = 0; i < count; i++)
+			if(game.exitCountdown == 0)
+				playerMovementKeyboard(&game.player, &game.map, commands[i]);
+		gameLogic(&game, STEP_MS);
+		GameState frame = game;
+
+		uint32_t t[5];
+		t[0] = platformCycles();
+		castRays(frame.player.pos.x, frame.player.pos.y, frame.player.angle, &frame.map);
+		ct_screen_wait_backbuffer(s);
+		t[1] = platformCycles();
+		drawRays(&frame.map, s);
+		t[2] = platformCycles();
+		drawMap(&frame.map, s);
+		drawMapRays(frame.player.pos.x, frame.player.pos.y, &frame.map, s);
+		drawMapPlayer(&frame.player, &frame.map, s);
+		drawControls(s, 2);
+		if(frame.exitCountdown > 0)
+			showExitScreen(s, frame.exitCountdown);
+		t[3] = platformCycles();
+		ct_screen_flip_buffers(s);
+		t[4] = platformCycles();
+		frameTimeMark();
+
+		if(telemetry != NULL)
+		{
+			RayStats rays;
+			getRayStats(&rays);
+			TelemetryFrame tf = {
+				.frame = f, .timeMs = xTaskGetTickCount(), .frameUs = frameTimeLast(),
+				.castUs = (t[1] - t[0]) / platformCyclesPerUs(), .wallsUs = (t[2] - t[1]) / platformCyclesPerUs(),
+				.hudUs = (t[3] - t[2]) / platformCyclesPerUs(), .flipUs = (t[4] - t[3]) / platformCyclesPerUs(),
+				.x = frame.player.pos.x, .y = frame.player.pos.y, .angle = frame.player.angle, .map = frame.map.index,
+				.rays = rays.rays, .vertical = rays.vertical, .misses = rays.misses,
+				.minDistance = rays.minDistance, .avgDistance = rays.avgDistance, .maxDistance = rays.maxDistance
+			};
+			fwrite(packet, 1, telemetryEncodeFrame(&tf, packet), telemetry);
+			fflush(telemetry);
+		}
+
+		if(outDir != NULL)
+		{
+			char name[512];
+			snprintf(name, sizeof(name), "%s/frame_%04d.ppm", outDir, f);
+			if(hostDumpPpm(s, name) != 0)
+			{
+				fprintf(stderr, "can't write %s\n", name);
+				return 1;
+			}
+		}
+	}
+
+	if(telemetry != NULL)
+		fclose(telemetry);
+
+	TickType_t elapsed = xTaskGetTickCount() - start;
+	FrameTimeStats stats;
+	frameTimeGetStats(&stats);
+	printf("%d frames, %.3f ms per frame\n", frames, frames ? (double)elapsed / frames : 0.0);
+	printf("last %lu frames: %lu fps, 1%% low %lu fps, max %lu us\n", (unsigned long)stats.frames,
+			(unsigned long)stats.avgFps, (unsigned long)stats.lowFps, (unsigned long)stats.maxUs);
+	return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * platform_host.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "host.h"
+#include "render/blit.h"
+#include "render/text.h"
+#include "fonts.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//the drawing state of the BSP: text color, back color and font
+static uint32_t textColor = COLOR_BLACK;
+static uint32_t backColor = COLOR_WHITE;
+static const sFONT *font = &Font24;
+//touches returned by platformGetTouch(), set by hostSetTouch()
+static PlatformTouch touchState;
+
+/**
+  * @return the back buffer, it is got if the caller hasn't done it yet
+  */
+static pixel_t* target(void)
+{
+	ct_screen_wait_backbuffer(screen);
+	return ct_screen_backbuffer_ptr(screen);
+}
+
+/**
+  * @brief  Writes a pixel, the pixels out of the screen are dropped where the BSP would write past the buffer
+  * @param  x : The x coordinate of the pixel
+  * @param  y : The y coordinate of the pixel
+  * @param  color : The ARGB8888 color of the pixel
+  */
+static void putPixel(int x, int y, uint32_t color)
+{
+	if(x < 0 || y < 0 || x >= (int)screen->width || y >= (int)screen->height)
+		return;
+	target()[y * screen->width + x] = pixelFromArgb(color);
+}
+
+/**
+  * @param  color : The ARGB8888 color of the following lines, rectangles and text
+  */
+void platformSetTextColor(uint32_t color)
+{
+	textColor = color;
+}
+
+/**
+  * @param  color : The ARGB8888 color of the background of the following text
+  */
+void platformSetBackColor(uint32_t color)
+{
+	backColor = color;
+}
+
+/**
+  * @brief  Fills the whole back buffer with a color
+  * @param  color : The ARGB8888 color
+  */
+void platformClear(uint32_t color)
+{
+	pixel_t *dst = target();
+	pixel_t pixel = pixelFromArgb(color);
+	for(uint32_t i = 0; i < screen->width * screen->height; i++)
+		dst[i] = pixel;
+}
+
+/**
+  * @brief  Fills a rectangle with the text color
+  * @param  x : The x coordinate of the top left corner
+  * @param  y : The y coordinate of the top left corner
+  * @param  width : The width of the rectangle
+  * @param  height : The height of the rectangle
+  */
+void platformFillRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	for(int row = y; row < y + height; row++)
+		for(int col = x; col < x + width; col++)
+			putPixel(col, row, textColor);
+}
+
+/**
+  * @brief  Draws the outline of a rectangle with the text color, as BSP_LCD_DrawRect() it spans
+  * 		width+1 x height+1 pixels but leaves the bottom right corner out
+  * @param  x : The x coordinate of the top left corner
+  * @param  y : The y coordinate of the top left corner
+  * @param  width : The width of the rectangle
+  * @param  height : The height of the rectangle
+  */
+void platformDrawRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	for(int i = 0; i < width; i++)
+	{
+		putPixel(x + i, y, textColor);
+		putPixel(x + i, y + height, textColor);
+	}
+	for(int i = 0; i < height; i++)
+	{
+		putPixel(x, y + i, textColor);
+		putPixel(x + width, y + i, textColor);
+	}
+}
+
+/**
+  * @brief  Draws a line with the text color, both ends included, with the same algorithm of BSP_LCD_DrawLine()
+  * @param  x1 : The x coordinate of the first end
+  * @param  y1 : The y coordinate of the first end
+  * @param  x2 : The x coordinate of the second end
+  * @param  y2 : The y coordinate of the second end
+  */
+void platformDrawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+	int deltaX = abs(x2 - x1), deltaY = abs(y2 - y1);
+	int incX = x2 >= x1 ? 1 : -1, incY = y2 >= y1 ? 1 : -1;
+	int x = x1, y = y1;
+	bool xMajor = deltaX >= deltaY;
+	int den = xMajor ? deltaX : deltaY;
+	int num = den / 2;
+	int numAdd = xMajor ? deltaY : deltaX;
+
+	for(int i = 0; i <= den; i++)
+	{
+		putPixel(x, y, textColor);
+		num += numAdd;
+		if(num >= den)
+		{
+			num -= den;
+			x += xMajor ? 0 : incX;
+			y += xMajor ? incY : 0;
+		}
+		x += xMajor ? incX : 0;
+		y += xMajor ? 0 : incY;
+	}
+}
+
+/**
+  * @param  x : The x coordinate of the pixel
+  * @param  y : The y coordinate of the pixel
+  * @param  color : The ARGB8888 color of the pixel
+  */
+void platformDrawPixel(uint16_t x, uint16_t y, uint32_t color)
+{
+	putPixel(x, y, color);
+}
+
+/**
+  * @brief  Draws a character with the text color on the back color
+  * @param  x : The x coordinate of the top left corner
+  * @param  y : The y coordinate of the top left corner
+  * @param  c : The character
+  */
+static void drawChar(int x, int y, char c)
+{
+	int bytes = (font->Width + 7) / 8;
+	const uint8_t *glyph = &font->table[(c - ' ') * font->Height * bytes];
+
+	for(int row = 0; row < font->Height; row++, glyph += bytes)
+	{
+		uint32_t line = 0;
+		for(int b = 0; b < bytes; b++)
+			line = (line << 8) | glyph[b];
+		for(int col = 0; col < font->Width; col++)
+			putPixel(x + col, y + row, line & (1u << (bytes * 8 - 1 - col)) ? textColor : backColor);
+	}
+}
+
+/**
+  * @brief  Draws a string with the text color on the back color, with the placement of BSP_LCD_DisplayStringAt()
+  * @note   The glyph cache of text.c queues its jobs on the software DMA2D of blit.c, which executes them
+  * 		before the function returns.
+  * @param  x : The x coordinate, its meaning depends on the alignment
+  * @param  y : The y coordinate of the top of the string
+  * @param  text : The string
+  * @param  align : The alignment of the string
+  */
+void platformDrawString(uint16_t x, uint16_t y, const char *text, PlatformAlign align)
+{
+	TextTarget t = { .buffer = target(), .width = screen->width, .height = screen->height,
+					.font = font, .color = textColor, .backColor = backColor };
+	ct_blit_wait(textDrawString(&t, x, y, text, align));
+}
+
+/**
+  * @brief  Draws a string as platformDrawString(), a pixel at a time as the DrawChar() of the BSP
+  * @param  x : The x coordinate, its meaning depends on the alignment
+  * @param  y : The y coordinate of the top of the string
+  * @param  text : The string
+  * @param  align : The alignment of the string
+  */
+void platformDrawStringPerPixel(uint16_t x, uint16_t y, const char *text, PlatformAlign align)
+{
+	int column = textColumn(screen->width, font, text, x, align);
+
+	for(int i = 0; text[i] != 0 && (int)screen->width - i * font->Width >= font->Width; i++)
+		drawChar(column + i * font->Width, y, text[i]);
+}
+
+/**
+  * @param  touch : Where the touches set with hostSetTouch() are written
+  */
+void platformGetTouch(PlatformTouch *touch)
+{
+	*touch = touchState;
+	touch->stamp = platformCycles();
+}
+
+/**
+  * @return the back buffer, the functions above draw into it
+  */
+pixel_t* platformDrawBuffer(void)
+{
+	return target();
+}
+
+/**
+  * @brief  The CPU is the only one touching the frame buffers on the host
+  */
+void platformFlushPixels(void)
+{
+}
+
+/**
+  * @brief  Executes the jobs queued on the software DMA2D of blit.c, e.g. the copies of minimap.c: the rest is
+  * 		drawn synchronously on the host
+  */
+void platformWaitDrawing(void)
+{
+	ct_blit_wait(ct_blit_fence());
+}
+
+/**
+  * @return the nanoseconds of the monotonic clock, truncated to 32 bit
+  */
+uint32_t platformCycles(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint32_t)((uint64_t)t.tv_sec * 1000000000u + t.tv_nsec);
+}
+
+/**
+  * @return the number of cycles counted by platformCycles() in a microsecond: they are nanoseconds
+  */
+uint32_t platformCyclesPerUs(void)
+{
+	return 1000;
+}
+
+/**
+  * @brief  Sets the touches reported by platformGetTouch(), e.g. to drive the touch controls from a script
+  * @param  touch : The touches, they stay until the next call
+  */
+void hostSetTouch(const PlatformTouch *touch)
+{
+	touchState = *touch;
+}
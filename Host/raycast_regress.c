@@ -0,0 +1,204 @@
+/*
+ * raycast_regress.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+/*
+ * Host regression test of the fixed point ray caster of render/raycast.h against castRaysFloat().
+ *
+ * Usage: raycast_regress [poses per map] [seed]
+ * The player is put on random floor positions with random angles of every map of map.c, the same ones for a
+ * seed, and the FOV rays of castRays() in RESOLUTION_LEGACY are compared with the ones of castRaysFloat().
+ * The test fails when the tolerance documented in raycast.h is exceeded:
+ * - the share of the rays whose distance or pos differ by more than 0.5 pixels, of the ones among them that
+ *   pass near a block corner and of the rays whose vertical differs;
+ * - any ray out of the above neither passing near a block corner nor explained by the difference of the
+ *   angles of the two casters;
+ * - any hit pos of castRays() outside its opaque block.
+ *
+ * It is built by the host CMake target raycast_regress and run by ctest with the default arguments.
+ */
+
+#include "render/render.h"
+#include "render/raycast.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//random poses on every map
+#define POSES 20000
+//the rays with distance or pos farther than this from castRaysFloat() are mismatches, in pixel
+#define MATCH_PIXELS 0.5f
+//difference between the directions of the rays of the two casters, in radians: the float angles of castRaysFloat()
+//are accumulated over FOV additions of DEGREE_RADIAN, castRays() uses binary angles
+#define ANGLE_TOLERANCE 2e-5f
+//a mismatch that the angle doesn't explain must pass this close to a block corner, in pixel
+#define CORNER_PIXELS 1.5f
+//largest share of the mismatches, of the ones passing near a corner and of the rays whose vertical differs, in
+//parts per million
+#define MISMATCH_PPM 30
+#define CORNER_PPM 10
+#define VERTICAL_PPM 12
+
+typedef struct {
+	long rays;
+	long mismatches; //distance or pos farther than MATCH_PIXELS
+	long grazing; //mismatches explained by ANGLE_TOLERANCE, the rays grazing a wall
+	long corners; //mismatches near a block corner
+	long unexplained; //mismatches neither explained by the angle nor near a corner
+	long vertical; //vertical differs
+	long outside; //hit pos of castRays() outside an opaque block
+	float maxError; //largest distance error of the grazing rays, relative to the distance
+} Stats;
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+/**
+  * @return a random number in [0, 1)
+  */
+static float randomUnit(uint32_t *state)
+{
+	return (nextRandom(state) >> 8) * (1.0f / (1 << 24));
+}
+
+/**
+  * @return the distance in pixel of a point from the nearest block corner
+  */
+static float cornerDistance(vec2 p)
+{
+	float dx = p.x - roundf(p.x / MAP_BLOCK_SIZE) * MAP_BLOCK_SIZE;
+	float dy = p.y - roundf(p.y / MAP_BLOCK_SIZE) * MAP_BLOCK_SIZE;
+	return sqrtf(dx*dx + dy*dy);
+}
+
+/**
+  * @return true if the differences of two rays that hit the same face of a wall come from the difference of
+  * 		their angles: it moves the hit along the wall by up to distance * ANGLE_TOLERANCE / sin(grazing angle)
+  */
+static bool angleExplains(const Ray *a, const Ray *b)
+{
+	float across = a->vertical ? fabsf(cosf(a->angle)) : fabsf(sinf(a->angle));
+	float bound = MATCH_PIXELS + b->distance * ANGLE_TOLERANCE / fmaxf(across, 1e-6f);
+	float dx = a->pos.x - b->pos.x, dy = a->pos.y - b->pos.y;
+
+	return a->vertical == b->vertical && fabsf(a->distance - b->distance) <= bound && sqrtf(dx*dx + dy*dy) <= bound;
+}
+
+/**
+  * @brief  Compares the rays of a pose
+  * @param  fixedRays : The rays of castRays()
+  * @param  floatRays : The rays of castRaysFloat()
+  * @param  count : The number of rays
+  * @param  m : The map
+  * @param  stats : Where the comparison is added
+  */
+static void compare(const Ray *fixedRays, const Ray *floatRays, int count, Map *m, Stats *stats)
+{
+	for(int i = 0; i < count; i++)
+	{
+		const Ray *a = &fixedRays[i], *b = &floatRays[i];
+		bool aHit = a->distance < RAYCAST_NO_HIT, bHit = b->distance < RAYCAST_NO_HIT;
+
+		stats->rays++;
+		if(aHit && !(mapFlagsAt(m, a->pos.x, a->pos.y) & MATERIAL_OPAQUE))
+			stats->outside++;
+		if(aHit && bHit && a->vertical != b->vertical)
+			stats->vertical++;
+
+		float error = fabsf(a->distance - b->distance);
+		if(aHit == bHit && error <= MATCH_PIXELS && fabsf(a->pos.x - b->pos.x) <= MATCH_PIXELS
+				&& fabsf(a->pos.y - b->pos.y) <= MATCH_PIXELS)
+			continue;
+
+		stats->mismatches++;
+		if(aHit && bHit && angleExplains(a, b))
+		{
+			stats->grazing++;
+			if(error / b->distance > stats->maxError)
+				stats->maxError = error / b->distance;
+		}
+		else if(aHit && bHit && (cornerDistance(a->pos) < CORNER_PIXELS || cornerDistance(b->pos) < CORNER_PIXELS))
+			stats->corners++;
+		else
+		{
+			stats->unexplained++;
+			fprintf(stderr, "map %d: ray %d at %.5f rad: castRays() %.3f (%.3f, %.3f) %d, castRaysFloat() %.3f (%.3f, %.3f) %d\n",
+					m->index, i, a->angle, a->distance, a->pos.x, a->pos.y, a->vertical, b->distance, b->pos.x, b->pos.y, b->vertical);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	long poses = argc > 1 ? atol(argv[1]) : POSES;
+	uint32_t seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+	Stats total = { 0 };
+	static Ray floatRays[MAX_RAYS];
+
+	importMaps();
+	raycastInit();
+	printf("%-4s %9s %9s %8s %7s %12s %9s %8s\n", "map", "rays", "mismatch", "grazing", "corner", "unexplained", "vertical", "outside");
+
+	for(int index = 0; index < MAP_COUNT; index++)
+	{
+		Map m;
+		Stats stats = { 0 };
+		uint32_t random = (seed + index) * 0x9E3779B9u;
+		random = random != 0 ? random : 1;
+
+		loadMap(&m, index);
+		for(long p = 0; p < poses; p++)
+		{
+			float x, y;
+			do
+			{
+				x = randomUnit(&random) * m.mapBlockX * MAP_BLOCK_SIZE;
+				y = randomUnit(&random) * m.mapBlockY * MAP_BLOCK_SIZE;
+			} while(mapFlagsAt(&m, x, y) & MATERIAL_OPAQUE);
+			float angle = randomUnit(&random) * 2 * (float)M_PI;
+
+			int count;
+			const Ray *rays;
+			castRaysFloat(x, y, angle, &m);
+			rays = getRays(&count);
+			for(int i = 0; i < count; i++)
+				floatRays[i] = rays[i];
+			castRays(x, y, angle, &m);
+			rays = getRays(&count);
+			compare(rays, floatRays, count, &m, &stats);
+		}
+
+		printf("%-4d %9ld %9ld %8ld %7ld %12ld %9ld %8ld\n", index, stats.rays, stats.mismatches, stats.grazing,
+				stats.corners, stats.unexplained, stats.vertical, stats.outside);
+		total.rays += stats.rays;
+		total.mismatches += stats.mismatches;
+		total.grazing += stats.grazing;
+		total.corners += stats.corners;
+		total.unexplained += stats.unexplained;
+		total.vertical += stats.vertical;
+		total.outside += stats.outside;
+		if(stats.maxError > total.maxError)
+			total.maxError = stats.maxError;
+	}
+
+	double mismatchPpm = total.mismatches * 1e6 / total.rays;
+	double cornerPpm = total.corners * 1e6 / total.rays, verticalPpm = total.vertical * 1e6 / total.rays;
+	printf("mismatch %.1f ppm (max %d), corners %.1f ppm (max %d), vertical %.1f ppm (max %d), largest grazing error %.2f%%\n",
+			mismatchPpm, MISMATCH_PPM, cornerPpm, CORNER_PPM, verticalPpm, VERTICAL_PPM, total.maxError * 100);
+
+	if(mismatchPpm > MISMATCH_PPM || cornerPpm > CORNER_PPM || verticalPpm > VERTICAL_PPM || total.unexplained > 0 || total.outside > 0)
+	{
+		fprintf(stderr, "the ray caster is out of the tolerance of raycast.h\n");
+		return 1;
+	}
+	return 0;
+}
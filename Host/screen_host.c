@@ -0,0 +1,152 @@
+/*
+ * screen_host.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "host.h"
+#include "render/vram.h"
+#include <stdio.h>
+#include <string.h>
+
+//instance of the screen that gets initialized and then returned by ct_screen_init()
+Screen *screen;
+static Screen hostScreen;
+
+/**
+  * @brief  Allocates the frame buffers in the heap
+  * @return A Screen pointer referencing the screen that has just been initialized
+  */
+Screen* ct_screen_init() {
+	screen = &hostScreen;
+	memset(screen, 0, sizeof(Screen));
+	screen->width = HOST_SCREEN_WIDTH;
+	screen->height = HOST_SCREEN_HEIGHT;
+	for(int i = 0; i < SCREEN_MAX_BUFFERS; i++)
+	{
+		screen->addr[i] = (uintptr_t)vramAlloc(screen->width * screen->height * PIXEL_BYTES);
+		memset((void*)screen->addr[i], 0, screen->width * screen->height * PIXEL_BYTES);
+		screen->state[i] = BUFFER_FREE;
+	}
+	screen->buffers = SCREEN_DEFAULT_BUFFERS;
+	screen->requested_buffers = SCREEN_DEFAULT_BUFFERS;
+	screen->front = 0;
+	screen->state[0] = BUFFER_DISPLAYED;
+	screen->back = SCREEN_NO_BUFFER;
+	screen->pending = SCREEN_NO_BUFFER;
+	screen->stats.start = xTaskGetTickCount();
+	return screen;
+}
+
+/**
+  * @param  s : The Screen used to display the game
+  * @return the pointer to the back buffer of the display
+  */
+pixel_t* ct_screen_backbuffer_ptr(Screen *screen) {
+	return (pixel_t*)(screen->addr[screen->back]);
+}
+
+/**
+  * @brief  There is no CLUT on the host: L8 pixels are converted with pixelToArgb() when dumped
+  * @param  layer : The index of the layer
+  */
+void ct_screen_load_clut(uint32_t layer) {
+	(void)layer;
+}
+
+/**
+  * @param  s : The Screen used to display the game
+  * @param  buffers : 2 for double buffering, 3 for triple buffering
+  */
+void ct_screen_set_buffering(Screen *screen, uint32_t buffers) {
+	if(buffers >= 2 && buffers <= SCREEN_MAX_BUFFERS)
+		screen->requested_buffers = buffers;
+}
+
+/**
+  * @brief  Displays the back buffer straight away
+  * @param  s : The Screen used to display the game
+  */
+void ct_screen_flip_buffers(Screen *screen) {
+	ct_screen_wait_backbuffer(screen);
+
+	screen->state[screen->front] = BUFFER_FREE;
+	screen->front = screen->back;
+	screen->state[screen->front] = BUFFER_DISPLAYED;
+	screen->back = SCREEN_NO_BUFFER;
+	screen->stats.presented++;
+}
+
+/**
+  * @brief  Gets a free buffer to draw the next frame into, it does nothing if the back buffer has already been got
+  * @note   No frame is ever waiting to be displayed, so a free buffer is always available.
+  * @param  s : The Screen used to display the game
+  */
+void ct_screen_wait_backbuffer(Screen *screen) {
+	if(screen->back != SCREEN_NO_BUFFER)
+		return;
+
+	screen->buffers = screen->requested_buffers;
+	for(uint32_t i = 0; i < screen->buffers; i++)
+		if(screen->state[i] == BUFFER_FREE)
+		{
+			screen->state[i] = BUFFER_DRAWING;
+			screen->back = i;
+			return;
+		}
+}
+
+/**
+  * @param  s : The Screen used to display the game
+  * @return 0, a frame is displayed as soon as it is submitted
+  */
+uint32_t ct_screen_present_latency_us(Screen *screen) {
+	(void)screen;
+	return 0;
+}
+
+/**
+  * @param  s : The Screen used to display the game
+  * @param  stats : Where the counters are copied
+  */
+void ct_screen_get_stats(Screen *screen, ScreenStats *stats) {
+	*stats = screen->stats;
+}
+
+/**
+  * @param  s : The Screen used to display the game
+  */
+void ct_screen_reset_stats(Screen *screen) {
+	memset(&screen->stats, 0, sizeof(ScreenStats));
+	screen->stats.start = xTaskGetTickCount();
+}
+
+/**
+  * @brief  There is no LTDC interrupt on the host
+  */
+void ct_screen_irq_handler(void) {
+}
+
+/**
+  * @brief  Writes the buffer on display, the last flipped one, as a binary PPM image
+  * @param  s : The Screen used to display the game
+  * @param  path : The path of the image
+  * @return 0 on success, -1 if the file can't be written
+  */
+int hostDumpPpm(Screen *screen, const char *path) {
+	FILE *f = fopen(path, "wb");
+	if(f == NULL)
+		return -1;
+
+	const pixel_t *pixels = (const pixel_t*)screen->addr[screen->front];
+	fprintf(f, "P6\n%lu %lu\n255\n", (unsigned long)screen->width, (unsigned long)screen->height);
+	for(uint32_t i = 0; i < screen->width * screen->height; i++)
+	{
+		uint32_t argb = pixelToArgb(pixels[i]);
+		uint8_t rgb[3] = { argb >> 16, argb >> 8, argb };
+		fwrite(rgb, 1, sizeof(rgb), f);
+	}
+
+	return fclose(f) == 0 ? 0 : -1;
+}
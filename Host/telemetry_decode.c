@@ -0,0 +1,112 @@
+/*
+ * telemetry_decode.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+/*
+ * Decoder of the telemetry stream of serial/telemetry.h: it turns a capture into CSV, one file per packet type.
+ *
+ * Usage: telemetry_decode <input> [frames.csv] [tasks.csv]
+ * The input is a capture file, - for the standard input, or a serial port or pty which is switched to raw
+ * mode and read until it is closed or the tool is interrupted. The frame packets are written as CSV to
+ * frames.csv, or to the standard output, the task packets to tasks.csv when it is given. The count of the
+ * decoded and dropped packets is printed on the standard error at the end.
+ */
+
+#include "serial/telemetry.h"
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stop;
+
+static void onSignal(int sig)
+{
+	(void)sig;
+	stop = 1;
+}
+
+/**
+  * @brief  Switches a terminal to raw mode: no line editing, no echo, no translation of line endings
+  */
+static void makeRaw(FILE *in)
+{
+	struct termios t;
+	int fd = fileno(in);
+
+	if(!isatty(fd) || tcgetattr(fd, &t) != 0)
+		return;
+	cfmakeraw(&t);
+	tcsetattr(fd, TCSANOW, &t);
+}
+
+static void writeFrame(FILE *out, const TelemetryFrame *f)
+{
+	fprintf(out, "%u,%u,%u,%u,%u,%u,%u,%.2f,%.2f,%.4f,%u,%u,%u,%u,%u,%u,%u\n",
+			f->frame, f->timeMs, f->frameUs, f->castUs, f->wallsUs, f->hudUs, f->flipUs, f->x, f->y, f->angle,
+			f->map, f->rays, f->vertical, f->misses, f->minDistance, f->avgDistance, f->maxDistance);
+}
+
+static void writeTasks(FILE *out, const TelemetryTasks *t)
+{
+	for(int i = 0; i < t->count; i++)
+		fprintf(out, "%u,%u,%s,%u.%u,%u\n", t->timeMs, t->task[i].number, t->task[i].name,
+				t->task[i].cpuPermille / 10, t->task[i].cpuPermille % 10, t->task[i].stackFree);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in, *frames = stdout, *tasks = NULL;
+	TelemetryDecoder decoder;
+	TelemetryPacket packet;
+	int c;
+
+	if(argc < 2)
+	{
+		fprintf(stderr, "usage: %s <capture|serial port|-> [frames.csv] [tasks.csv]\n", argv[0]);
+		return 2;
+	}
+
+	in = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
+	if(argc > 2)
+		frames = fopen(argv[2], "w");
+	if(argc > 3)
+		tasks = fopen(argv[3], "w");
+	if(in == NULL || frames == NULL || (argc > 3 && tasks == NULL))
+	{
+		perror("telemetry_decode");
+		return 1;
+	}
+
+	makeRaw(in);
+	//without SA_RESTART a signal interrupts the read of a quiet serial port
+	struct sigaction action = { .sa_handler = onSignal };
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	fprintf(frames, "frame,time_ms,frame_us,cast_us,walls_us,hud_us,flip_us,x,y,angle,map,rays,vertical,misses,min_distance,avg_distance,max_distance\n");
+	if(tasks != NULL)
+		fprintf(tasks, "time_ms,task,name,cpu_percent,free_stack_words\n");
+
+	telemetryDecoderInit(&decoder);
+	while(!stop && (c = fgetc(in)) != EOF)
+	{
+		if(!telemetryDecode(&decoder, (uint8_t)c, &packet))
+			continue;
+		if(packet.type == TELEMETRY_FRAME)
+			writeFrame(frames, &packet.frame);
+		else if(packet.type == TELEMETRY_TASKS && tasks != NULL)
+			writeTasks(tasks, &packet.tasks);
+	}
+
+	fprintf(stderr, "%u packets, %u CRC errors, %u malformed\n", decoder.packets, decoder.crcErrors, decoder.malformed);
+	if(frames != stdout)
+		fclose(frames);
+	if(tasks != NULL)
+		fclose(tasks);
+	return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * vram_host.c
+ *
+ *  Created on: 17 ott 2026
+ *      Author: fabio
+ */
+
+#include "render/vram.h"
+#include <stdlib.h>
+
+//the host has no SDRAM to track: the blocks come from the heap and are never freed, as on the board
+static uint32_t vramUsed;
+
+/**
+  * @brief  Allocates a block of the heap in place of the SDRAM, the block can't be freed
+  * @param  size : The size of the block in bytes
+  * @return the VRAM_ALIGN aligned block, NULL if the heap is full
+  */
+void* vramAlloc(uint32_t size)
+{
+	size = (size + VRAM_ALIGN - 1) & ~(uint32_t)(VRAM_ALIGN - 1);
+	void *block = aligned_alloc(VRAM_ALIGN, size);
+	if(block != NULL)
+		vramUsed += size;
+	return block;
+}
+
+/**
+  * @return the SDRAM bytes that would still be available on the board
+  */
+uint32_t vramFree(void)
+{
+	//SDRAM_DEVICE_SIZE of the STM32F769I-DISCO
+	const uint32_t sdramSize = 0x1000000;
+	return vramUsed < sdramSize ? sdramSize - vramUsed : 0;
+}